@@ -0,0 +1,251 @@
+#include "decimal.h"
+
+static const unsigned int kPow10U32[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+
+// A share's claim on one leftover unit. The key holds the leading 64 bits
+// of the remainder relative to the weight sum and settles most comparisons;
+// equal keys fall back to the full remainder.
+typedef struct {
+  unsigned long long key;
+  size_t index;
+  wide_int remainder;
+} allocation_rank;
+
+// Weight i as an integer at the common weight scale.
+static void scaled_weight(const decimal *weight, int scale, wide_int *result) {
+  wide_from_decimal(weight, result);
+  wide_mul_pow10(result, scale - get_scale(weight));
+}
+
+// The caller guarantees that the product fits in a wide_int.
+static void mul_units(const wide_int *weight, const wide_int *units,
+                      wide_int *product) {
+  wide_zero(product);
+  for (int i = 0; i < 3; i++) {
+    unsigned long long carry = 0ull;
+    for (int j = 0; i + j < WIDE_WORDS; j++) {
+      unsigned long long t = (unsigned long long)units->words[i] *
+                                 weight->words[j] +
+                             product->words[i + j] + carry;
+      product->words[i + j] = (unsigned int)t;
+      carry = t >> 32;
+    }
+  }
+}
+
+// remainder < W < 2^(shift + 64), so remainder >> shift fits in 64 bits.
+static unsigned long long remainder_key(const wide_int *remainder,
+                                        int shift) {
+  int word = shift / 32;
+  int bit = shift % 32;
+  unsigned long long parts[3];
+  for (int i = 0; i < 3; i++) {
+    parts[i] = word + i < WIDE_WORDS ? remainder->words[word + i] : 0u;
+  }
+  unsigned long long key = ((parts[1] << 32) | parts[0]) >> bit;
+  if (bit != 0) key |= parts[2] << (64 - bit);
+  return key;
+}
+
+static int rank_before(const allocation_rank *a, const allocation_rank *b) {
+  int order = 0;
+  if (a->key != b->key) order = a->key > b->key ? 1 : -1;
+  else order = wide_compare(&a->remainder, &b->remainder);
+  return order > 0 || (order == 0 && a->index < b->index);
+}
+
+static void swap_ranks(allocation_rank *a, allocation_rank *b) {
+  allocation_rank t = *a;
+  *a = *b;
+  *b = t;
+}
+
+// Moves the `top` best ranks to the front in expected linear time.
+static void select_top(allocation_rank *ranks, size_t count, size_t top) {
+  size_t low = 0;
+  size_t high = count;
+  while (high - low > 1) {
+    size_t mid = low + (high - low) / 2;
+    size_t last = high - 1;
+    // Median of three as the pivot, parked at the end of the range.
+    if (rank_before(&ranks[mid], &ranks[low]))
+      swap_ranks(&ranks[mid], &ranks[low]);
+    if (rank_before(&ranks[last], &ranks[low]))
+      swap_ranks(&ranks[last], &ranks[low]);
+    if (rank_before(&ranks[mid], &ranks[last]))
+      swap_ranks(&ranks[mid], &ranks[last]);
+
+    size_t store = low;
+    for (size_t i = low; i < last; i++) {
+      if (rank_before(&ranks[i], &ranks[last]))
+        swap_ranks(&ranks[i], &ranks[store++]);
+    }
+    swap_ranks(&ranks[store], &ranks[last]);
+
+    if (top < store)
+      high = store;
+    else if (top > store)
+      low = store + 1;
+    else
+      low = high;
+  }
+}
+
+static void increment_mantissa(decimal *value) {
+  for (int i = 0; i < 3; i++) {
+    value->bits[i] = (int)((unsigned int)value->bits[i] + 1u);
+    if (value->bits[i] != 0) break;
+  }
+}
+
+// Total in units of 10^-scale; fails unless it is exact at that scale.
+static int total_units(decimal total, int scale, wide_int *units) {
+  int flag = ARITHMETIC_OK;
+  wide_from_decimal(&total, units);
+  for (int digits = get_scale(&total) - scale;
+       digits > 0 && flag == ARITHMETIC_OK; digits -= 9) {
+    if (wide_div_u32(units, kPow10U32[digits > 9 ? 9 : digits]) != 0u)
+      flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK) {
+    wide_mul_pow10(units, scale - get_scale(&total));
+    if (!wide_fits_u96(units)) flag = ARITHMETIC_BIG;
+  }
+  return flag;
+}
+
+// Sums the weights at their largest scale. Returns that scale through
+// *weight_scale and the bit length of the largest scaled weight.
+static int weight_sum(const decimal *weights, size_t count, wide_int *sum,
+                      int *weight_scale, int *bits) {
+  int flag = ARITHMETIC_OK;
+  *weight_scale = 0;
+  *bits = 0;
+  wide_zero(sum);
+  for (size_t i = 0; i < count && flag == ARITHMETIC_OK; i++) {
+    if (get_sign(&weights[i]) && !is_zero(weights[i]))
+      flag = ARITHMETIC_BAD_INPUT;
+    else if (get_scale(&weights[i]) > *weight_scale)
+      *weight_scale = get_scale(&weights[i]);
+  }
+  for (size_t i = 0; i < count && flag == ARITHMETIC_OK; i++) {
+    wide_int weight;
+    scaled_weight(&weights[i], *weight_scale, &weight);
+    if (wide_bit_length(&weight) > *bits) *bits = wide_bit_length(&weight);
+    if (wide_add(sum, &weight) != 0u) flag = ARITHMETIC_BIG;
+  }
+  if (flag == ARITHMETIC_OK && wide_is_zero(sum))
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  return flag;
+}
+
+// Largest-remainder (Hamilton) apportionment: every share starts at
+// floor(T * w_i / W) units, and the units still missing from T go one each
+// to the shares with the largest remainders, ties to the earlier index.
+// The shares therefore always add up to the total exactly.
+static int allocate_shares(decimal total, const decimal *weights,
+                           size_t count, int scale, decimal_arena *arena,
+                           decimal *shares) {
+  int flag = ARITHMETIC_OK;
+  int weight_scale = 0;
+  int weight_bits = 0;
+  wide_int units;
+  wide_int sum;
+  wide_zero(&sum);
+
+  if (scale < 0 || scale > 28 ||
+      (count > 0 && (weights == NULL || shares == NULL))) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = total_units(total, scale, &units);
+  }
+  if (flag == ARITHMETIC_OK)
+    flag = weight_sum(weights, count, &sum, &weight_scale, &weight_bits);
+  if (flag == ARITHMETIC_OK &&
+      wide_bit_length(&units) + weight_bits > WIDE_WORDS * 32)
+    flag = ARITHMETIC_BIG;
+
+  allocation_rank *ranks = NULL;
+  size_t ranked = 0;
+  wide_int assigned;
+  wide_zero(&assigned);
+  int shift = wide_bit_length(&sum) - 64;
+  if (shift < 0) shift = 0;
+
+  for (size_t i = 0; i < count && flag == ARITHMETIC_OK; i++) {
+    wide_int weight;
+    wide_int product;
+    wide_int quotient;
+    wide_int remainder;
+    scaled_weight(&weights[i], weight_scale, &weight);
+    mul_units(&weight, &units, &product);
+    wide_divmod(&product, &sum, &quotient, &remainder);
+    wide_add(&assigned, &quotient);
+
+    shares[i].bits[0] = (int)quotient.words[0];
+    shares[i].bits[1] = (int)quotient.words[1];
+    shares[i].bits[2] = (int)quotient.words[2];
+    shares[i].bits[3] = 0;
+
+    if (!wide_is_zero(&remainder)) {
+      if (ranks == NULL)
+        ranks = decimal_arena_alloc(arena, (count - i) * sizeof(*ranks));
+      if (ranks == NULL) {
+        // No memory to rank remainders; there is no partial answer.
+        flag = ARITHMETIC_BIG;
+      } else {
+        ranks[ranked].key = remainder_key(&remainder, shift);
+        ranks[ranked].index = i;
+        ranks[ranked].remainder = remainder;
+        ranked++;
+      }
+    }
+  }
+
+  if (flag == ARITHMETIC_OK) {
+    // T - sum(floor) equals sum(remainder) / W, which is below the number
+    // of non-zero remainders.
+    wide_sub(&units, &assigned);
+    size_t leftover = (size_t)(((unsigned long long)units.words[1] << 32) |
+                               units.words[0]);
+    select_top(ranks, ranked, leftover);
+    for (size_t i = 0; i < leftover; i++) {
+      increment_mantissa(&shares[ranks[i].index]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      set_scale(&shares[i], scale);
+      if (!is_zero(shares[i])) set_sign(&shares[i], get_sign(&total));
+    }
+  }
+  return flag;
+}
+
+int decimal_allocate(decimal total, const decimal *weights, size_t count,
+                     int scale, decimal *shares) {
+  decimal_arena arena;
+  decimal_arena_init(&arena, 0);
+  int flag = allocate_shares(total, weights, count, scale, &arena, shares);
+  decimal_arena_release(&arena);
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Same as decimal_allocate, with the remainder ranks taken from `arena` and
+// given back before returning, so repeated calls reuse its blocks instead
+// of calling malloc.
+int decimal_allocate_arena(decimal total, const decimal *weights,
+                           size_t count, int scale, decimal_arena *arena,
+                           decimal *shares) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (arena != NULL) {
+    decimal_arena_mark mark = decimal_arena_get_mark(arena);
+    flag = allocate_shares(total, weights, count, scale, arena, shares);
+    decimal_arena_rewind(arena, mark);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
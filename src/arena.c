@@ -0,0 +1,113 @@
+// <stdlib.h> declares its own div(); keep it out of the way of ours.
+#define div stdlib_div
+#include <stdlib.h>
+#undef div
+
+#include "decimal.h"
+
+#define ARENA_DEFAULT_BLOCK 4096
+#define ARENA_ALIGN 16
+
+struct decimal_arena_block {
+  decimal_arena_block *next;
+  size_t size;
+  size_t used;
+  // Keeps the data that follows aligned to ARENA_ALIGN.
+  _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+void decimal_arena_init(decimal_arena *arena, size_t block_size) {
+  if (arena != NULL) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size != 0 ? block_size : ARENA_DEFAULT_BLOCK;
+    arena->capacity = 0;
+  }
+}
+
+static decimal_arena_block *new_block(decimal_arena *arena, size_t size) {
+  if (size < arena->block_size) size = arena->block_size;
+  decimal_arena_block *block = malloc(sizeof(*block) + size);
+  if (block != NULL) {
+    block->size = size;
+    block->used = 0;
+    arena->capacity += size;
+  }
+  return block;
+}
+
+// Bump allocation from the current block. When it is full the next
+// retained block is tried, so after a reset the same workload reuses the
+// blocks of the previous pass instead of calling malloc.
+void *decimal_arena_alloc(decimal_arena *arena, size_t size) {
+  void *result = NULL;
+  if (arena != NULL) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    decimal_arena_block *block = arena->current;
+    while (block != NULL && block->size - block->used < size &&
+           block->next != NULL) {
+      block = block->next;
+      block->used = 0;
+    }
+    if (block == NULL || block->size - block->used < size) {
+      decimal_arena_block *fresh = new_block(arena, size);
+      if (fresh != NULL) {
+        if (block == NULL) {
+          fresh->next = arena->first;
+          arena->first = fresh;
+        } else {
+          fresh->next = block->next;
+          block->next = fresh;
+        }
+      }
+      block = fresh;
+    }
+    if (block != NULL) {
+      arena->current = block;
+      result = block->data + block->used;
+      block->used += size;
+    }
+  }
+  return result;
+}
+
+// Everything allocated so far is released at once; the blocks are kept.
+void decimal_arena_reset(decimal_arena *arena) {
+  if (arena != NULL) {
+    arena->current = arena->first;
+    if (arena->first != NULL) arena->first->used = 0;
+  }
+}
+
+// Everything allocated after decimal_arena_mark is released; earlier
+// allocations stay valid. Library functions that borrow a caller's arena
+// for scratch space rewind it before returning.
+decimal_arena_mark decimal_arena_get_mark(const decimal_arena *arena) {
+  decimal_arena_mark mark = {NULL, 0};
+  if (arena != NULL && arena->current != NULL) {
+    mark.block = arena->current;
+    mark.used = arena->current->used;
+  }
+  return mark;
+}
+
+void decimal_arena_rewind(decimal_arena *arena, decimal_arena_mark mark) {
+  if (arena != NULL && mark.block == NULL) {
+    decimal_arena_reset(arena);
+  } else if (arena != NULL) {
+    arena->current = mark.block;
+    mark.block->used = mark.used;
+  }
+}
+
+void decimal_arena_release(decimal_arena *arena) {
+  if (arena != NULL) {
+    decimal_arena_block *block = arena->first;
+    while (block != NULL) {
+      decimal_arena_block *next = block->next;
+      free(block);
+      block = next;
+    }
+    decimal_arena_init(arena, arena->block_size);
+  }
+}
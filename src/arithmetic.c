@@ -1,48 +1,163 @@
 #include "decimal.h"
 
-int add(decimal value_1, decimal value_2, decimal *result) {
-  int flag = ARITHMETIC_OK;
-  int sub = 0;
-  if (result == NULL) return ARITHMETIC_BAD_INPUT;
-
-  if (is_zero(value_1))
-    *result = value_2;
-  else if (is_zero(value_2))
-    *result = value_1;
-  else {
-    normalize(&value_1, &value_2);
-    decimal_zero(result);
+static const unsigned int kSignMask = 0x80000000u;
+static const unsigned int kScaleMask = 0x00FF0000u;
 
-    int sign1 = get_sign(&value_1);
-    int sign2 = get_sign(&value_2);
+static unsigned long long low_u64(const decimal *value) {
+  return (unsigned long long)(unsigned int)value->bits[0] |
+         ((unsigned long long)(unsigned int)value->bits[1] << 32);
+}
 
-    if (sign1 == sign2) {
-      flag = add_abs(value_1, value_2, result);
-      if (flag == ARITHMETIC_OK) {
-        set_sign(result, sign1);
-      }
+#ifdef DECIMAL_HAVE_INT128
+static inline decimal_u128 mantissa_u128(const decimal *value) {
+  return (decimal_u128)low_u64(value) |
+         ((decimal_u128)(unsigned int)value->bits[2] << 64);
+}
+
+// The 192-bit product of two mantissas as six words, from three 64x64-bit
+// multiplies and one 32x32-bit multiply.
+void mul_words(const decimal *value_1, const decimal *value_2,
+               unsigned int *words) {
+  unsigned long long a_low = low_u64(value_1);
+  unsigned long long b_low = low_u64(value_2);
+  unsigned long long a_high = (unsigned int)value_1->bits[2];
+  unsigned long long b_high = (unsigned int)value_2->bits[2];
+  decimal_u128 low = (decimal_u128)a_low * b_low;
+  decimal_u128 middle = (decimal_u128)a_low * b_high +
+                        (decimal_u128)a_high * b_low + (low >> 64);
+  // Bits 128 and up of a 192-bit product, so this cannot wrap.
+  unsigned long long top = a_high * b_high + (unsigned long long)(middle >> 64);
+  words[0] = (unsigned int)low;
+  words[1] = (unsigned int)((unsigned long long)low >> 32);
+  words[2] = (unsigned int)middle;
+  words[3] = (unsigned int)((unsigned long long)middle >> 32);
+  words[4] = (unsigned int)top;
+  words[5] = (unsigned int)(top >> 32);
+}
+#else
+void mul_words(const decimal *value_1, const decimal *value_2,
+               unsigned int *words) {
+  for (int i = 0; i < 6; i++) words[i] = 0u;
+  for (int i = 0; i < 3; i++) {
+    unsigned long long carry = 0ull;
+    for (int j = 0; j < 3; j++) {
+      unsigned long long t =
+          (unsigned long long)(unsigned int)value_1->bits[i] *
+              (unsigned int)value_2->bits[j] +
+          words[i + j] + carry;
+      words[i + j] = (unsigned int)t;
+      carry = t >> 32;
+    }
+    words[i + 3] = (unsigned int)carry;
+  }
+}
+#endif
+
+// Equal scales: the sum is formed directly on the 96-bit mantissas with one
+// 64-bit and one 32-bit step and no rescaling; a negative difference is
+// turned around by mask instead of a magnitude compare. negate_2 is
+// kSignMask for subtraction. Returns 0 when the scales differ or a
+// same-sign sum carries out of 96 bits, which needs rounding.
+static inline int add_small(decimal value_1, decimal value_2,
+                            unsigned int negate_2, decimal *result) {
+  unsigned int meta_1 = (unsigned int)value_1.bits[3];
+  unsigned int meta_2 = (unsigned int)value_2.bits[3] ^ negate_2;
+  int handled = ((meta_1 ^ meta_2) & kScaleMask) == 0u;
+
+  if (handled) {
+    unsigned long long a = low_u64(&value_1);
+    unsigned long long b = low_u64(&value_2);
+    unsigned long long a_high = (unsigned int)value_1.bits[2];
+    unsigned long long b_high = (unsigned int)value_2.bits[2];
+    unsigned long long low;
+    unsigned long long high;
+    unsigned int sign = meta_1 & kSignMask;
+
+    if (((meta_1 ^ meta_2) & kSignMask) == 0u) {
+      low = a + b;
+      high = a_high + b_high + (low < a);
+      handled = (high >> 32) == 0ull;
     } else {
-      int cmp = compare_abs(value_1, value_2);
-      if (cmp == 0) {
-        decimal_zero(result);
-      } else if (cmp > 0) {
-        sub = 1;
-        flag = sub_abs(value_1, value_2, result);
-      } else {
-        sub = 2;
-        flag = sub_abs(value_2, value_1, result);
-      }
+      low = a - b;
+      high = a_high - b_high - (a < b);
+      unsigned long long mask = 0ull - (high >> 63);
+      unsigned long long carry = mask & (low == 0ull);
+      low = (low ^ mask) - mask;
+      high = ((high ^ mask) + (carry & 1ull)) & 0xFFFFFFFFull;
+      sign ^= (unsigned int)mask & kSignMask;
+      sign &= 0u - (unsigned int)((low | high) != 0ull);
     }
-    if (flag == ARITHMETIC_OK && sub == 1) {
-      set_sign(result, sign1);
-    } else if (flag == ARITHMETIC_OK && sub == 2) {
-      set_sign(result, sign2);
+
+    if (handled) {
+      result->bits[0] = (int)(unsigned int)low;
+      result->bits[1] = (int)(unsigned int)(low >> 32);
+      result->bits[2] = (int)(unsigned int)high;
+      result->bits[3] = (int)((meta_1 & kScaleMask) | sign);
     }
   }
-  if (flag == ARITHMETIC_OK) {
-    set_scale(result, get_scale(&value_1));
+
+  return handled;
+}
+
+// General path: the lower-scale operand is rescaled into a 256-bit
+// intermediate, the exact sum is formed there and then rounded half-even
+// back into 96 bits, lowering the scale only as far as needed.
+static int add_wide(decimal value_1, decimal value_2, unsigned int negate_2,
+                    decimal *result) {
+  int scale_1 = get_scale(&value_1);
+  int scale_2 = get_scale(&value_2);
+  int sign_1 = get_sign(&value_1);
+  int sign_2 = get_sign(&value_2) ^ (negate_2 != 0u);
+  int scale = scale_1 > scale_2 ? scale_1 : scale_2;
+  int sign = sign_1;
+  wide_int a;
+  wide_int b;
+
+  DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_ADD_RESCALE);
+  wide_from_decimal(&value_1, &a);
+  wide_from_decimal(&value_2, &b);
+  wide_mul_pow10(&a, scale - scale_1);
+  wide_mul_pow10(&b, scale - scale_2);
+
+  if (sign_1 == sign_2) {
+    wide_add(&a, &b);
+  } else if (wide_sub(&a, &b)) {
+    wide_negate(&a);
+    sign = sign_2;
+  }
+  if (wide_is_zero(&a)) sign = 0;
+
+  return wide_to_decimal(&a, scale, sign, result);
+}
+
+// add, sub and mul on a non-NULL result without recording a failure in
+// the status context, for callers that handle ARITHMETIC_BIG themselves.
+int add_unrecorded(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (!add_small(value_1, value_2, 0u, result))
+    flag = add_wide(value_1, value_2, 0u, result);
+  return flag;
+}
+
+int sub_unrecorded(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (!add_small(value_1, value_2, kSignMask, result))
+    flag = add_wide(value_1, value_2, kSignMask, result);
+  return flag;
+}
+
+int add(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_BEGIN();
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = add_unrecorded(value_1, value_2, result);
   }
 
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_ADD, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
   return flag;
 }
 
@@ -67,49 +182,16 @@ int add_abs(decimal value_1, decimal value_2, decimal *result) {
 
 int sub(decimal value_1, decimal value_2, decimal *result) {
   int flag = ARITHMETIC_OK;
-  int sub = 0;
-  if (result == NULL) return ARITHMETIC_BAD_INPUT;
-
-  if (is_zero(value_1)) {
-    *result = value_2;
-    set_sign(result, !get_sign(&value_2));
-  } else if (is_zero(value_2)) {
-    *result = value_1;
-  } else {
-    normalize(&value_1, &value_2);
-    decimal_zero(result);
-
-    int sign1 = get_sign(&value_1);
-    int sign2 = get_sign(&value_2);
+  DECIMAL_INSTRUMENT_BEGIN();
 
-    if (sign1 != sign2) {
-      flag = add_abs(value_1, value_2, result);
-      if (flag == ARITHMETIC_OK) {
-        set_sign(result, sign1);
-      }
-    } else {
-      int cmp = compare_abs(value_1, value_2);
-      if (cmp == 0) {
-        decimal_zero(result);
-      } else if (cmp > 0) {
-        sub = 1;
-        flag = sub_abs(value_1, value_2, result);
-      } else {
-        sub = 2;
-        flag = sub_abs(value_2, value_1, result);
-      }
-    }
-    if (flag == ARITHMETIC_OK && sub == 1) {
-      set_sign(result, sign1);
-    } else if (flag == ARITHMETIC_OK && sub == 2) {
-      set_sign(result, !sign1);
-    }
-  }
-
-  if (flag == ARITHMETIC_OK) {
-    set_scale(result, get_scale(&value_1));
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = sub_unrecorded(value_1, value_2, result);
   }
 
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_SUB, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
   return flag;
 }
 
@@ -145,21 +227,16 @@ void process_multiplication(unsigned long long *temp, int i, int j,
 
 int mul_abs(decimal value_1, decimal value_2, decimal *result) {
   int flag = ARITHMETIC_OK;
-  unsigned long long temp[6] = {0};
+  unsigned int words[6];
+  mul_words(&value_1, &value_2, words);
 
-  for (int i = 0; i < 3; i++) {
-    for (int j = 0; j < 3; j++) {
-      process_multiplication(temp, i, j, (unsigned int)value_1.bits[i],
-                                 (unsigned int)value_2.bits[j]);
-    }
-  }
-
-  if (temp[3] != 0 || temp[4] != 0 || temp[5] != 0) {
+  if ((words[3] | words[4] | words[5]) != 0u) {
+    DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_MUL_OVERFLOW);
     flag = ARITHMETIC_BIG;
   } else {
-    result->bits[0] = (int)temp[0];
-    result->bits[1] = (int)temp[1];
-    result->bits[2] = (int)temp[2];
+    result->bits[0] = (int)words[0];
+    result->bits[1] = (int)words[1];
+    result->bits[2] = (int)words[2];
   }
 
   return flag;
@@ -183,45 +260,98 @@ int handle_mul_scale(decimal *result, int scale1, int scale2) {
   return flag;
 }
 
+// The exact product needs up to 192 bits and a scale of up to 56. It is
+// rounded half-even back into 96 bits at a scale of at most 28, the same
+// way add_wide rounds a sum; a product that rounds to zero is a plain zero.
 int perform_multiplication(decimal value_1, decimal value_2,
                                decimal *result) {
-  int sign1 = get_sign(&value_1);
-  int sign2 = get_sign(&value_2);
-  int result_sign = sign1 ^ sign2;
+  int result_sign = get_sign(&value_1) ^ get_sign(&value_2);
+  int result_scale = get_scale(&value_1) + get_scale(&value_2);
+  wide_int product;
 
-  int flag = mul_abs(value_1, value_2, result);
+  wide_zero(&product);
+  mul_words(&value_1, &value_2, product.words);
+  if (!wide_fits_u96(&product))
+    DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_MUL_OVERFLOW);
 
-  if (flag == ARITHMETIC_OK) {
-    int scale1 = get_scale(&value_1);
-    int scale2 = get_scale(&value_2);
-    flag = handle_mul_scale(result, scale1, scale2);
+  int flag = wide_to_decimal(&product, result_scale, result_sign, result);
+  if (flag == ARITHMETIC_OK && is_zero(*result)) decimal_zero(result);
 
-    if (flag == ARITHMETIC_OK) {
-      set_sign(result, result_sign);
-    }
+  return flag;
+}
+
+// Product that fits in 96 bits at a scale of at most 28: the 96x96-bit
+// product is formed on the raw words and the result written directly, with
+// a zero product given scale 0 and sign 0 as the general path does. Returns
+// 0 when the product needs rounding.
+static inline int mul_small(decimal value_1, decimal value_2,
+                            decimal *result) {
+  unsigned int meta_1 = (unsigned int)value_1.bits[3];
+  unsigned int meta_2 = (unsigned int)value_2.bits[3];
+  unsigned int scale = (meta_1 & kScaleMask) + (meta_2 & kScaleMask);
+  unsigned int words[6];
+
+  mul_words(&value_1, &value_2, words);
+  int handled =
+      scale <= (28u << 16) && (words[3] | words[4] | words[5]) == 0u;
+
+  if (handled) {
+    unsigned int nonzero = 0u - (unsigned int)((words[0] | words[1] |
+                                                words[2]) != 0u);
+    result->bits[0] = (int)words[0];
+    result->bits[1] = (int)words[1];
+    result->bits[2] = (int)words[2];
+    result->bits[3] =
+        (int)((scale | ((meta_1 ^ meta_2) & kSignMask)) & nonzero);
   }
+  return handled;
+}
 
+static int mul_general(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_MUL_GENERAL);
+  decimal_zero(result);
+  if (!is_zero(value_1) && !is_zero(value_2)) {
+    flag = perform_multiplication(value_1, value_2, result);
+  }
+  return flag;
+}
+
+// Under DECIMAL_OPTION_REDUCE_MUL a product drops its trailing zeros, so
+// chained multiplications do not pile up scale. Integer products are left
+// alone without looking at the context.
+static inline void reduce_product(decimal *result) {
+  if (((unsigned int)result->bits[3] & kScaleMask) != 0u &&
+      (decimal_context_get()->options & DECIMAL_OPTION_REDUCE_MUL) != 0u)
+    decimal_reduce(*result, result);
+}
+
+int mul_unrecorded(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (!mul_small(value_1, value_2, result))
+    flag = mul_general(value_1, value_2, result);
+  if (flag == ARITHMETIC_OK) reduce_product(result);
   return flag;
 }
 
 int mul(decimal value_1, decimal value_2, decimal *result) {
   int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_BEGIN();
 
   if (result == NULL) {
     flag = ARITHMETIC_BAD_INPUT;
   } else {
-    decimal_zero(result);
-
-    if (is_zero(value_1) || is_zero(value_2)) {
-      decimal_zero(result);
-    } else {
-      flag = perform_multiplication(value_1, value_2, result);
-    }
+    flag = mul_unrecorded(value_1, value_2, result);
   }
 
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_MUL, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
   return flag;
 }
 
+static int divmod_wide(decimal value_1, decimal value_2, decimal *quotient,
+                       decimal *remainder);
+
 int is_divisor_zero(decimal value) { return is_zero(value); }
 
 int process_division_bit(decimal *quotient, decimal remainder,
@@ -249,14 +379,22 @@ int div_abs(decimal dividend, decimal divisor,
     return flag;
   }
 
+#ifdef DECIMAL_HAVE_INT128
+  // Both mantissas fit in 128 bits, so one hardware-assisted division
+  // replaces the shift-and-subtract loop below.
+  DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_DIV_STEP);
+  decimal_u128 quotient = mantissa_u128(&dividend) / mantissa_u128(&divisor);
+  result->bits[0] = (int)(unsigned int)quotient;
+  result->bits[1] = (int)(unsigned int)(quotient >> 32);
+  result->bits[2] = (int)(unsigned int)(quotient >> 64);
+#else
   decimal temp = divisor;
-  decimal counter;
-  decimal_zero(&counter);
-  counter.bits[0] = 1;
+  decimal counter = DECIMAL_ONE;
 
   while (compare_abs(temp, dividend) <= 0) {
     decimal prev_temp = temp;
     decimal prev_counter = counter;
+    DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_DIV_STEP);
 
     if (shift_left(&temp) || shift_left(&counter)) {
       temp = prev_temp;
@@ -267,6 +405,7 @@ int div_abs(decimal dividend, decimal divisor,
 
   decimal remainder = dividend;
   while (counter.bits[0] || counter.bits[1] || counter.bits[2]) {
+    DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_DIV_STEP);
     if (compare_abs(remainder, temp) >= 0) {
       sub_abs(remainder, temp, &remainder);
       add_abs(*result, counter, result);
@@ -274,6 +413,7 @@ int div_abs(decimal dividend, decimal divisor,
     shift_right(&temp);
     shift_right(&counter);
   }
+#endif
 
   return flag;
 }
@@ -307,35 +447,161 @@ int perform_division(decimal value_1, decimal value_2,
   int sign1 = get_sign(&value_1);
   int sign2 = get_sign(&value_2);
   int result_sign = sign1 ^ sign2;
+  int flag = ARITHMETIC_OK;
+  decimal aligned_1 = value_1;
+  decimal aligned_2 = value_2;
 
-  normalize(&value_1, &value_2);
-
-  int flag = div_abs(value_1, value_2, result);
+  normalize(&aligned_1, &aligned_2);
 
-  if (flag == ARITHMETIC_OK) {
-    set_sign(result, result_sign);
-    set_scale(result, 0);
+  if (get_scale(&aligned_1) != get_scale(&aligned_2)) {
+    // normalize stops short when a mantissa would overflow; the wide path
+    // aligns the scales exactly.
+    flag = divmod_wide(value_1, value_2, result, NULL);
+  } else {
+    flag = div_abs(aligned_1, aligned_2, result);
+    if (flag == ARITHMETIC_OK) {
+      set_sign(result, result_sign);
+      set_scale(result, 0);
+    }
   }
 
   return flag;
 }
 
+// The quotient of a non-zero divisor, shared by div and div_unchecked.
+static int divide(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  decimal_zero(result);
+  if (!is_zero(value_1)) flag = perform_division(value_1, value_2, result);
+  return flag;
+}
+
 int div(decimal value_1, decimal value_2, decimal *result) {
   int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_BEGIN();
 
   if (result == NULL) {
     flag = ARITHMETIC_BAD_INPUT;
   } else if (is_divisor_zero(value_2)) {
     flag = ARITHMETIC_DIV_BY_ZERO;
   } else {
-    decimal_zero(result);
+    flag = divide(value_1, value_2, result);
+  }
 
-    if (is_zero(value_1)) {
-      decimal_zero(result);
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_DIV, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// One wide division on both operands brought to the larger scale. The
+// remainder is below the unscaled operand, so it always fits in 96 bits;
+// only the quotient can overflow, and only when it was asked for.
+static int divmod_wide(decimal value_1, decimal value_2, decimal *quotient,
+                       decimal *remainder) {
+  int flag = ARITHMETIC_OK;
+  int scale_1 = get_scale(&value_1);
+  int scale_2 = get_scale(&value_2);
+  int sign_1 = get_sign(&value_1);
+  int scale = scale_1 > scale_2 ? scale_1 : scale_2;
+  wide_int a;
+  wide_int b;
+  wide_int q;
+  wide_int r;
+
+  wide_from_decimal(&value_1, &a);
+  wide_from_decimal(&value_2, &b);
+  wide_mul_pow10(&a, scale - scale_1);
+  wide_mul_pow10(&b, scale - scale_2);
+  wide_divmod(&a, &b, &q, &r);
+
+  if (quotient != NULL) {
+    if (!wide_fits_u96(&q)) {
+      flag = ARITHMETIC_BIG;
     } else {
-      flag = perform_division(value_1, value_2, result);
+      wide_to_decimal(&q, 0, 0, quotient);
+      if (!wide_is_zero(&a)) set_sign(quotient, sign_1 ^ get_sign(&value_2));
     }
   }
+  if (remainder != NULL && flag == ARITHMETIC_OK) {
+    wide_to_decimal(&r, scale, wide_is_zero(&r) ? 0 : sign_1, remainder);
+  }
+
+  return flag;
+}
+
+int decimal_divmod(decimal value_1, decimal value_2, decimal *quotient,
+                   decimal *remainder) {
+  int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_BEGIN();
+
+  if (quotient == NULL || remainder == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_divisor_zero(value_2)) {
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  } else {
+    flag = divmod_wide(value_1, value_2, quotient, remainder);
+  }
+
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_DIVMOD, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int decimal_mod(decimal value_1, decimal value_2, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  DECIMAL_INSTRUMENT_BEGIN();
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_divisor_zero(value_2)) {
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  } else {
+    flag = divmod_wide(value_1, value_2, NULL, result);
+  }
+
+  DECIMAL_INSTRUMENT_END(DECIMAL_OP_MOD, value_1, value_2);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// The _unchecked forms skip the argument checks of the functions above:
+// result must not be NULL, the operands must be well formed (scale at most
+// 28, reserved bits clear) and a divisor must not be zero. Overflow and
+// underflow are still reported. Building with DECIMAL_DEBUG turns the
+// preconditions into assertions.
+int add_unchecked(decimal value_1, decimal value_2, decimal *result) {
+  DECIMAL_ASSERT(result != NULL);
+  DECIMAL_ASSERT_VALID(value_1);
+  DECIMAL_ASSERT_VALID(value_2);
+  int flag = add_unrecorded(value_1, value_2, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int sub_unchecked(decimal value_1, decimal value_2, decimal *result) {
+  DECIMAL_ASSERT(result != NULL);
+  DECIMAL_ASSERT_VALID(value_1);
+  DECIMAL_ASSERT_VALID(value_2);
+  int flag = sub_unrecorded(value_1, value_2, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int mul_unchecked(decimal value_1, decimal value_2, decimal *result) {
+  DECIMAL_ASSERT(result != NULL);
+  DECIMAL_ASSERT_VALID(value_1);
+  DECIMAL_ASSERT_VALID(value_2);
+  int flag = mul_unrecorded(value_1, value_2, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
 
+int div_unchecked(decimal value_1, decimal value_2, decimal *result) {
+  DECIMAL_ASSERT(result != NULL);
+  DECIMAL_ASSERT_VALID(value_1);
+  DECIMAL_ASSERT_VALID(value_2);
+  DECIMAL_ASSERT(!is_zero(value_2));
+  int flag = divide(value_1, value_2, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
   return flag;
 }
@@ -0,0 +1,732 @@
+#include <time.h>
+
+// <stdlib.h> declares its own div(); keep it out of the way of ours.
+#define div stdlib_div
+#include <stdlib.h>
+#undef div
+
+#include "decimal.h"
+
+#define BENCH_VALUES 1024
+#define BENCH_ROUNDS 1000
+#define BENCH_REPEATS 5
+// The elementary functions run in microseconds; fewer rounds keep the
+// whole bench under a minute.
+#define BENCH_SLOW_ROUNDS 20
+
+typedef int (*binary_op)(decimal, decimal, decimal *);
+typedef int (*compare_op)(decimal, decimal);
+typedef int (*unary_op)(decimal, decimal *);
+
+static decimal values_a[BENCH_VALUES];
+static decimal values_b[BENCH_VALUES];
+static decimal_divisor divisor;
+static volatile int sink;
+
+static unsigned int next_random(unsigned int *state) {
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 8;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void fill_values(int scale_a, int scale_b, int wide) {
+  unsigned int state = 2024u;
+  for (int i = 0; i < BENCH_VALUES; i++) {
+    decimal_zero(&values_a[i]);
+    decimal_zero(&values_b[i]);
+    values_a[i].bits[0] = (int)next_random(&state);
+    values_b[i].bits[0] = (int)next_random(&state);
+    values_a[i].bits[1] = (int)(next_random(&state) & 0xFFFFu);
+    values_b[i].bits[1] = (int)(next_random(&state) & 0xFFFFu);
+    if (wide) {
+      values_a[i].bits[2] = (int)(next_random(&state) & 0xFFFFu);
+      values_b[i].bits[2] = (int)(next_random(&state) & 0xFFFFu);
+    }
+    set_scale(&values_a[i], scale_a);
+    set_scale(&values_b[i], scale_b);
+    set_sign(&values_a[i], (int)(next_random(&state) & 1u));
+    set_sign(&values_b[i], (int)(next_random(&state) & 1u));
+  }
+}
+
+// Every value_b becomes the same divisor, prepared once for div_by.
+static void fill_divisor(int mantissa, int scale) {
+  decimal value;
+  decimal_zero(&value);
+  value.bits[0] = mantissa;
+  set_scale(&value, scale);
+  for (int i = 0; i < BENCH_VALUES; i++) values_b[i] = value;
+  decimal_divisor_prepare(value, &divisor);
+}
+
+static int div_by_prepared(decimal value_1, decimal value_2,
+                           decimal *result) {
+  (void)value_2;
+  return decimal_div_by(&divisor, value_1, result);
+}
+
+// The div, mul, sub sequence callers used before decimal_divmod existed.
+static int mod_by_steps(decimal value_1, decimal value_2, decimal *result) {
+  decimal quotient;
+  decimal product;
+  int flag = div(value_1, value_2, &quotient);
+  if (flag == ARITHMETIC_OK) flag = mul(quotient, value_2, &product);
+  if (flag == ARITHMETIC_OK) flag = sub(value_1, product, result);
+  return flag;
+}
+
+static int divmod_remainder(decimal value_1, decimal value_2,
+                            decimal *result) {
+  decimal quotient;
+  return decimal_divmod(value_1, value_2, &quotient, result);
+}
+
+static int pow_12(decimal value, decimal *result) {
+  return decimal_pow(value, 12, result);
+}
+
+static void clear_signs(void) {
+  for (int i = 0; i < BENCH_VALUES; i++) set_sign(&values_a[i], 0);
+}
+
+// Best of BENCH_REPEATS runs, to keep scheduler noise out of the numbers.
+static void report(const char *name, double best, int rounds) {
+  printf("%-32s %8.2f ns/op\n", name,
+         best / ((double)rounds * BENCH_VALUES));
+}
+
+static void run_binary(const char *name, binary_op op) {
+  double best = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    decimal result;
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += op(values_a[i], values_b[i], &result);
+        checksum ^= result.bits[0];
+      }
+    }
+    double elapsed = now_ns() - start;
+    sink = checksum;
+    if (repeat == 0 || elapsed < best) best = elapsed;
+  }
+  report(name, best, BENCH_ROUNDS);
+}
+
+static void run_unary(const char *name, unary_op op) {
+  double best = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    decimal result;
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += op(values_a[i], &result);
+        checksum ^= result.bits[0];
+      }
+    }
+    double elapsed = now_ns() - start;
+    sink = checksum;
+    if (repeat == 0 || elapsed < best) best = elapsed;
+  }
+  report(name, best, BENCH_SLOW_ROUNDS);
+}
+
+static void run_compare(const char *name, compare_op op) {
+  double best = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += op(values_a[i], values_b[i]);
+      }
+    }
+    double elapsed = now_ns() - start;
+    sink = checksum;
+    if (repeat == 0 || elapsed < best) best = elapsed;
+  }
+  report(name, best, BENCH_ROUNDS);
+}
+
+// Reported per pair, as run_compare counts it.
+static void run_compare_mask(const char *name) {
+  double best = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    unsigned int checksum = 0u;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i += 32) {
+        checksum += decimal_compare_mask(&values_a[i], &values_b[i], 32,
+                                         DECIMAL_CMP_LT);
+      }
+    }
+    double elapsed = now_ns() - start;
+    sink = (int)checksum;
+    if (repeat == 0 || elapsed < best) best = elapsed;
+  }
+  report(name, best, BENCH_ROUNDS);
+}
+
+// 1024 loans drawn from 8 rates and 4 terms, as in a loan book.
+static void run_annuity(void) {
+  static int periods[BENCH_VALUES];
+  static decimal payments[BENCH_VALUES];
+  double scalar = 0.0;
+  double batched = 0.0;
+  for (int i = 0; i < BENCH_VALUES; i++) {
+    decimal_zero(&values_b[i]);
+    values_b[i].bits[0] = 25 + (i % 8) * 5;
+    set_scale(&values_b[i], 4);
+    periods[i] = 60 * (1 + (i / 8) % 4);
+  }
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += decimal_annuity_payment(values_a[i], values_b[i],
+                                            periods[i], &payments[i]);
+      }
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < scalar) scalar = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      checksum += decimal_annuity_payment_array(values_a, values_b, periods,
+                                                payments, BENCH_VALUES);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < batched) batched = elapsed;
+    sink = checksum;
+  }
+  report("decimal_annuity_payment", scalar, BENCH_SLOW_ROUNDS);
+  report("decimal_annuity_payment_array", batched, BENCH_SLOW_ROUNDS);
+}
+
+// 1,000,000.00 spread over 1024 accounts by weight: one mul and div per
+// share plus a pass to hand the rounding residue to the last account,
+// against decimal_allocate.
+static int allocate_by_steps(decimal total, decimal *shares) {
+  decimal sum;
+  decimal assigned;
+  decimal residue;
+  int flag = ARITHMETIC_OK;
+  decimal_zero(&sum);
+  decimal_zero(&assigned);
+  for (int i = 0; i < BENCH_VALUES; i++) add(sum, values_b[i], &sum);
+  for (int i = 0; i < BENCH_VALUES && flag == ARITHMETIC_OK; i++) {
+    flag = mul(total, values_b[i], &shares[i]);
+    if (flag == ARITHMETIC_OK) flag = div(shares[i], sum, &shares[i]);
+    if (flag == ARITHMETIC_OK) flag = add(assigned, shares[i], &assigned);
+  }
+  if (flag == ARITHMETIC_OK) flag = sub(total, assigned, &residue);
+  if (flag == ARITHMETIC_OK) {
+    flag = add(shares[BENCH_VALUES - 1], residue,
+               &shares[BENCH_VALUES - 1]);
+  }
+  return flag;
+}
+
+static void run_allocate(void) {
+  static decimal shares[BENCH_VALUES];
+  decimal total = DECIMAL_LIT(100000000, 2);
+  decimal cents = DECIMAL_LIT(100000000, 0);
+  decimal_arena arena;
+  double naive = 0.0;
+  double allocated = 0.0;
+  double arena_allocated = 0.0;
+  decimal_arena_init(&arena, 0);
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      checksum += allocate_by_steps(cents, shares);
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < naive) naive = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      checksum +=
+          decimal_allocate(total, values_b, BENCH_VALUES, 2, shares);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < allocated) allocated = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      checksum += decimal_allocate_arena(total, values_b, BENCH_VALUES, 2,
+                                         &arena, shares);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < arena_allocated) arena_allocated = elapsed;
+    sink = checksum;
+  }
+  decimal_arena_release(&arena);
+  report("mul + div per share + fix-up", naive, BENCH_SLOW_ROUNDS);
+  report("decimal_allocate", allocated, BENCH_SLOW_ROUNDS);
+  report("decimal_allocate_arena", arena_allocated, BENCH_SLOW_ROUNDS);
+}
+
+// Prices as a market-data feed delivers them: 4 to 7 significant digits.
+static void run_float(void) {
+  static float prices[BENCH_VALUES];
+  unsigned int state = 7u;
+  double scalar = 0.0;
+  double batched = 0.0;
+  for (int i = 0; i < BENCH_VALUES; i++) {
+    prices[i] = (float)(next_random(&state) % 10000000u) / 1000.0f;
+  }
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += from_float_to_decimal(prices[i], &values_a[i]);
+      }
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < scalar) scalar = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      checksum += from_float_to_decimal_array(prices, values_a, BENCH_VALUES);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < batched) batched = elapsed;
+    sink = checksum;
+  }
+  report("from_float_to_decimal", scalar, BENCH_ROUNDS);
+  report("from_float_to_decimal_array", batched, BENCH_ROUNDS);
+}
+
+// The pricing rule (a * b - a) / b + a, one rounded call per step.
+static int formula_by_steps(decimal value_1, decimal value_2,
+                            decimal *result) {
+  decimal step;
+  int flag = mul(value_1, value_2, &step);
+  if (flag == ARITHMETIC_OK) flag = sub(step, value_1, &step);
+  if (flag == ARITHMETIC_OK) flag = div(step, value_2, &step);
+  if (flag == ARITHMETIC_OK) flag = add(step, value_1, result);
+  return flag;
+}
+
+static void run_expression(void) {
+  static const char *const names[2] = {"a", "b"};
+  static decimal results[BENCH_VALUES];
+  const decimal *columns[2] = {values_a, values_b};
+  decimal_expression expression;
+  double batched = 0.0;
+  decimal_expression_compile("(a * b - a) / b + a", names, 2, &expression);
+  run_binary("mul, sub, div, add", formula_by_steps);
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    double start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      sink = decimal_expression_eval_columns(&expression, columns, results,
+                                             BENCH_VALUES);
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < batched) batched = elapsed;
+  }
+  report("decimal_expression_eval_columns", batched, BENCH_SLOW_ROUNDS);
+}
+
+static void run_validate(void) {
+  double scalar = 0.0;
+  double batched = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    size_t checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += (size_t)decimal_is_valid(values_a[i]);
+      }
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < scalar) scalar = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      checksum += decimal_first_invalid(values_a, BENCH_VALUES);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < batched) batched = elapsed;
+    sink = (int)checksum;
+  }
+  report("decimal_is_valid per value", scalar, BENCH_ROUNDS);
+  report("decimal_first_invalid", batched, BENCH_ROUNDS);
+  printf("%-32s %8.2f GB/s\n", "decimal_first_invalid scan",
+         (double)sizeof(decimal) * BENCH_VALUES * BENCH_ROUNDS / batched);
+}
+
+// Escalating adds in the usual per-row pattern: the arena is reset for
+// each row and the result comes back as a decimal.
+static decimal_arena number_arena;
+
+static int number_add(decimal value_1, decimal value_2, decimal *result) {
+  decimal_number number_1;
+  decimal_number number_2;
+  decimal_arena_reset(&number_arena);
+  decimal_number_from_decimal(value_1, &number_1);
+  decimal_number_from_decimal(value_2, &number_2);
+  int flag =
+      decimal_number_add(&number_1, &number_2, &number_arena, &number_1);
+  if (flag == ARITHMETIC_OK)
+    flag = decimal_number_sub(&number_1, &number_2, &number_arena, &number_1);
+  if (flag == ARITHMETIC_OK)
+    flag = decimal_number_to_decimal(&number_1, &number_arena, result);
+  return flag;
+}
+
+static int add_then_sub(decimal value_1, decimal value_2, decimal *result) {
+  int flag = add(value_1, value_2, result);
+  if (flag == ARITHMETIC_OK) flag = sub(*result, value_2, result);
+  return flag;
+}
+
+static void run_number(void) {
+  decimal_arena_init(&number_arena, 0);
+  fill_values(2, 2, 1);
+  run_binary("add + sub", add_then_sub);
+  run_binary("decimal_number add + sub", number_add);
+  for (int i = 0; i < BENCH_VALUES; i++) {
+    values_a[i].bits[2] |= (int)0x80000000u;
+    values_b[i].bits[2] |= (int)0x80000000u;
+    set_scale(&values_a[i], 0);
+    set_scale(&values_b[i], 0);
+    set_sign(&values_b[i], get_sign(&values_a[i]));
+  }
+  run_binary("decimal_number add + sub, big", number_add);
+  decimal_arena_release(&number_arena);
+}
+
+// A P&L rollup over 64 instruments: sort the rows by key and add along
+// each run, against one hash-aggregation pass.
+static long long group_keys[BENCH_VALUES];
+
+static int compare_rows(const void *row_1, const void *row_2) {
+  long long key_1 = group_keys[*(const int *)row_1];
+  long long key_2 = group_keys[*(const int *)row_2];
+  return (key_1 > key_2) - (key_1 < key_2);
+}
+
+static int group_by_sorting(decimal *sums) {
+  static int rows[BENCH_VALUES];
+  int flag = ARITHMETIC_OK;
+  int groups = 0;
+  for (int i = 0; i < BENCH_VALUES; i++) rows[i] = i;
+  qsort(rows, BENCH_VALUES, sizeof(rows[0]), compare_rows);
+  for (int i = 0; i < BENCH_VALUES && flag == ARITHMETIC_OK; i++) {
+    if (i == 0 || group_keys[rows[i]] != group_keys[rows[i - 1]])
+      sums[groups++] = values_a[rows[i]];
+    else
+      flag = add(sums[groups - 1], values_a[rows[i]], &sums[groups - 1]);
+  }
+  return flag;
+}
+
+static void run_group(void) {
+  static decimal sums[BENCH_VALUES];
+  const decimal *columns[1] = {values_a};
+  decimal_arena arena;
+  decimal_groups groups;
+  double sorted = 0.0;
+  double hashed = 0.0;
+  decimal_arena_init(&arena, 0);
+  for (int i = 0; i < BENCH_VALUES; i++) group_keys[i] = (i * 37) % 64;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      checksum += group_by_sorting(sums);
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < sorted) sorted = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+      decimal_arena_reset(&arena);
+      checksum += decimal_group_by_int(group_keys, columns, 1, BENCH_VALUES,
+                                       1, &arena, &groups);
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < hashed) hashed = elapsed;
+    sink = checksum;
+  }
+  decimal_arena_release(&arena);
+  report("qsort + add per group", sorted, BENCH_SLOW_ROUNDS);
+  report("decimal_group_by_int", hashed, BENCH_SLOW_ROUNDS);
+}
+
+// Running balance over a 64K-row statement, as report() counts it per row.
+#define SCAN_VALUES (BENCH_VALUES * 64)
+
+static void run_scan(void) {
+  static decimal amounts[SCAN_VALUES];
+  static decimal balances[SCAN_VALUES];
+  double timed[3] = {0.0, 0.0, 0.0};
+  for (int i = 0; i < SCAN_VALUES; i++) amounts[i] = values_a[i % BENCH_VALUES];
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (int variant = 0; variant < 3; variant++) {
+      int checksum = 0;
+      double start = now_ns();
+      for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+        if (variant == 0) {
+          decimal sum = DECIMAL_LIT(0, 0);
+          for (int i = 0; i < SCAN_VALUES; i++) {
+            checksum += add(sum, amounts[i], &sum);
+            balances[i] = sum;
+          }
+        } else {
+          checksum += decimal_scan_inclusive(amounts, balances, NULL,
+                                             SCAN_VALUES, variant == 1 ? 1 : 4);
+        }
+      }
+      double elapsed = (now_ns() - start) / 64.0;
+      if (repeat == 0 || elapsed < timed[variant]) timed[variant] = elapsed;
+      sink = checksum;
+    }
+  }
+  report("add loop, running balance", timed[0], BENCH_SLOW_ROUNDS);
+  report("decimal_scan_inclusive, 1 thread", timed[1], BENCH_SLOW_ROUNDS);
+  report("decimal_scan_inclusive, 4 threads", timed[2], BENCH_SLOW_ROUNDS);
+}
+
+// A 64K-row price/amount file parsed from memory, per row.
+#define CSV_ROWS (BENCH_VALUES * 64)
+#define CSV_LINE 48
+
+static void run_csv(void) {
+  static char text[CSV_ROWS * CSV_LINE];
+  static decimal prices[CSV_ROWS];
+  static decimal amounts[CSV_ROWS];
+  decimal *columns[] = {prices, amounts};
+  const int fields[] = {1, 2};
+  double timed[2] = {0.0, 0.0};
+  unsigned int state = 99u;
+  size_t length = 0;
+  for (int i = 0; i < CSV_ROWS; i++) {
+    unsigned int price = next_random(&state) % 1000000u;
+    unsigned int amount = next_random(&state);
+    length += (size_t)snprintf(
+        text + length, CSV_LINE, "%d,%u.%02u,%s%u.%04u\n", i, price / 100u,
+        price % 100u, (amount & 1u) ? "-" : "", amount / 10000u,
+        amount % 10000u);
+  }
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (int variant = 0; variant < 2; variant++) {
+      int checksum = 0;
+      double start = now_ns();
+      for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+        decimal_csv_reader reader;
+        size_t rows = 0;
+        decimal_csv_open_buffer(&reader, text, length, ',', fields, 2);
+        checksum += decimal_csv_read(&reader, columns, NULL, CSV_ROWS,
+                                     variant == 0 ? 1 : 4, &rows);
+        checksum += (int)rows;
+      }
+      double elapsed = (now_ns() - start) / 64.0;
+      if (repeat == 0 || elapsed < timed[variant]) timed[variant] = elapsed;
+      sink = checksum;
+    }
+  }
+  report("decimal_csv_read, 1 thread", timed[0], BENCH_SLOW_ROUNDS);
+  report("decimal_csv_read, 4 threads", timed[1], BENCH_SLOW_ROUNDS);
+  printf("%-32s %8.2f MB/s\n", "decimal_csv_read, 1 thread",
+         (double)length * BENCH_SLOW_ROUNDS * 1000.0 / (timed[0] * 64.0));
+}
+
+// Variance and a weighted average over 64K values, per value: the usual
+// chain of rounded mul/add/div calls against the exact one-pass kernels.
+#define STATS_VALUES (BENCH_VALUES * 64)
+
+static void run_stats(void) {
+  static decimal prices[STATS_VALUES];
+  static decimal volumes[STATS_VALUES];
+  double timed[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+  for (int i = 0; i < STATS_VALUES; i++) {
+    prices[i] = values_a[i % BENCH_VALUES];
+    volumes[i] = values_b[(i * 7) % BENCH_VALUES];
+    set_sign(&volumes[i], 0);
+  }
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (int variant = 0; variant < 5; variant++) {
+      int checksum = 0;
+      double start = now_ns();
+      for (int round = 0; round < BENCH_SLOW_ROUNDS; round++) {
+        decimal result = DECIMAL_LIT(0, 0);
+        if (variant == 0) {
+          decimal sum = DECIMAL_LIT(0, 0);
+          decimal squares = DECIMAL_LIT(0, 0);
+          decimal count = DECIMAL_LIT(STATS_VALUES, 0);
+          for (int i = 0; i < STATS_VALUES; i++) {
+            decimal square;
+            checksum += add(sum, prices[i], &sum);
+            checksum += mul(prices[i], prices[i], &square);
+            checksum += add(squares, square, &squares);
+          }
+          checksum += div(sum, count, &sum);
+          checksum += mul(sum, sum, &sum);
+          checksum += div(squares, count, &squares);
+          checksum += sub(squares, sum, &result);
+        } else if (variant <= 2) {
+          checksum += decimal_variance(prices, STATS_VALUES, 0,
+                                       variant == 1 ? 1 : 4, &result);
+        } else if (variant == 3) {
+          decimal amount = DECIMAL_LIT(0, 0);
+          decimal volume = DECIMAL_LIT(0, 0);
+          for (int i = 0; i < STATS_VALUES; i++) {
+            decimal product;
+            checksum += mul(prices[i], volumes[i], &product);
+            checksum += add(amount, product, &amount);
+            checksum += add(volume, volumes[i], &volume);
+          }
+          checksum += div(amount, volume, &result);
+        } else {
+          checksum += decimal_weighted_mean(prices, volumes, STATS_VALUES, 1,
+                                            &result);
+        }
+        checksum += result.bits[0];
+      }
+      double elapsed = (now_ns() - start) / 64.0;
+      if (repeat == 0 || elapsed < timed[variant]) timed[variant] = elapsed;
+      sink = checksum;
+    }
+  }
+  report("mul/add/div chain, variance", timed[0], BENCH_SLOW_ROUNDS);
+  report("decimal_variance, 1 thread", timed[1], BENCH_SLOW_ROUNDS);
+  report("decimal_variance, 4 threads", timed[2], BENCH_SLOW_ROUNDS);
+  report("mul/add/div chain, VWAP", timed[3], BENCH_SLOW_ROUNDS);
+  report("decimal_weighted_mean", timed[4], BENCH_SLOW_ROUNDS);
+}
+
+// round_decimal one value at a time against decimal_round_array over the
+// same column, with every value at the scale of values_a[0] or with the
+// scales mixed.
+static void run_round_array(const char *scalar_name, const char *array_name) {
+  static decimal results[BENCH_VALUES];
+  double scalar = 0.0;
+  double batched = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    int checksum = 0;
+    double start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      for (int i = 0; i < BENCH_VALUES; i++) {
+        checksum += round_decimal(values_a[i], &results[i]);
+        checksum ^= results[i].bits[0];
+      }
+    }
+    double elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < scalar) scalar = elapsed;
+    start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      checksum += decimal_round_array(values_a, results, BENCH_VALUES);
+      checksum ^= results[round % BENCH_VALUES].bits[0];
+    }
+    elapsed = now_ns() - start;
+    if (repeat == 0 || elapsed < batched) batched = elapsed;
+    sink = checksum;
+  }
+  report(scalar_name, scalar, BENCH_ROUNDS);
+  report(array_name, batched, BENCH_ROUNDS);
+}
+
+static void run_rounding(void) {
+  fill_values(6, 6, 1);
+  run_round_array("round_decimal, scale 6", "decimal_round_array, scale 6");
+  fill_values(18, 18, 1);
+  run_round_array("round_decimal, scale 18", "decimal_round_array, scale 18");
+  for (int i = 0; i < BENCH_VALUES; i++) set_scale(&values_a[i], i % 29);
+  run_round_array("round_decimal, mixed scale",
+                  "decimal_round_array, mixed scale");
+}
+
+// Amounts carrying 0 to 18 trailing zeros at scale 20, as left behind by
+// chains of multiplications.
+static void run_reduce(void) {
+  unsigned int state = 11u;
+  for (int i = 0; i < BENCH_VALUES; i++) {
+    decimal digits = {{(int)(next_random(&state) % 100000u + 1u), 0, 0, 0}};
+    mul(digits, decimal_powers_of_ten[i % 19], &values_a[i]);
+    set_scale(&values_a[i], 20);
+  }
+  run_unary("decimal_reduce", decimal_reduce);
+  fill_values(4, 4, 0);
+  run_binary("mul scale 4 x 4", mul);
+  decimal_context_get()->options |= DECIMAL_OPTION_REDUCE_MUL;
+  run_binary("mul scale 4 x 4, reduced", mul);
+  decimal_context_reset();
+}
+
+int main(void) {
+  fill_values(2, 2, 0);
+  run_binary("add same scale, 64-bit", add);
+  run_binary("add_unchecked", add_unchecked);
+  run_binary("sub same scale, 64-bit", sub);
+  run_binary("sub_unchecked", sub_unchecked);
+  run_compare("is_less same scale", is_less);
+  run_compare("is_less_unchecked", is_less_unchecked);
+  run_compare_mask("decimal_compare_mask same scale");
+
+  fill_values(2, 2, 0);
+  for (int i = 0; i < BENCH_VALUES; i++) values_b[i].bits[1] = 0;
+  run_binary("mul 64 x 32-bit", mul);
+  run_binary("mul_unchecked", mul_unchecked);
+
+  fill_values(2, 2, 1);
+  run_binary("add same scale, 96-bit", add);
+  run_binary("sub same scale, 96-bit", sub);
+  run_compare("is_less same scale", is_less);
+
+  fill_values(2, 6, 0);
+  run_binary("add mixed scale", add);
+  run_binary("sub mixed scale", sub);
+  run_compare("is_less mixed scale", is_less);
+  run_compare_mask("decimal_compare_mask mixed scale");
+
+  fill_values(2, 0, 1);
+  fill_divisor(365, 0);
+  run_binary("div by constant", div);
+  run_binary("div_by prepared constant", div_by_prepared);
+
+  fill_values(4, 2, 0);
+  run_binary("div + mul + sub", mod_by_steps);
+  run_binary("decimal_divmod", divmod_remainder);
+
+  fill_values(2, 2, 1);
+  clear_signs();
+  run_unary("decimal_sqrt", decimal_sqrt);
+  run_unary("decimal_ln", decimal_ln);
+
+  fill_values(14, 14, 0);
+  run_unary("decimal_exp", decimal_exp);
+  run_unary("decimal_pow, exponent 12", pow_12);
+
+  fill_values(2, 2, 0);
+  clear_signs();
+  run_annuity();
+  run_allocate();
+  run_float();
+  run_validate();
+
+  fill_values(2, 2, 0);
+  run_expression();
+  run_number();
+
+  fill_values(2, 2, 0);
+  run_group();
+  run_scan();
+  run_csv();
+  run_stats();
+  run_rounding();
+  run_reduce();
+
+#ifdef DECIMAL_INSTRUMENT
+  decimal_instrument_stats stats;
+  decimal_instrument_snapshot(&stats);
+  decimal_instrument_dump(&stats, stdout);
+#endif
+  return 0;
+}
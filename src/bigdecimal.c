@@ -0,0 +1,483 @@
+#include "decimal.h"
+
+// Narrowing works on a copy of the limbs: on the stack up to this length,
+// in the caller's arena beyond it.
+#define BIGDECIMAL_STACK_LIMBS 32
+
+static const unsigned int kPow10U32[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+
+static void trim(bigdecimal *value) {
+  while (value->length > 0 && value->limbs[value->length - 1] == 0u)
+    value->length--;
+  if (value->length == 0) value->sign = 0;
+}
+
+static int alloc_limbs(decimal_arena *arena, int length, bigdecimal *result) {
+  result->limbs =
+      decimal_arena_alloc(arena, (size_t)length * sizeof(unsigned int));
+  result->length = length;
+  if (result->limbs != NULL)
+    memset(result->limbs, 0, (size_t)length * sizeof(unsigned int));
+  return result->limbs != NULL ? ARITHMETIC_OK : ARITHMETIC_BAD_INPUT;
+}
+
+int bigdecimal_from_decimal(decimal value, decimal_arena *arena,
+                            bigdecimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (result == NULL || arena == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = alloc_limbs(arena, 3, result);
+    result->scale = get_scale(&value);
+    result->sign = get_sign(&value);
+    if (flag == ARITHMETIC_OK) {
+      for (int i = 0; i < 3; i++)
+        result->limbs[i] = (unsigned int)value.bits[i];
+      trim(result);
+    }
+  }
+  return flag;
+}
+
+// value * 10^power in a fresh limb array; 10^9 costs at most 30 bits, so
+// every step of 9 digits adds one limb.
+static int scaled_copy(const bigdecimal *value, int power,
+                       decimal_arena *arena, bigdecimal *result) {
+  int flag = alloc_limbs(arena, value->length + (power + 8) / 9, result);
+  if (flag == ARITHMETIC_OK) {
+    int length = value->length;
+    memcpy(result->limbs, value->limbs,
+           (size_t)value->length * sizeof(unsigned int));
+    for (int left = power; left > 0; left -= 9) {
+      unsigned int factor = kPow10U32[left > 9 ? 9 : left];
+      unsigned long long carry = 0ull;
+      for (int i = 0; i < length; i++) {
+        carry += (unsigned long long)result->limbs[i] * factor;
+        result->limbs[i] = (unsigned int)carry;
+        carry >>= 32;
+      }
+      if (carry != 0ull) result->limbs[length++] = (unsigned int)carry;
+    }
+    result->scale = value->scale + power;
+    result->sign = value->sign;
+  }
+  return flag;
+}
+
+static int compare_magnitudes(const bigdecimal *a, const bigdecimal *b) {
+  int result = (a->length > b->length) - (a->length < b->length);
+  for (int i = a->length - 1; i >= 0 && result == 0; i--) {
+    if (a->limbs[i] != b->limbs[i]) result = a->limbs[i] > b->limbs[i] ? 1 : -1;
+  }
+  return result;
+}
+
+// a and b share a scale; result has room for max(length) + 1 limbs.
+static void add_magnitudes(const bigdecimal *a, const bigdecimal *b,
+                           bigdecimal *result) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < result->length; i++) {
+    carry += (i < a->length ? a->limbs[i] : 0u);
+    carry += (i < b->length ? b->limbs[i] : 0u);
+    result->limbs[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+}
+
+// Requires |a| >= |b|.
+static void sub_magnitudes(const bigdecimal *a, const bigdecimal *b,
+                           bigdecimal *result) {
+  unsigned long long borrow = 0ull;
+  for (int i = 0; i < result->length; i++) {
+    unsigned long long t = (unsigned long long)(i < a->length ? a->limbs[i]
+                                                               : 0u) -
+                           (i < b->length ? b->limbs[i] : 0u) - borrow;
+    result->limbs[i] = (unsigned int)t;
+    borrow = (t >> 32) & 1ull;
+  }
+}
+
+// The aligned copies of the operands are scratch: the result is allocated
+// first and the arena is rewound past them afterwards.
+static int add_signed(const bigdecimal *value_1, const bigdecimal *value_2,
+                      int negate_2, decimal_arena *arena,
+                      bigdecimal *result) {
+  int flag = ARITHMETIC_OK;
+  bigdecimal a;
+  bigdecimal b;
+  int scale = value_1->scale > value_2->scale ? value_1->scale
+                                               : value_2->scale;
+  int length_1 = value_1->length + (scale - value_1->scale + 8) / 9;
+  int length_2 = value_2->length + (scale - value_2->scale + 8) / 9;
+  flag = alloc_limbs(arena, (length_1 > length_2 ? length_1 : length_2) + 1,
+                     result);
+  decimal_arena_mark mark = decimal_arena_get_mark(arena);
+  if (flag == ARITHMETIC_OK)
+    flag = scaled_copy(value_1, scale - value_1->scale, arena, &a);
+  if (flag == ARITHMETIC_OK)
+    flag = scaled_copy(value_2, scale - value_2->scale, arena, &b);
+  if (flag == ARITHMETIC_OK) {
+    trim(&a);
+    trim(&b);
+    b.sign ^= negate_2;
+    result->scale = scale;
+    if (a.sign == b.sign) {
+      add_magnitudes(&a, &b, result);
+      result->sign = a.sign;
+    } else if (compare_magnitudes(&a, &b) >= 0) {
+      sub_magnitudes(&a, &b, result);
+      result->sign = a.sign;
+    } else {
+      sub_magnitudes(&b, &a, result);
+      result->sign = b.sign;
+    }
+    trim(result);
+  }
+  decimal_arena_rewind(arena, mark);
+  return flag;
+}
+
+// The results below are exact. Limbs come from the arena and stay valid
+// until it is reset; the only failure is running out of memory, reported
+// as ARITHMETIC_BAD_INPUT.
+int bigdecimal_add(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (value_1 != NULL && value_2 != NULL && arena != NULL && result != NULL)
+    flag = add_signed(value_1, value_2, 0, arena, result);
+  return flag;
+}
+
+int bigdecimal_sub(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (value_1 != NULL && value_2 != NULL && arena != NULL && result != NULL)
+    flag = add_signed(value_1, value_2, 1, arena, result);
+  return flag;
+}
+
+int bigdecimal_mul(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  bigdecimal product;
+  if (value_1 != NULL && value_2 != NULL && arena != NULL && result != NULL)
+    flag = alloc_limbs(arena, value_1->length + value_2->length, &product);
+  if (flag == ARITHMETIC_OK) {
+    for (int i = 0; i < value_1->length; i++) {
+      unsigned long long carry = 0ull;
+      for (int j = 0; j < value_2->length; j++) {
+        carry += (unsigned long long)value_1->limbs[i] * value_2->limbs[j] +
+                 product.limbs[i + j];
+        product.limbs[i + j] = (unsigned int)carry;
+        carry >>= 32;
+      }
+      product.limbs[i + value_2->length] = (unsigned int)carry;
+    }
+    product.scale = value_1->scale + value_2->scale;
+    product.sign = value_1->sign ^ value_2->sign;
+    trim(&product);
+    *result = product;
+  }
+  return flag;
+}
+
+static unsigned int div_small(unsigned int *limbs, int length,
+                              unsigned int divisor) {
+  unsigned long long remainder = 0ull;
+  for (int i = length - 1; i >= 0; i--) {
+    unsigned long long t = (remainder << 32) | limbs[i];
+    limbs[i] = (unsigned int)(t / divisor);
+    remainder = t % divisor;
+  }
+  return (unsigned int)remainder;
+}
+
+static unsigned int mod_small(const unsigned int *limbs, int length,
+                              unsigned int divisor) {
+  unsigned long long remainder = 0ull;
+  for (int i = length - 1; i >= 0; i--)
+    remainder = ((remainder << 32) | limbs[i]) % divisor;
+  return (unsigned int)remainder;
+}
+
+// Drops trailing fractional zeros from a result whose limbs the caller
+// owns, nine at a time and then one at a time. Products add the operand
+// scales, so without this a chain of them keeps growing.
+static void strip_zeros(bigdecimal *value) {
+  while (value->scale >= 9 && value->length > 0 &&
+         mod_small(value->limbs, value->length, kPow10U32[9]) == 0u) {
+    div_small(value->limbs, value->length, kPow10U32[9]);
+    value->scale -= 9;
+    trim(value);
+  }
+  while (value->scale > 0 && value->length > 0 &&
+         mod_small(value->limbs, value->length, 10u) == 0u) {
+    div_small(value->limbs, value->length, 10u);
+    value->scale--;
+    trim(value);
+  }
+  if (value->length == 0) value->scale = 0;
+}
+
+static int fits_u96(const unsigned int *limbs, int length) {
+  while (length > 3 && limbs[length - 1] == 0u) length--;
+  return length <= 3;
+}
+
+static void to_words(const unsigned int *limbs, int scale, int sign,
+                     decimal *result) {
+  for (int i = 0; i < 3; i++) result->bits[i] = (int)limbs[i];
+  result->bits[3] = 0;
+  set_scale(result, scale);
+  set_sign(result, sign && (limbs[0] | limbs[1] | limbs[2]) != 0u);
+}
+
+// The limbs of value in `stack` when they fit, otherwise in `arena`; NULL
+// when that allocation fails. The caller rewinds the arena.
+static unsigned int *copy_limbs(const bigdecimal *value, unsigned int *stack,
+                                decimal_arena *arena) {
+  unsigned int *limbs = stack;
+  if (value->length > BIGDECIMAL_STACK_LIMBS)
+    limbs = decimal_arena_alloc(arena,
+                                (size_t)value->length * sizeof(unsigned int));
+  if (limbs != NULL && value->length > 0)
+    memcpy(limbs, value->limbs, (size_t)value->length * sizeof(unsigned int));
+  return limbs;
+}
+
+// Drops low digits until the value is at most 96 bits at a scale of at
+// most 28, then rounds half-even on the dropped digits. Nine digits go at
+// a time while at least nine more have to go anyway: at a scale of 37 or
+// more, or from 2^128 up. With `exact` set, a non-zero dropped digit fails
+// instead of rounding.
+static int narrow(const bigdecimal *value, int exact, decimal_arena *arena,
+                  decimal *result) {
+  int flag = ARITHMETIC_OK;
+  unsigned int stack[BIGDECIMAL_STACK_LIMBS];
+  unsigned int padding[4] = {0u};
+  decimal_arena_mark mark = decimal_arena_get_mark(arena);
+  unsigned int *limbs = copy_limbs(value, stack, arena);
+  int length = value->length;
+  int scale = value->scale;
+  unsigned int digit = 0u;
+  int sticky = 0;
+  int fitted = 0;
+
+  if (limbs == NULL) flag = ARITHMETIC_BAD_INPUT;
+  while (flag == ARITHMETIC_OK && scale >= 9 && (scale >= 37 || length > 4)) {
+    unsigned int rest = div_small(limbs, length, kPow10U32[9]);
+    sticky |= digit != 0u || rest % kPow10U32[8] != 0u;
+    digit = rest / kPow10U32[8];
+    scale -= 9;
+    while (length > 0 && limbs[length - 1] == 0u) length--;
+    if (exact && rest != 0u) flag = ARITHMETIC_BIG;
+  }
+  while (flag == ARITHMETIC_OK && !fitted) {
+    if (scale <= 28 && fits_u96(limbs, length)) {
+      // At most three limbs are left; work on four so a carry has room.
+      memcpy(padding, limbs, (size_t)(length < 3 ? length : 3) *
+                                 sizeof(unsigned int));
+      unsigned long long carry =
+          digit > 5u || (digit == 5u && (sticky || (padding[0] & 1u)));
+      for (int i = 0; i < 4 && carry != 0ull; i++) {
+        carry += padding[i];
+        padding[i] = (unsigned int)carry;
+        carry >>= 32;
+      }
+      // Rounding up can carry into bit 96; then one more digit goes.
+      fitted = padding[3] == 0u;
+      if (fitted) to_words(padding, scale, value->sign, result);
+      if (fitted && (digit != 0u || sticky))
+        decimal_context_raise(DECIMAL_STATUS_INEXACT);
+      padding[3] = 0u;
+    }
+    if (!fitted) {
+      sticky |= digit != 0u;
+      if (scale == 0) {
+        flag = ARITHMETIC_BIG;
+      } else {
+        digit = div_small(limbs, length, 10u);
+        scale--;
+        if (exact && digit != 0u) flag = ARITHMETIC_BIG;
+      }
+    }
+  }
+  if (limbs != stack) decimal_arena_rewind(arena, mark);
+  return flag;
+}
+
+// Rounds half-even into a decimal. ARITHMETIC_BIG when the integer part
+// does not fit in 96 bits. A value of more than 32 limbs is copied into
+// `arena` while it narrows, and the arena is rewound afterwards.
+int bigdecimal_to_decimal(const bigdecimal *value, decimal_arena *arena,
+                          decimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (value != NULL && result != NULL) flag = narrow(value, 0, arena, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// A wide_int magnitude * 10^-scale with the given sign.
+int bigdecimal_from_wide(const wide_int *value, int scale, int sign,
+                         decimal_arena *arena, bigdecimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (value != NULL && arena != NULL && result != NULL)
+    flag = alloc_limbs(arena, WIDE_WORDS, result);
+  if (flag == ARITHMETIC_OK) {
+    memcpy(result->limbs, value->words, sizeof(value->words));
+    result->scale = scale;
+    result->sign = sign;
+    trim(result);
+  }
+  return flag;
+}
+
+// Rounds to the WIDE_DECIMAL_DIGITS digits of a wide_decimal, with scratch
+// space as in bigdecimal_to_decimal.
+int bigdecimal_to_wide_decimal(const bigdecimal *value, decimal_arena *arena,
+                               wide_decimal *result) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  unsigned int stack[BIGDECIMAL_STACK_LIMBS];
+  unsigned int *limbs = NULL;
+  decimal_arena_mark mark = decimal_arena_get_mark(arena);
+  if (value != NULL && result != NULL) limbs = copy_limbs(value, stack, arena);
+  if (limbs != NULL) {
+    int length = value->length;
+    int exponent = -value->scale;
+    int sticky = 0;
+    flag = ARITHMETIC_OK;
+    // Nine digits at a time until the value fits in seven words. It then
+    // still has far more than WIDE_DECIMAL_DIGITS digits, so a 1 appended
+    // for the dropped ones sits below the digit normalizing rounds on.
+    while (length > WIDE_WORDS - 1) {
+      sticky |= div_small(limbs, length, kPow10U32[9]) != 0u;
+      exponent += 9;
+      while (length > 0 && limbs[length - 1] == 0u) length--;
+    }
+    wide_zero(&result->mantissa);
+    memcpy(result->mantissa.words, limbs,
+           (size_t)length * sizeof(unsigned int));
+    if (sticky) {
+      wide_mul_u32(&result->mantissa, 10u);
+      wide_add_u32(&result->mantissa, 1u);
+      exponent--;
+    }
+    result->exponent = exponent;
+    result->sign = value->sign;
+    wide_decimal_normalize(result);
+    if (limbs != stack) decimal_arena_rewind(arena, mark);
+  }
+  return flag;
+}
+
+void decimal_number_from_decimal(decimal value, decimal_number *result) {
+  if (result != NULL) {
+    result->value = value;
+    result->is_big = 0;
+  }
+}
+
+static int number_to_big(const decimal_number *value, decimal_arena *arena,
+                         bigdecimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (value->is_big) *result = value->big;
+  else flag = bigdecimal_from_decimal(value->value, arena, result);
+  return flag;
+}
+
+#define NUMBER_ADD 0
+#define NUMBER_SUB 1
+#define NUMBER_MUL 2
+
+static int small_op(int op, decimal value_1, decimal value_2,
+                    decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (op == NUMBER_ADD) flag = add_unrecorded(value_1, value_2, result);
+  else if (op == NUMBER_SUB) flag = sub_unrecorded(value_1, value_2, result);
+  else flag = mul_unrecorded(value_1, value_2, result);
+  return flag;
+}
+
+static int big_op(int op, const bigdecimal *value_1,
+                  const bigdecimal *value_2, decimal_arena *arena,
+                  bigdecimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (op == NUMBER_ADD) flag = bigdecimal_add(value_1, value_2, arena, result);
+  else if (op == NUMBER_SUB)
+    flag = bigdecimal_sub(value_1, value_2, arena, result);
+  else flag = bigdecimal_mul(value_1, value_2, arena, result);
+  return flag;
+}
+
+// Two fixed-size operands take the ordinary path. Only when that
+// overflows is the operation redone exactly as a bigdecimal; the overflow
+// is not recorded in the status context, since nothing was lost. A big
+// result narrows back to a decimal as soon as it fits without rounding.
+static int number_op(int op, const decimal_number *value_1,
+                     const decimal_number *value_2, decimal_arena *arena,
+                     decimal_number *result) {
+  int flag = ARITHMETIC_BIG;
+  decimal_number out;
+
+  if (value_1 == NULL || value_2 == NULL || result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (!value_1->is_big && !value_2->is_big) {
+    // The fixed-size operation records nothing, so an overflow it gives
+    // up on leaves the status context as it was.
+    flag = small_op(op, value_1->value, value_2->value, &out.value);
+    out.is_big = 0;
+  }
+  if (flag == ARITHMETIC_BIG) {
+    bigdecimal big_1;
+    bigdecimal big_2;
+    flag = arena != NULL ? number_to_big(value_1, arena, &big_1)
+                         : ARITHMETIC_BAD_INPUT;
+    if (flag == ARITHMETIC_OK) flag = number_to_big(value_2, arena, &big_2);
+    if (flag == ARITHMETIC_OK)
+      flag = big_op(op, &big_1, &big_2, arena, &out.big);
+    if (flag == ARITHMETIC_OK && op == NUMBER_MUL) strip_zeros(&out.big);
+    if (flag == ARITHMETIC_OK)
+      out.is_big = narrow(&out.big, 1, arena, &out.value) != ARITHMETIC_OK;
+  }
+  if (flag == ARITHMETIC_OK) *result = out;
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// The arena holds the limbs of any big result; it is only touched when a
+// result overflows the fixed-size type.
+int decimal_number_add(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result) {
+  return number_op(NUMBER_ADD, value_1, value_2, arena, result);
+}
+
+int decimal_number_sub(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result) {
+  return number_op(NUMBER_SUB, value_1, value_2, arena, result);
+}
+
+int decimal_number_mul(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result) {
+  return number_op(NUMBER_MUL, value_1, value_2, arena, result);
+}
+
+// Rounds like bigdecimal_to_decimal; `arena` is only used for scratch.
+int decimal_number_to_decimal(const decimal_number *value,
+                              decimal_arena *arena, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (value == NULL || result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+    decimal_context_record(flag);
+  } else if (value->is_big) {
+    flag = bigdecimal_to_decimal(&value->big, arena, result);
+  } else {
+    *result = value->value;
+  }
+  return flag;
+}
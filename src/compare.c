@@ -1,32 +1,302 @@
 #include "decimal.h"
 
-static int cmp_core(decimal a, decimal b) {
-  if (is_zero(a) && is_zero(b)) return 0;
+// 10^k as little-endian 32-bit words, k = 0..28.
+static const unsigned int kPow10Words[29][3] = {
+    {0x00000001u, 0x00000000u, 0x00000000u},
+    {0x0000000Au, 0x00000000u, 0x00000000u},
+    {0x00000064u, 0x00000000u, 0x00000000u},
+    {0x000003E8u, 0x00000000u, 0x00000000u},
+    {0x00002710u, 0x00000000u, 0x00000000u},
+    {0x000186A0u, 0x00000000u, 0x00000000u},
+    {0x000F4240u, 0x00000000u, 0x00000000u},
+    {0x00989680u, 0x00000000u, 0x00000000u},
+    {0x05F5E100u, 0x00000000u, 0x00000000u},
+    {0x3B9ACA00u, 0x00000000u, 0x00000000u},
+    {0x540BE400u, 0x00000002u, 0x00000000u},
+    {0x4876E800u, 0x00000017u, 0x00000000u},
+    {0xD4A51000u, 0x000000E8u, 0x00000000u},
+    {0x4E72A000u, 0x00000918u, 0x00000000u},
+    {0x107A4000u, 0x00005AF3u, 0x00000000u},
+    {0xA4C68000u, 0x00038D7Eu, 0x00000000u},
+    {0x6FC10000u, 0x002386F2u, 0x00000000u},
+    {0x5D8A0000u, 0x01634578u, 0x00000000u},
+    {0xA7640000u, 0x0DE0B6B3u, 0x00000000u},
+    {0x89E80000u, 0x8AC72304u, 0x00000000u},
+    {0x63100000u, 0x6BC75E2Du, 0x00000005u},
+    {0xDEA00000u, 0x35C9ADC5u, 0x00000036u},
+    {0xB2400000u, 0x19E0C9BAu, 0x0000021Eu},
+    {0xF6800000u, 0x02C7E14Au, 0x0000152Du},
+    {0xA1000000u, 0x1BCECCEDu, 0x0000D3C2u},
+    {0x4A000000u, 0x16140148u, 0x00084595u},
+    {0xE4000000u, 0xDCC80CD2u, 0x0052B7D2u},
+    {0xE8000000u, 0x9FD0803Cu, 0x033B2E3Cu},
+    {0x10000000u, 0x3E250261u, 0x204FCE5Eu},
+};
 
-  int sa = get_sign(&a);
-  int sb = get_sign(&b);
+// decimal_compare_mask works on this many pairs at a time.
+#define COMPARE_LANES 32
 
-  if (sa != sb) {
-    if (is_zero(a)) return sb ? 1 : -1;
-    if (is_zero(b)) return sa ? -1 : 1;
-    return sa ? -1 : 1;
+// Relation outcome tables indexed by compare result + 1 (lt, eq, gt).
+static const unsigned int kRelationBits[6] = {0x1u, 0x3u, 0x4u,
+                                              0x6u, 0x2u, 0x5u};
+
+static inline unsigned long long mul_32x32(unsigned int a, unsigned int b) {
+  return (unsigned long long)a * b;
+}
+
+// Key = sign * mantissa * 10^power as 192-bit two's complement with the top
+// bit flipped, so unsigned limb order equals numeric order. With power =
+// 28 - scale every decimal lands on the shared 10^-28 grid, so neither
+// scales nor signs need a branch, and +0 and -0 map to the same key.
+static inline void make_key(const decimal *value, int power,
+                            decimal_key *key) {
+  const unsigned int *p = kPow10Words[power];
+  unsigned int m0 = (unsigned int)value->bits[0];
+  unsigned int m1 = (unsigned int)value->bits[1];
+  unsigned int m2 = (unsigned int)value->bits[2];
+
+  // Schoolbook rows; each step is at most (2^32-1)^2 + 2 * (2^32-1).
+  unsigned long long t = mul_32x32(m0, p[0]);
+  unsigned int w0 = (unsigned int)t;
+  t = mul_32x32(m0, p[1]) + (t >> 32);
+  unsigned int w1 = (unsigned int)t;
+  t = mul_32x32(m0, p[2]) + (t >> 32);
+  unsigned int w2 = (unsigned int)t;
+  unsigned int w3 = (unsigned int)(t >> 32);
+
+  t = mul_32x32(m1, p[0]) + w1;
+  w1 = (unsigned int)t;
+  t = mul_32x32(m1, p[1]) + w2 + (t >> 32);
+  w2 = (unsigned int)t;
+  t = mul_32x32(m1, p[2]) + w3 + (t >> 32);
+  w3 = (unsigned int)t;
+  unsigned int w4 = (unsigned int)(t >> 32);
+
+  t = mul_32x32(m2, p[0]) + w2;
+  w2 = (unsigned int)t;
+  t = mul_32x32(m2, p[1]) + w3 + (t >> 32);
+  w3 = (unsigned int)t;
+  t = mul_32x32(m2, p[2]) + w4 + (t >> 32);
+  unsigned long long top = t;
+
+  unsigned long long mask =
+      0ull - (unsigned long long)((unsigned int)value->bits[3] >> 31);
+  unsigned long long limb = (w0 | (unsigned long long)w1 << 32) ^ mask;
+  limb -= mask;
+  unsigned long long carry = (mask & 1ull) & (limb == 0ull);
+  key->limbs[0] = limb;
+  limb = ((w2 | (unsigned long long)w3 << 32) ^ mask) + carry;
+  carry &= limb == 0ull;
+  key->limbs[1] = limb;
+  key->limbs[2] = ((top ^ mask) + carry) ^ 0x8000000000000000ull;
+}
+
+static inline int clamped_scale(const decimal *value) {
+  int scale = (int)(((unsigned int)value->bits[3] >> 16) & 0xFFu);
+  return scale > 28 ? 28 : scale;
+}
+
+void decimal_make_key(const decimal *value, decimal_key *key) {
+  make_key(value, 28 - clamped_scale(value), key);
+}
+
+static inline int key_compare(const decimal_key *key_1,
+                              const decimal_key *key_2) {
+  unsigned long long borrow = 0ull;
+  unsigned long long any = 0ull;
+  for (int i = 0; i < 3; i++) {
+    unsigned long long a = key_1->limbs[i];
+    unsigned long long b = key_2->limbs[i];
+    any |= a ^ b;
+    borrow = (a < b) | ((a == b) & borrow);
+  }
+  return (int)(any != 0ull) - 2 * (int)borrow;
+}
+
+int decimal_key_compare(const decimal_key *key_1, const decimal_key *key_2) {
+  return key_compare(key_1, key_2);
+}
+
+// Equal scales are the common case for column data and need no rescaling:
+// the signed 97-bit mantissas are compared directly, still without
+// branching on signs, zeros or magnitudes. Only the scale test branches,
+// and it is stable when a column shares one scale.
+static inline int compare_same_scale(const decimal *value_1,
+                                     const decimal *value_2) {
+  unsigned long long sign_1 =
+      0ull - (unsigned long long)((unsigned int)value_1->bits[3] >> 31);
+  unsigned long long sign_2 =
+      0ull - (unsigned long long)((unsigned int)value_2->bits[3] >> 31);
+  unsigned long long low_1 = (unsigned int)value_1->bits[0] |
+                             (unsigned long long)(unsigned int)value_1->bits[1]
+                                 << 32;
+  unsigned long long low_2 = (unsigned int)value_2->bits[0] |
+                             (unsigned long long)(unsigned int)value_2->bits[1]
+                                 << 32;
+  unsigned long long high_1 = (unsigned int)value_1->bits[2];
+  unsigned long long high_2 = (unsigned int)value_2->bits[2];
+
+  // Two's complement negation by mask; a zero low word carries into high.
+  unsigned long long carry_1 = sign_1 & (low_1 == 0ull);
+  unsigned long long carry_2 = sign_2 & (low_2 == 0ull);
+  low_1 = (low_1 ^ sign_1) - sign_1;
+  low_2 = (low_2 ^ sign_2) - sign_2;
+  high_1 = ((high_1 ^ sign_1) + (carry_1 & 1ull)) ^ 0x8000000000000000ull;
+  high_2 = ((high_2 ^ sign_2) + (carry_2 & 1ull)) ^ 0x8000000000000000ull;
+
+  int less = (high_1 < high_2) | ((high_1 == high_2) & (low_1 < low_2));
+  int differ = ((high_1 ^ high_2) | (low_1 ^ low_2)) != 0ull;
+  return differ - 2 * less;
+}
+
+static inline int compare_scaled(const decimal *value_1, int scale_1,
+                                  const decimal *value_2, int scale_2) {
+  int result = 0;
+  if (scale_1 == scale_2) {
+    result = compare_same_scale(value_1, value_2);
+  } else {
+    decimal_key key_1;
+    decimal_key key_2;
+    make_key(value_1, 28 - scale_1, &key_1);
+    make_key(value_2, 28 - scale_2, &key_2);
+    result = key_compare(&key_1, &key_2);
   }
+  return result;
+}
+
+int decimal_compare(decimal value_1, decimal value_2) {
+  return compare_scaled(&value_1, clamped_scale(&value_1), &value_2,
+                        clamped_scale(&value_2));
+}
+
+// Every pair first takes the same-scale compare on its sign and mantissa
+// words, as 32-bit lane operations without branches over a fixed block of
+// 32 lanes, which the compiler vectorizes. Pairs whose scales differ are
+// then redone one by one with keys.
+unsigned int decimal_compare_mask(const decimal *values_1,
+                                  const decimal *values_2, int count,
+                                  int relation) {
+  unsigned int mask = 0u;
+  if (values_1 != NULL && values_2 != NULL && relation >= 0 &&
+      relation < 6) {
+    unsigned int table = kRelationBits[relation];
+    unsigned int if_less = table & 1u;
+    unsigned int if_equal = (table >> 1) & 1u;
+    unsigned int if_greater = (table >> 2) & 1u;
+    decimal padded_1[COMPARE_LANES];
+    decimal padded_2[COMPARE_LANES];
+    const decimal *lanes_1 = values_1;
+    const decimal *lanes_2 = values_2;
+    unsigned int hits[COMPARE_LANES];
+    unsigned int rescale[COMPARE_LANES];
+    unsigned int pending = 0u;
+    if (count < 0) count = 0;
+    if (count > COMPARE_LANES) count = COMPARE_LANES;
+    // A partial block is padded with zeros, which compare equal.
+    if (count < COMPARE_LANES) {
+      size_t used = (size_t)count * sizeof(decimal);
+      size_t rest = sizeof(padded_1) - used;
+      memcpy(padded_1, values_1, used);
+      memcpy(padded_2, values_2, used);
+      memset((unsigned char *)padded_1 + used, 0, rest);
+      memset((unsigned char *)padded_2 + used, 0, rest);
+      lanes_1 = padded_1;
+      lanes_2 = padded_2;
+    }
+
+    for (int i = 0; i < COMPARE_LANES; i++) {
+      unsigned int low_1 = (unsigned int)lanes_1[i].bits[0];
+      unsigned int low_2 = (unsigned int)lanes_2[i].bits[0];
+      unsigned int mid_1 = (unsigned int)lanes_1[i].bits[1];
+      unsigned int mid_2 = (unsigned int)lanes_2[i].bits[1];
+      unsigned int high_1 = (unsigned int)lanes_1[i].bits[2];
+      unsigned int high_2 = (unsigned int)lanes_2[i].bits[2];
+      unsigned int flags_1 = (unsigned int)lanes_1[i].bits[3];
+      unsigned int flags_2 = (unsigned int)lanes_2[i].bits[3];
+      unsigned int scale_1 = (flags_1 >> 16) & 0xFFu;
+      unsigned int scale_2 = (flags_2 >> 16) & 0xFFu;
+      scale_1 = scale_1 > 28u ? 28u : scale_1;
+      scale_2 = scale_2 > 28u ? 28u : scale_2;
+      // Magnitudes, high word first.
+      unsigned int below = (high_1 < high_2) |
+                           ((high_1 == high_2) &
+                            ((mid_1 < mid_2) |
+                             ((mid_1 == mid_2) & (low_1 < low_2))));
+      unsigned int same = (high_1 == high_2) & (mid_1 == mid_2) &
+                          (low_1 == low_2);
+      unsigned int above = (below | same) ^ 1u;
+      // Signs, with -0 counted as positive.
+      unsigned int negative_1 =
+          (flags_1 >> 31) & ((low_1 | mid_1 | high_1) != 0u);
+      unsigned int negative_2 =
+          (flags_2 >> 31) & ((low_2 | mid_2 | high_2) != 0u);
+      unsigned int mixed = negative_1 ^ negative_2;
+      // Two negatives order by the larger magnitude.
+      unsigned int ordered = below ^ (negative_1 & (below ^ above));
+      unsigned int less = (mixed & negative_1) | ((mixed ^ 1u) & ordered);
+      unsigned int equal = (mixed ^ 1u) & same;
+      hits[i] = (less & if_less) | (equal & if_equal) |
+                (((less | equal) ^ 1u) & if_greater);
+      rescale[i] = scale_1 != scale_2;
+    }
 
-  normalize(&a, &b);
+    for (int i = 0; i < count; i++) {
+      mask |= hits[i] << i;
+      pending |= rescale[i] << i;
+    }
+    for (int i = 0; pending != 0u; i++, pending >>= 1) {
+      if (pending & 1u) {
+        decimal_key key_1;
+        decimal_key key_2;
+        decimal_make_key(&values_1[i], &key_1);
+        decimal_make_key(&values_2[i], &key_2);
+        int order = key_compare(&key_1, &key_2);
+        mask &= ~(1u << i);
+        mask |= ((table >> (order + 1)) & 1u) << i;
+      }
+    }
+  }
+  return mask;
+}
 
-  int mag = compare_abs(a, b);
-  return sa ? -mag : mag;
+// Same order as decimal_compare for well-formed operands; the scales are
+// used as stored instead of being clamped to 28.
+int decimal_compare_unchecked(decimal value_1, decimal value_2) {
+  int scale_1 = (int)(((unsigned int)value_1.bits[3] >> 16) & 0xFFu);
+  int scale_2 = (int)(((unsigned int)value_2.bits[3] >> 16) & 0xFFu);
+  DECIMAL_ASSERT_VALID(value_1);
+  DECIMAL_ASSERT_VALID(value_2);
+  return compare_scaled(&value_1, scale_1, &value_2, scale_2);
 }
 
-int is_less(decimal a, decimal b) { return cmp_core(a, b) < 0; }
+int is_less(decimal a, decimal b) { return decimal_compare(a, b) < 0; }
 int is_less_or_equal(decimal a, decimal b) {
-  return cmp_core(a, b) <= 0;
+  return decimal_compare(a, b) <= 0;
 }
-int is_greater(decimal a, decimal b) { return cmp_core(a, b) > 0; }
+int is_greater(decimal a, decimal b) { return decimal_compare(a, b) > 0; }
 int is_greater_or_equal(decimal a, decimal b) {
-  return cmp_core(a, b) >= 0;
+  return decimal_compare(a, b) >= 0;
 }
-int is_equal(decimal a, decimal b) { return cmp_core(a, b) == 0; }
+int is_equal(decimal a, decimal b) { return decimal_compare(a, b) == 0; }
 int is_not_equal(decimal a, decimal b) {
-  return cmp_core(a, b) != 0;
+  return decimal_compare(a, b) != 0;
+}
+
+int is_less_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) < 0;
+}
+int is_less_or_equal_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) <= 0;
+}
+int is_greater_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) > 0;
+}
+int is_greater_or_equal_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) >= 0;
+}
+int is_equal_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) == 0;
+}
+int is_not_equal_unchecked(decimal a, decimal b) {
+  return decimal_compare_unchecked(a, b) != 0;
 }
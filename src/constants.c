@@ -0,0 +1,44 @@
+#include "decimal.h"
+
+const decimal decimal_powers_of_ten[29] = {
+    DECIMAL_INIT(1, 0),
+    DECIMAL_INIT(10, 0),
+    DECIMAL_INIT(100, 0),
+    DECIMAL_INIT(1000, 0),
+    DECIMAL_INIT(10000, 0),
+    DECIMAL_INIT(100000, 0),
+    DECIMAL_INIT(1000000, 0),
+    DECIMAL_INIT(10000000, 0),
+    DECIMAL_INIT(100000000, 0),
+    DECIMAL_INIT(1000000000, 0),
+    DECIMAL_INIT(10000000000ll, 0),
+    DECIMAL_INIT(100000000000ll, 0),
+    DECIMAL_INIT(1000000000000ll, 0),
+    DECIMAL_INIT(10000000000000ll, 0),
+    DECIMAL_INIT(100000000000000ll, 0),
+    DECIMAL_INIT(1000000000000000ll, 0),
+    DECIMAL_INIT(10000000000000000ll, 0),
+    DECIMAL_INIT(100000000000000000ll, 0),
+    DECIMAL_INIT(1000000000000000000ll, 0),
+    DECIMAL_INIT_WORDS(0x89E80000u, 0x8AC72304u, 0x00000000u, 0, 0),
+    DECIMAL_INIT_WORDS(0x63100000u, 0x6BC75E2Du, 0x00000005u, 0, 0),
+    DECIMAL_INIT_WORDS(0xDEA00000u, 0x35C9ADC5u, 0x00000036u, 0, 0),
+    DECIMAL_INIT_WORDS(0xB2400000u, 0x19E0C9BAu, 0x0000021Eu, 0, 0),
+    DECIMAL_INIT_WORDS(0xF6800000u, 0x02C7E14Au, 0x0000152Du, 0, 0),
+    DECIMAL_INIT_WORDS(0xA1000000u, 0x1BCECCEDu, 0x0000D3C2u, 0, 0),
+    DECIMAL_INIT_WORDS(0x4A000000u, 0x16140148u, 0x00084595u, 0, 0),
+    DECIMAL_INIT_WORDS(0xE4000000u, 0xDCC80CD2u, 0x0052B7D2u, 0, 0),
+    DECIMAL_INIT_WORDS(0xE8000000u, 0x9FD0803Cu, 0x033B2E3Cu, 0, 0),
+    DECIMAL_INIT_WORDS(0x10000000u, 0x3E250261u, 0x204FCE5Eu, 0, 0)};
+
+const decimal decimal_inverse_powers_of_ten[29] = {
+    DECIMAL_INIT(1, 0),  DECIMAL_INIT(1, 1),  DECIMAL_INIT(1, 2),
+    DECIMAL_INIT(1, 3),  DECIMAL_INIT(1, 4),  DECIMAL_INIT(1, 5),
+    DECIMAL_INIT(1, 6),  DECIMAL_INIT(1, 7),  DECIMAL_INIT(1, 8),
+    DECIMAL_INIT(1, 9),  DECIMAL_INIT(1, 10), DECIMAL_INIT(1, 11),
+    DECIMAL_INIT(1, 12), DECIMAL_INIT(1, 13), DECIMAL_INIT(1, 14),
+    DECIMAL_INIT(1, 15), DECIMAL_INIT(1, 16), DECIMAL_INIT(1, 17),
+    DECIMAL_INIT(1, 18), DECIMAL_INIT(1, 19), DECIMAL_INIT(1, 20),
+    DECIMAL_INIT(1, 21), DECIMAL_INIT(1, 22), DECIMAL_INIT(1, 23),
+    DECIMAL_INIT(1, 24), DECIMAL_INIT(1, 25), DECIMAL_INIT(1, 26),
+    DECIMAL_INIT(1, 27), DECIMAL_INIT(1, 28)};
@@ -0,0 +1,29 @@
+#include "decimal.h"
+
+// Each thread owns its context, so reads and updates never need a lock and
+// never contend with other threads.
+static _Thread_local decimal_context current_context;
+
+decimal_context *decimal_context_get(void) { return &current_context; }
+
+void decimal_context_reset(void) {
+  current_context.status = 0u;
+  current_context.options = 0u;
+}
+
+void decimal_context_record(int flag) {
+  unsigned int status = 0u;
+  if (flag == ARITHMETIC_BIG)
+    status = DECIMAL_STATUS_OVERFLOW;
+  else if (flag == ARITHMETIC_SMALL)
+    status = DECIMAL_STATUS_UNDERFLOW;
+  else if (flag == ARITHMETIC_DIV_BY_ZERO)
+    status = DECIMAL_STATUS_DIV_BY_ZERO;
+  else if (flag == ARITHMETIC_BAD_INPUT)
+    status = DECIMAL_STATUS_BAD_INPUT;
+  current_context.status |= status;
+}
+
+void decimal_context_raise(unsigned int status) {
+  current_context.status |= status;
+}
@@ -0,0 +1,483 @@
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "decimal.h"
+
+// Below this many rows per thread one thread parses faster than several
+// can be started.
+#define CSV_MIN_ROWS 2048
+
+// Two buffers of twice the block size. A read fills the upper half of one
+// while rows are parsed from the other; the unfinished row at the end of
+// the old buffer is then copied just below the new bytes, so every row
+// lies in one piece.
+struct decimal_csv_input {
+  int fd;
+  size_t block_size;
+  char *buffers[2];
+  int current;  // the buffer the cursor is in
+  int pending;  // a read into the other buffer has been requested
+  int started;  // ...and runs on thread
+  pthread_t thread;
+  size_t got;
+  int error;
+};
+
+typedef struct {
+  const decimal_csv_reader *reader;
+  decimal *const *columns;
+  int *flags;
+  const char *begin;
+  const char *end;
+  size_t first_row;
+  int flag;
+} csv_chunk;
+
+static int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static int is_blank(char c) { return c == ' ' || c == '\t'; }
+
+// [+-]digits[.digits], either side of the point may be empty but not
+// both, with blanks and one pair of double quotes around it. Up to
+// WIDE_DECIMAL_DIGITS significant digits are taken, as in expression
+// literals; more than 28 decimal places round half to even.
+static int parse_number(const char *text, const char *end, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  unsigned long long small = 0u;
+  wide_int mantissa;
+  int digits = 0;
+  int scale = 0;
+  int sign = 0;
+  int seen_point = 0;
+  int any_digit = 0;
+
+  while (text < end && is_blank(*text)) text++;
+  while (end > text && is_blank(end[-1])) end--;
+  if (end - text >= 2 && *text == '"' && end[-1] == '"') {
+    text++;
+    end--;
+  }
+  if (text < end && (*text == '-' || *text == '+')) sign = *text++ == '-';
+  for (; text < end && flag == ARITHMETIC_OK; text++) {
+    char c = *text;
+    if (c == '.' && !seen_point) {
+      seen_point = 1;
+    } else if (!is_digit(c)) {
+      flag = ARITHMETIC_BAD_INPUT;
+    } else {
+      any_digit = 1;
+      scale += seen_point;
+      // Leading zeros are not significant digits.
+      if (digits > 0 || c != '0') digits++;
+      if (digits > WIDE_DECIMAL_DIGITS) {
+        flag = ARITHMETIC_BAD_INPUT;
+      } else if (digits <= 19) {
+        // 19 digits always fit in 64 bits.
+        small = small * 10u + (unsigned long long)(c - '0');
+      } else {
+        if (digits == 20) {
+          wide_zero(&mantissa);
+          mantissa.words[0] = (unsigned int)small;
+          mantissa.words[1] = (unsigned int)(small >> 32);
+        }
+        wide_mul_u32(&mantissa, 10u);
+        wide_add_u32(&mantissa, (unsigned int)(c - '0'));
+      }
+    }
+  }
+  if (flag == ARITHMETIC_OK && !any_digit) flag = ARITHMETIC_BAD_INPUT;
+
+  if (flag == ARITHMETIC_OK && digits <= 19 && scale <= 28) {
+    result->bits[0] = (int)(unsigned int)small;
+    result->bits[1] = (int)(unsigned int)(small >> 32);
+    result->bits[2] = 0;
+    result->bits[3] = (int)(((unsigned int)scale << 16) |
+                            ((unsigned int)sign << 31));
+  } else if (flag == ARITHMETIC_OK) {
+    if (digits <= 19) {
+      wide_zero(&mantissa);
+      mantissa.words[0] = (unsigned int)small;
+      mantissa.words[1] = (unsigned int)(small >> 32);
+    }
+    flag = wide_to_decimal(&mantissa, scale, sign, result);
+  }
+  if (flag != ARITHMETIC_OK) decimal_zero(result);
+  return flag;
+}
+
+// Fields of [line, end) up to the last requested one; a requested field
+// the row does not have is BAD_INPUT and reads as zero.
+static int parse_row(const decimal_csv_reader *reader, const char *line,
+                     const char *end, decimal *const *columns, size_t row) {
+  int flag = ARITHMETIC_OK;
+  int present = 1;
+  if (end > line && end[-1] == '\n') end--;
+  if (end > line && end[-1] == '\r') end--;
+  for (int field = 0; field <= reader->last_field; field++) {
+    const char *stop = line;
+    int quoted = 0;
+    // A delimiter inside double quotes belongs to the field; a doubled
+    // quote toggles twice and changes nothing.
+    while (stop < end && (quoted || *stop != reader->delimiter)) {
+      if (*stop == '"') quoted = !quoted;
+      stop++;
+    }
+    int column = reader->columns[field];
+    if (column >= 0) {
+      int status = ARITHMETIC_BAD_INPUT;
+      if (present) status = parse_number(line, stop, &columns[column][row]);
+      else decimal_zero(&columns[column][row]);
+      if (flag == ARITHMETIC_OK) flag = status;
+    }
+    if (stop < end) line = stop + 1;
+    else present = 0;
+  }
+  return flag;
+}
+
+// Rows of [begin, end), each ending in a newline except possibly the last,
+// into the columns from first_row on.
+static int parse_range(const decimal_csv_reader *reader, const char *begin,
+                       const char *end, decimal *const *columns,
+                       int *flags, size_t first_row) {
+  int flag = ARITHMETIC_OK;
+  size_t row = first_row;
+  while (begin < end) {
+    const char *newline = memchr(begin, '\n', (size_t)(end - begin));
+    const char *next = newline != NULL ? newline + 1 : end;
+    int status = parse_row(reader, begin, next, columns, row);
+    if (flags != NULL) flags[row] = status;
+    if (flag == ARITHMETIC_OK) flag = status;
+    begin = next;
+    row++;
+  }
+  return flag;
+}
+
+static size_t count_rows(const char *begin, const char *end) {
+  size_t rows = 0;
+  while (begin < end) {
+    const char *newline = memchr(begin, '\n', (size_t)(end - begin));
+    begin = newline != NULL ? newline + 1 : end;
+    rows++;
+  }
+  return rows;
+}
+
+static void *count_chunk(void *argument) {
+  csv_chunk *chunk = argument;
+  chunk->first_row = count_rows(chunk->begin, chunk->end);
+  return NULL;
+}
+
+static void *parse_chunk(void *argument) {
+  csv_chunk *chunk = argument;
+  chunk->flag = parse_range(chunk->reader, chunk->begin, chunk->end,
+                            chunk->columns, chunk->flags, chunk->first_row);
+  return NULL;
+}
+
+// The `rows` rows from the cursor to end. Several threads each take a
+// byte range cut at row boundaries, count its rows, and then parse them
+// into place.
+static int parse_rows(const decimal_csv_reader *reader, const char *end,
+                      size_t rows, decimal *const *columns, int *flags,
+                      size_t first_row, int threads) {
+  int flag = ARITHMETIC_OK;
+  const char *begin = reader->cursor;
+  csv_chunk chunks[DECIMAL_MAX_THREADS];
+  if (threads > DECIMAL_MAX_THREADS) threads = DECIMAL_MAX_THREADS;
+  if (threads > 1 && rows / (size_t)threads < CSV_MIN_ROWS)
+    threads = (int)(rows / CSV_MIN_ROWS);
+
+  if (threads <= 1) {
+    flag = parse_range(reader, begin, end, columns, flags, first_row);
+  } else {
+    size_t length = (size_t)(end - begin);
+    const char *from = begin;
+    for (int c = 0; c < threads; c++) {
+      const char *to = end;
+      if (c + 1 < threads) {
+        to = begin + length * (size_t)(c + 1) / (size_t)threads;
+        if (to > from && to[-1] != '\n') {
+          const char *newline = memchr(to, '\n', (size_t)(end - to));
+          to = newline != NULL ? newline + 1 : end;
+        }
+        if (to < from) to = from;
+      }
+      chunks[c] = (csv_chunk){reader, columns, flags, from, to, 0,
+                              ARITHMETIC_OK};
+      from = to;
+    }
+    decimal_run_parallel(threads, count_chunk, chunks, sizeof(*chunks));
+    for (int c = 0; c < threads; c++) {
+      size_t count = chunks[c].first_row;
+      chunks[c].first_row = first_row;
+      first_row += count;
+    }
+    decimal_run_parallel(threads, parse_chunk, chunks, sizeof(*chunks));
+    for (int c = 0; c < threads && flag == ARITHMETIC_OK; c++)
+      flag = chunks[c].flag;
+  }
+  return flag;
+}
+
+static void *read_block(void *argument) {
+  decimal_csv_input *input = argument;
+  char *block = input->buffers[!input->current] + input->block_size;
+  int done = 0;
+  input->got = 0;
+  input->error = 0;
+  while (!done && input->got < input->block_size) {
+    ssize_t got = read(input->fd, block + input->got,
+                       input->block_size - input->got);
+    if (got > 0) {
+      input->got += (size_t)got;
+    } else if (got == 0) {
+      done = 1;
+    } else if (errno != EINTR) {
+      input->error = errno;
+      done = 1;
+    }
+  }
+  return NULL;
+}
+
+// Starts filling the buffer the cursor is not in, on its own thread so
+// that the read overlaps parsing.
+static void start_read(decimal_csv_input *input) {
+  input->pending = 1;
+  input->started =
+      pthread_create(&input->thread, NULL, read_block, input) == 0;
+}
+
+static void finish_read(decimal_csv_input *input) {
+  if (input->started) pthread_join(input->thread, NULL);
+  else read_block(input);
+  input->pending = 0;
+  input->started = 0;
+}
+
+// Switches to the block read ahead, with the unfinished row at the cursor
+// moved in front of it, and starts reading the next one.
+static void refill(decimal_csv_reader *reader) {
+  decimal_csv_input *input = reader->input;
+  size_t tail = (size_t)(reader->limit - reader->cursor);
+  if (tail > input->block_size) {
+    reader->error = ERANGE;
+    reader->eof = 1;
+  } else {
+    finish_read(input);
+    char *next = input->buffers[!input->current] + input->block_size;
+    memcpy(next - tail, reader->cursor, tail);
+    input->current = !input->current;
+    reader->cursor = next - tail;
+    reader->limit = next + input->got;
+    reader->error = input->error;
+    // A short read means the end of the input.
+    reader->eof = input->error != 0 || input->got < input->block_size;
+    if (!reader->eof) start_read(input);
+  }
+}
+
+// Complete rows from the cursor on, at most `capacity` of them; *end is
+// set past the last one. At the end of the input the final row needs no
+// newline.
+static size_t find_rows(const decimal_csv_reader *reader, size_t capacity,
+                        const char **end) {
+  const char *row = reader->cursor;
+  size_t rows = 0;
+  int more = 1;
+  while (more && rows < capacity && row < reader->limit) {
+    const char *newline =
+        memchr(row, '\n', (size_t)(reader->limit - row));
+    more = newline != NULL || (reader->eof && reader->error == 0);
+    if (more) {
+      row = newline != NULL ? newline + 1 : reader->limit;
+      rows++;
+    }
+  }
+  *end = row;
+  return rows;
+}
+
+// Reads up to `capacity` rows, parsing them only when columns is not NULL.
+static int consume(decimal_csv_reader *reader, decimal *const *columns,
+                   int *flags, size_t capacity, int threads, size_t *rows) {
+  int flag = ARITHMETIC_OK;
+  size_t done = 0;
+  int more = 1;
+  while (more && done < capacity && reader->error == 0) {
+    const char *end;
+    size_t found = find_rows(reader, capacity - done, &end);
+    if (found > 0) {
+      if (columns != NULL) {
+        int status = parse_rows(reader, end, found, columns, flags, done,
+                                threads);
+        if (flag == ARITHMETIC_OK) flag = status;
+      }
+      reader->cursor = end;
+      reader->row += found;
+      done += found;
+    } else if (!reader->eof) {
+      refill(reader);
+    } else {
+      more = 0;
+    }
+  }
+  if (reader->error != 0) flag = ARITHMETIC_BAD_INPUT;
+  if (rows != NULL) *rows = done;
+  return flag;
+}
+
+static int open_columns(decimal_csv_reader *reader, char delimiter,
+                        const int *fields, int column_count) {
+  int flag = ARITHMETIC_OK;
+  reader->input = NULL;
+  reader->cursor = NULL;
+  reader->limit = NULL;
+  reader->eof = 1;
+  reader->error = 0;
+  reader->delimiter = delimiter;
+  reader->column_count = column_count;
+  reader->last_field = -1;
+  reader->row = 0;
+  memset(reader->columns, -1, sizeof(reader->columns));
+  if (fields == NULL || column_count < 1 ||
+      column_count > DECIMAL_CSV_MAX_COLUMNS || delimiter == '"' ||
+      delimiter == '\n' || delimiter == '\r')
+    flag = ARITHMETIC_BAD_INPUT;
+  for (int c = 0; c < column_count && flag == ARITHMETIC_OK; c++) {
+    int field = fields[c];
+    if (field < 0 || field >= DECIMAL_CSV_MAX_FIELDS ||
+        reader->columns[field] >= 0) {
+      flag = ARITHMETIC_BAD_INPUT;
+    } else {
+      reader->columns[field] = (signed char)c;
+      if (field > reader->last_field) reader->last_field = field;
+    }
+  }
+  // A reader that failed to open reads as empty and broken.
+  if (flag != ARITHMETIC_OK) reader->error = EINVAL;
+  return flag;
+}
+
+// Parses one field as decimal_csv_read does: [+-]digits[.digits] with
+// optional surrounding blanks and double quotes. result is zero on failure.
+int decimal_csv_parse(const char *text, size_t length, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (text == NULL || result == NULL) flag = ARITHMETIC_BAD_INPUT;
+  else flag = parse_number(text, text + length, result);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Rows of data[0..size) separated by '\n' (an optional '\r' before it is
+// dropped). The buffer must outlive the reader.
+int decimal_csv_open_buffer(decimal_csv_reader *reader, const char *data,
+                            size_t size, char delimiter, const int *fields,
+                            int column_count) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (reader != NULL)
+    flag = open_columns(reader, delimiter, fields, column_count);
+  if (flag == ARITHMETIC_OK && data == NULL && size > 0) {
+    reader->error = EINVAL;
+    flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK) {
+    reader->cursor = data;
+    reader->limit = data + size;
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Rows read from fd through two buffers of 2 * block_size bytes (0 means
+// DECIMAL_CSV_BLOCK_SIZE) taken from the arena: the next block is read on
+// a second thread while the current one is parsed. A row may be at most
+// block_size bytes long. Field fields[c] of each row goes to column c;
+// rows may not contain newlines inside quotes. The fd stays open; call
+// decimal_csv_close before the arena is reset.
+int decimal_csv_open_fd(decimal_csv_reader *reader, int fd,
+                        size_t block_size, char delimiter, const int *fields,
+                        int column_count, decimal_arena *arena) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  decimal_csv_input *input = NULL;
+  if (block_size == 0) block_size = DECIMAL_CSV_BLOCK_SIZE;
+  if (reader != NULL)
+    flag = open_columns(reader, delimiter, fields, column_count);
+  if (flag == ARITHMETIC_OK && (fd < 0 || arena == NULL)) {
+    reader->error = EINVAL;
+    flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK) {
+    input = decimal_arena_alloc(arena, sizeof(*input));
+    if (input != NULL) {
+      input->buffers[0] = decimal_arena_alloc(arena, 2 * block_size);
+      input->buffers[1] = decimal_arena_alloc(arena, 2 * block_size);
+    }
+    if (input == NULL || input->buffers[0] == NULL ||
+        input->buffers[1] == NULL) {
+      reader->error = ENOMEM;
+      flag = ARITHMETIC_BAD_INPUT;
+    }
+  }
+  if (flag == ARITHMETIC_OK) {
+    input->fd = fd;
+    input->block_size = block_size;
+    input->current = 0;
+    input->got = 0;
+    input->error = 0;
+    reader->input = input;
+    reader->cursor = input->buffers[0] + block_size;
+    reader->limit = reader->cursor;
+    reader->eof = 0;
+    start_read(input);
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Drops the next `count` rows, such as a header line.
+int decimal_csv_skip_rows(decimal_csv_reader *reader, size_t count) {
+  int flag = ARITHMETIC_BAD_INPUT;
+  if (reader != NULL) flag = consume(reader, NULL, NULL, count, 1, NULL);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Parses up to `capacity` rows into columns[0..column_count), each with
+// room for `capacity` values, and sets *rows to the number read; 0 rows
+// means the input is exhausted. Fields that do not parse read as zero,
+// flags (if not NULL) gets each row's first failing status, and the call
+// returns the first failure. A failed read or an over-long row stops the
+// reader with BAD_INPUT and reader->error set. threads > 1 parses large
+// batches on several threads.
+int decimal_csv_read(decimal_csv_reader *reader, decimal *const *columns,
+                     int *flags, size_t capacity, int threads,
+                     size_t *rows) {
+  int flag = ARITHMETIC_OK;
+  if (rows != NULL) *rows = 0;
+  if (reader == NULL || rows == NULL || columns == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    for (int c = 0; c < reader->column_count; c++)
+      if (columns[c] == NULL) flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK)
+    flag = consume(reader, columns, flags, capacity, threads, rows);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Waits for a read still in flight. The reader's memory stays in the
+// arena passed to decimal_csv_open_fd.
+void decimal_csv_close(decimal_csv_reader *reader) {
+  if (reader != NULL && reader->input != NULL) {
+    if (reader->input->pending) finish_read(reader->input);
+    reader->input = NULL;
+    reader->eof = 1;
+    reader->cursor = reader->limit;
+  }
+}
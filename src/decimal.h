@@ -7,6 +7,16 @@
 #define ARITHMETIC_DIV_BY_ZERO 3
 #define ARITHMETIC_BAD_INPUT 4
 
+#define DECIMAL_STATUS_OVERFLOW 0x01u
+#define DECIMAL_STATUS_UNDERFLOW 0x02u
+#define DECIMAL_STATUS_DIV_BY_ZERO 0x04u
+#define DECIMAL_STATUS_BAD_INPUT 0x08u
+#define DECIMAL_STATUS_INEXACT 0x10u
+
+// Bits for decimal_context.options.
+// mul and mul_unchecked pass every product through decimal_reduce.
+#define DECIMAL_OPTION_REDUCE_MUL 0x01u
+
 #include <float.h>
 #include <limits.h>
 #include <math.h>
@@ -19,6 +29,253 @@ typedef struct {
   int bits[4];
 } decimal;
 
+// Decimals built by the compiler. DECIMAL_INIT and DECIMAL_INIT_WORDS are
+// brace initializers for static data; DECIMAL_LIT is the same value as a
+// compound literal for use in expressions. DECIMAL_LIT(12345, 2) is 123.45
+// and DECIMAL_LIT(-1, 8) is -0.00000001. The value must fit in a long long
+// and the scale must be in 0..28.
+#define DECIMAL_MAGNITUDE_(value)                   \
+  ((value) < 0 ? 0ull - (unsigned long long)(value) \
+               : (unsigned long long)(value))
+#define DECIMAL_INIT_WORDS(low, mid, high, scale, sign) \
+  {{(int)(unsigned int)(low), (int)(unsigned int)(mid), \
+    (int)(unsigned int)(high),                          \
+    (int)(((unsigned int)(scale) << 16) | ((sign) ? 0x80000000u : 0u))}}
+#define DECIMAL_INIT(value, scale)                               \
+  DECIMAL_INIT_WORDS(DECIMAL_MAGNITUDE_(value),                  \
+                     DECIMAL_MAGNITUDE_(value) >> 32, 0u, scale, \
+                     (value) < 0)
+#define DECIMAL_LIT(value, scale) ((decimal)DECIMAL_INIT(value, scale))
+
+#define DECIMAL_ZERO DECIMAL_LIT(0, 0)
+#define DECIMAL_ONE DECIMAL_LIT(1, 0)
+#define DECIMAL_MINUS_ONE DECIMAL_LIT(-1, 0)
+#define DECIMAL_MAX ((decimal)DECIMAL_INIT_WORDS(~0u, ~0u, ~0u, 0, 0))
+#define DECIMAL_MIN ((decimal)DECIMAL_INIT_WORDS(~0u, ~0u, ~0u, 0, 1))
+
+// DECIMAL_DEBUG turns the documented preconditions of the _unchecked
+// functions into assertions; otherwise they compile to nothing.
+#ifdef DECIMAL_DEBUG
+#include <assert.h>
+#define DECIMAL_ASSERT(condition) assert(condition)
+#else
+#define DECIMAL_ASSERT(condition) ((void)0)
+#endif
+#define DECIMAL_ASSERT_VALID(value) DECIMAL_ASSERT(decimal_is_valid(value))
+
+// Building with -DDECIMAL_USE_INT128 moves the multiply, divide, rescale
+// and rounding cores onto 64-bit limbs with unsigned __int128
+// intermediates. Compilers without the type keep the portable code.
+#if defined(DECIMAL_USE_INT128) && defined(__SIZEOF_INT128__)
+#define DECIMAL_HAVE_INT128 1
+__extension__ typedef unsigned __int128 decimal_u128;
+#endif
+
+// Building with -DDECIMAL_INSTRUMENT counts calls, cycles and slow-path
+// events per thread; see decimal_instrument_snapshot. Without it the hooks
+// compile to nothing.
+#define DECIMAL_OP_ADD 0
+#define DECIMAL_OP_SUB 1
+#define DECIMAL_OP_MUL 2
+#define DECIMAL_OP_DIV 3
+#define DECIMAL_OP_DIVMOD 4
+#define DECIMAL_OP_MOD 5
+#define DECIMAL_OP_COUNT 6
+
+#define DECIMAL_EVENT_ADD_RESCALE 0
+#define DECIMAL_EVENT_MUL_GENERAL 1
+#define DECIMAL_EVENT_MUL_OVERFLOW 2
+#define DECIMAL_EVENT_BANK_ROUND 3
+#define DECIMAL_EVENT_NORMALIZE 4
+#define DECIMAL_EVENT_NORMALIZE_STEP 5
+#define DECIMAL_EVENT_DIV_STEP 6
+#define DECIMAL_EVENT_COUNT 7
+
+// Bucket b of a cycle histogram counts calls of [2^b, 2^(b+1)) ticks; the
+// last bucket also takes everything longer.
+#define DECIMAL_INSTRUMENT_BUCKETS 24
+
+#ifdef DECIMAL_INSTRUMENT
+#define DECIMAL_INSTRUMENT_BEGIN() \
+  unsigned long long instrument_start_ = decimal_instrument_ticks()
+#define DECIMAL_INSTRUMENT_END(op, value_1, value_2) \
+  decimal_instrument_op(op, instrument_start_, &(value_1), &(value_2))
+#define DECIMAL_INSTRUMENT_EVENT(event) decimal_instrument_event(event)
+#else
+#define DECIMAL_INSTRUMENT_BEGIN() ((void)0)
+#define DECIMAL_INSTRUMENT_END(op, value_1, value_2) ((void)0)
+#define DECIMAL_INSTRUMENT_EVENT(event) ((void)0)
+#endif
+
+typedef struct {
+  unsigned long long limbs[3];
+} decimal_key;
+
+#define DECIMAL_CMP_LT 0
+#define DECIMAL_CMP_LE 1
+#define DECIMAL_CMP_GT 2
+#define DECIMAL_CMP_GE 3
+#define DECIMAL_CMP_EQ 4
+#define DECIMAL_CMP_NE 5
+
+typedef struct {
+  unsigned int status;
+  unsigned int options;
+} decimal_context;
+
+typedef struct {
+  unsigned long long calls[DECIMAL_OP_COUNT];
+  unsigned long long cycles[DECIMAL_OP_COUNT][DECIMAL_INSTRUMENT_BUCKETS];
+  unsigned long long events[DECIMAL_EVENT_COUNT];
+  // Operand scales seen by the instrumented operations, two per call.
+  unsigned long long scales[29];
+} decimal_instrument_stats;
+
+#define WIDE_WORDS 8
+
+typedef struct {
+  unsigned int words[WIDE_WORDS];
+} wide_int;
+
+// Intermediate values of the elementary functions carry 38 significant
+// digits: enough guard digits for a 29-digit result, while the product of
+// two mantissas and a mantissa scaled by 10^38 still fit in a wide_int.
+#define WIDE_DECIMAL_DIGITS 38
+// Once an intermediate leaves 10^+-WIDE_DECIMAL_RANGE the final result is
+// known to overflow or underflow a decimal.
+#define WIDE_DECIMAL_RANGE 100
+
+// value = (-1)^sign * mantissa * 10^exponent, with the mantissa kept in
+// [10^37, 10^38) unless the value is zero.
+typedef struct {
+  wide_int mantissa;
+  int exponent;
+  int sign;
+} wide_decimal;
+
+typedef struct {
+  decimal payment;
+  decimal interest;
+  decimal principal;
+  decimal balance;
+} decimal_amortization_row;
+
+typedef struct {
+  wide_int mantissa;
+  wide_int reciprocal;
+  int scale;
+  int sign;
+} decimal_divisor;
+
+// A compiled formula: a postfix program over the named inputs and the
+// literals in the source. See decimal_expression_compile.
+#define DECIMAL_EXPRESSION_MAX_OPS 64
+#define DECIMAL_EXPRESSION_MAX_CONSTANTS 16
+#define DECIMAL_EXPRESSION_MAX_INPUTS 16
+#define DECIMAL_EXPRESSION_MAX_DEPTH 16
+
+typedef struct {
+  unsigned char opcode;
+  unsigned char operand;
+} decimal_expression_op;
+
+typedef struct {
+  decimal_expression_op ops[DECIMAL_EXPRESSION_MAX_OPS];
+  wide_decimal constants[DECIMAL_EXPRESSION_MAX_CONSTANTS];
+  int op_count;
+  int constant_count;
+  int input_count;
+  int stack_depth;
+} decimal_expression;
+
+// Bump allocator with blocks that survive decimal_arena_reset.
+typedef struct decimal_arena_block decimal_arena_block;
+
+typedef struct {
+  decimal_arena_block *first;
+  decimal_arena_block *current;
+  size_t block_size;
+  // Bytes obtained from malloc so far.
+  size_t capacity;
+} decimal_arena;
+
+// A position in an arena to rewind to; see decimal_arena_rewind.
+typedef struct {
+  decimal_arena_block *block;
+  size_t used;
+} decimal_arena_mark;
+
+// value = (-1)^sign * limbs * 10^-scale with little-endian 32-bit limbs
+// owned by an arena; length is 0 for zero. The scale is not limited to 28.
+typedef struct {
+  unsigned int *limbs;
+  int length;
+  int scale;
+  int sign;
+} bigdecimal;
+
+// A decimal that escalates to a bigdecimal when a result overflows.
+typedef struct {
+  decimal value;
+  bigdecimal big;
+  int is_big;
+} decimal_number;
+
+// The threaded kernels split their work over at most this many threads.
+#define DECIMAL_MAX_THREADS 64
+
+// Per-group results of decimal_group_by_int and decimal_group_by_decimal.
+// Group g first appears at row first_rows[g]; the aggregate of value
+// column v is aggregates[g * value_count + v]. The arrays live in the
+// arena passed to the call.
+#define DECIMAL_GROUP_MAX_VALUES 8
+
+typedef struct {
+  decimal sum;
+  decimal min;
+  decimal max;
+} decimal_aggregate;
+
+typedef struct {
+  size_t group_count;
+  int value_count;
+  size_t *first_rows;
+  size_t *counts;
+  decimal_aggregate *aggregates;
+} decimal_groups;
+
+// Streaming reader for delimited text. Field fields[c] of every row is
+// parsed into output column c; see decimal_csv_open_fd.
+#define DECIMAL_CSV_MAX_COLUMNS 16
+#define DECIMAL_CSV_MAX_FIELDS 256
+#define DECIMAL_CSV_BLOCK_SIZE (1u << 20)
+
+// Read-ahead state of a reader over a file descriptor.
+typedef struct decimal_csv_input decimal_csv_input;
+
+typedef struct {
+  decimal_csv_input *input;  // NULL when reading from a buffer
+  const char *cursor;        // next unread byte
+  const char *limit;         // end of the bytes read so far
+  int eof;                   // no bytes follow limit
+  // errno of a failed read, or ERANGE for a row longer than a block.
+  int error;
+  char delimiter;
+  int column_count;
+  int last_field;
+  // Rows consumed so far, skipped ones included.
+  size_t row;
+  signed char columns[DECIMAL_CSV_MAX_FIELDS];  // -1: field not parsed
+} decimal_csv_reader;
+
+// decimal_powers_of_ten[k] is 10^k and decimal_inverse_powers_of_ten[k]
+// is 10^-k, for k in 0..28.
+extern const decimal decimal_powers_of_ten[29];
+extern const decimal decimal_inverse_powers_of_ten[29];
+
+int decimal_is_valid(decimal value);
+size_t decimal_first_invalid(const decimal *values, size_t count);
+
 int get_sign(const decimal *value);
 void set_sign(decimal *value, int sign);
 int get_scale(const decimal *value);
@@ -43,6 +300,45 @@ int mul(decimal value_1, decimal value_2, decimal *result);
 int mul_abs(decimal value_1, decimal value_2, decimal *result);
 int div(decimal value_1, decimal value_2, decimal *result);
 int div_abs(decimal dividend, decimal divisor, decimal *result);
+int add_unchecked(decimal value_1, decimal value_2, decimal *result);
+int sub_unchecked(decimal value_1, decimal value_2, decimal *result);
+int mul_unchecked(decimal value_1, decimal value_2, decimal *result);
+int div_unchecked(decimal value_1, decimal value_2, decimal *result);
+int add_unrecorded(decimal value_1, decimal value_2, decimal *result);
+int sub_unrecorded(decimal value_1, decimal value_2, decimal *result);
+int mul_unrecorded(decimal value_1, decimal value_2, decimal *result);
+// The 192-bit product of two mantissas, low word first, in words[0..5].
+void mul_words(const decimal *value_1, const decimal *value_2,
+               unsigned int *words);
+int decimal_divmod(decimal value_1, decimal value_2, decimal *quotient,
+                   decimal *remainder);
+int decimal_mod(decimal value_1, decimal value_2, decimal *result);
+int decimal_sqrt(decimal value, decimal *result);
+int decimal_pow(decimal base, int exponent, decimal *result);
+int decimal_exp(decimal value, decimal *result);
+int decimal_ln(decimal value, decimal *result);
+
+int decimal_compound_factor(decimal rate, int periods, decimal *result);
+int decimal_present_value(decimal amount, decimal rate, int periods,
+                          decimal *result);
+int decimal_annuity_payment(decimal principal, decimal rate, int periods,
+                            decimal *result);
+int decimal_compound_factor_array(const decimal *rates, const int *periods,
+                                  decimal *results, size_t count);
+int decimal_present_value_array(const decimal *amounts, const decimal *rates,
+                                const int *periods, decimal *results,
+                                size_t count);
+int decimal_annuity_payment_array(const decimal *principals,
+                                  const decimal *rates, const int *periods,
+                                  decimal *results, size_t count);
+int decimal_amortization_schedule(decimal principal, decimal rate,
+                                  int periods,
+                                  decimal_amortization_row *rows);
+int decimal_allocate(decimal total, const decimal *weights, size_t count,
+                     int scale, decimal *shares);
+int decimal_allocate_arena(decimal total, const decimal *weights,
+                           size_t count, int scale, decimal_arena *arena,
+                           decimal *shares);
 int is_divisor_zero(decimal value);
 int check_small_result(decimal value);
 void process_multiplication(unsigned long long *temp, int i, int j,
@@ -57,15 +353,168 @@ int finalize_division(decimal *result, int result_sign,
 int perform_division(decimal value_1, decimal value_2,
                          decimal *result);
 
+decimal_context *decimal_context_get(void);
+void decimal_context_reset(void);
+void decimal_context_record(int flag);
+void decimal_context_raise(unsigned int status);
+
+void decimal_instrument_snapshot(decimal_instrument_stats *stats);
+void decimal_instrument_reset(void);
+void decimal_instrument_merge(decimal_instrument_stats *total,
+                              const decimal_instrument_stats *stats);
+void decimal_instrument_dump(const decimal_instrument_stats *stats,
+                             FILE *out);
+unsigned long long decimal_instrument_ticks(void);
+void decimal_instrument_op(int op, unsigned long long start,
+                           const decimal *value_1, const decimal *value_2);
+void decimal_instrument_event(int event);
+
+void wide_zero(wide_int *value);
+void wide_from_decimal(const decimal *value, wide_int *result);
+int wide_is_zero(const wide_int *value);
+int wide_fits_u96(const wide_int *value);
+int wide_bit_length(const wide_int *value);
+int wide_compare(const wide_int *value_1, const wide_int *value_2);
+unsigned int wide_add(wide_int *value, const wide_int *addend);
+unsigned int wide_add_u32(wide_int *value, unsigned int addend);
+unsigned int wide_sub(wide_int *value, const wide_int *subtrahend);
+void wide_negate(wide_int *value);
+unsigned int wide_mul_u32(wide_int *value, unsigned int factor);
+int wide_mul_pow10(wide_int *value, int power);
+unsigned int wide_div_u32(wide_int *value, unsigned int divisor);
+int wide_to_decimal(wide_int *value, int scale, int sign, decimal *result);
+void wide_divmod(const wide_int *numerator, const wide_int *denominator,
+                 wide_int *quotient, wide_int *remainder);
+
+void wide_decimal_normalize(wide_decimal *value);
+void wide_decimal_from_decimal(const decimal *value, wide_decimal *result);
+int wide_decimal_to_decimal(const wide_decimal *value, decimal *result);
+void wide_decimal_add(const wide_decimal *value_1,
+                      const wide_decimal *value_2, int negate_2,
+                      wide_decimal *result);
+void wide_decimal_mul(const wide_decimal *value_1,
+                      const wide_decimal *value_2, wide_decimal *result);
+void wide_decimal_div(const wide_decimal *value_1,
+                      const wide_decimal *value_2, wide_decimal *result);
+void wide_decimal_pow(const wide_decimal *base, unsigned int power,
+                      wide_decimal *result);
+void wide_decimal_sqrt(const wide_decimal *value, wide_decimal *result);
+
+int decimal_divisor_prepare(decimal divisor, decimal_divisor *prepared);
+int decimal_div_by(const decimal_divisor *divisor, decimal value,
+                   decimal *result);
+int decimal_div_by_array(const decimal_divisor *divisor,
+                         const decimal *values, decimal *results,
+                         size_t count);
+
+void decimal_arena_init(decimal_arena *arena, size_t block_size);
+void *decimal_arena_alloc(decimal_arena *arena, size_t size);
+void decimal_arena_reset(decimal_arena *arena);
+decimal_arena_mark decimal_arena_get_mark(const decimal_arena *arena);
+void decimal_arena_rewind(decimal_arena *arena, decimal_arena_mark mark);
+void decimal_arena_release(decimal_arena *arena);
+
+int bigdecimal_from_decimal(decimal value, decimal_arena *arena,
+                            bigdecimal *result);
+int bigdecimal_to_decimal(const bigdecimal *value, decimal_arena *arena,
+                          decimal *result);
+int bigdecimal_add(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result);
+int bigdecimal_sub(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result);
+int bigdecimal_mul(const bigdecimal *value_1, const bigdecimal *value_2,
+                   decimal_arena *arena, bigdecimal *result);
+int bigdecimal_from_wide(const wide_int *value, int scale, int sign,
+                         decimal_arena *arena, bigdecimal *result);
+int bigdecimal_to_wide_decimal(const bigdecimal *value, decimal_arena *arena,
+                               wide_decimal *result);
+void decimal_number_from_decimal(decimal value, decimal_number *result);
+int decimal_number_to_decimal(const decimal_number *value,
+                              decimal_arena *arena, decimal *result);
+int decimal_number_add(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result);
+int decimal_number_sub(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result);
+int decimal_number_mul(const decimal_number *value_1,
+                       const decimal_number *value_2, decimal_arena *arena,
+                       decimal_number *result);
+
+// Runs `work` on each of the `count` tasks laid out `size` bytes apart
+// from `tasks`, one thread per task; the calling thread takes task 0.
+void decimal_run_parallel(int count, void *(*work)(void *), void *tasks,
+                          size_t size);
+
+int decimal_group_by_int(const long long *keys, const decimal *const *values,
+                         int value_count, size_t count, int threads,
+                         decimal_arena *arena, decimal_groups *groups);
+int decimal_group_by_decimal(const decimal *keys,
+                             const decimal *const *values, int value_count,
+                             size_t count, int threads, decimal_arena *arena,
+                             decimal_groups *groups);
+
+int decimal_scan_inclusive(const decimal *values, decimal *results,
+                           int *flags, size_t count, int threads);
+int decimal_scan_exclusive(const decimal *values, decimal *results,
+                           int *flags, size_t count, int threads);
+
+int decimal_mean(const decimal *values, size_t count, int threads,
+                 decimal *result);
+int decimal_variance(const decimal *values, size_t count, int sample,
+                     int threads, decimal *result);
+int decimal_stddev(const decimal *values, size_t count, int sample,
+                   int threads, decimal *result);
+int decimal_weighted_mean(const decimal *values, const decimal *weights,
+                          size_t count, int threads, decimal *result);
+
+int decimal_csv_parse(const char *text, size_t length, decimal *result);
+int decimal_csv_open_buffer(decimal_csv_reader *reader, const char *data,
+                            size_t size, char delimiter, const int *fields,
+                            int column_count);
+int decimal_csv_open_fd(decimal_csv_reader *reader, int fd,
+                        size_t block_size, char delimiter, const int *fields,
+                        int column_count, decimal_arena *arena);
+int decimal_csv_skip_rows(decimal_csv_reader *reader, size_t count);
+int decimal_csv_read(decimal_csv_reader *reader, decimal *const *columns,
+                     int *flags, size_t capacity, int threads,
+                     size_t *rows);
+void decimal_csv_close(decimal_csv_reader *reader);
+
+int decimal_expression_compile(const char *source, const char *const *names,
+                               int name_count,
+                               decimal_expression *expression);
+int decimal_expression_eval(const decimal_expression *expression,
+                            const decimal *inputs, decimal *result);
+int decimal_expression_eval_columns(const decimal_expression *expression,
+                                    const decimal *const *columns,
+                                    decimal *results, size_t count);
+
+void decimal_make_key(const decimal *value, decimal_key *key);
+int decimal_key_compare(const decimal_key *key_1, const decimal_key *key_2);
+int decimal_compare(decimal value_1, decimal value_2);
+unsigned int decimal_compare_mask(const decimal *values_1,
+                                  const decimal *values_2, int count,
+                                  int relation);
+
 int is_less(decimal, decimal);
 int is_less_or_equal(decimal, decimal);
 int is_greater(decimal, decimal);
 int is_greater_or_equal(decimal, decimal);
 int is_equal(decimal, decimal);
 int is_not_equal(decimal, decimal);
+int decimal_compare_unchecked(decimal value_1, decimal value_2);
+int is_less_unchecked(decimal, decimal);
+int is_less_or_equal_unchecked(decimal, decimal);
+int is_greater_unchecked(decimal, decimal);
+int is_greater_or_equal_unchecked(decimal, decimal);
+int is_equal_unchecked(decimal, decimal);
+int is_not_equal_unchecked(decimal, decimal);
 
 int from_int_to_decimal(int src, decimal *dst);
 int from_float_to_decimal(float src, decimal *dst);
+int from_float_to_decimal_array(const float *src, decimal *dst,
+                                size_t count);
 int from_decimal_to_int(decimal src, int *dst);
 int from_decimal_to_float(decimal src, float *dst);
 
@@ -73,4 +522,11 @@ int floor_decimal(decimal value, decimal *result);
 int round_decimal(decimal value, decimal *result);
 int truncate_decimal(decimal value, decimal *result);
 int negate_decimal(decimal value, decimal *result);
+int decimal_floor_array(const decimal *values, decimal *results,
+                        size_t count);
+int decimal_round_array(const decimal *values, decimal *results,
+                        size_t count);
+int decimal_truncate_array(const decimal *values, decimal *results,
+                           size_t count);
+int decimal_reduce(decimal value, decimal *result);
 #endif
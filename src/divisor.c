@@ -0,0 +1,132 @@
+#include "decimal.h"
+
+#define RECIPROCAL_WORDS 6
+
+static const unsigned int kPow10U32[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+
+// floor(a * b / 2^192) for a, b < 2^192, i.e. the top half of the product.
+static void mul_high(const wide_int *a, const wide_int *b, wide_int *high) {
+  unsigned int product[2 * RECIPROCAL_WORDS] = {0u};
+  for (int i = 0; i < RECIPROCAL_WORDS; i++) {
+    unsigned long long carry = 0ull;
+    if (a->words[i] != 0u) {
+      for (int j = 0; j < RECIPROCAL_WORDS; j++) {
+        unsigned long long t =
+            (unsigned long long)a->words[i] * b->words[j] + product[i + j] +
+            carry;
+        product[i + j] = (unsigned int)t;
+        carry = t >> 32;
+      }
+    }
+    product[i + RECIPROCAL_WORDS] = (unsigned int)carry;
+  }
+  wide_zero(high);
+  for (int i = 0; i < RECIPROCAL_WORDS; i++) {
+    high->words[i] = product[i + RECIPROCAL_WORDS];
+  }
+}
+
+// Low 192 bits of q * d, where d is a 96-bit mantissa.
+static void mul_low(const wide_int *q, const wide_int *d, wide_int *low) {
+  wide_zero(low);
+  for (int i = 0; i < 3; i++) {
+    unsigned long long carry = 0ull;
+    for (int j = 0; i + j < RECIPROCAL_WORDS; j++) {
+      unsigned long long t = (unsigned long long)d->words[i] * q->words[j] +
+                             low->words[i + j] + carry;
+      low->words[i + j] = (unsigned int)t;
+      carry = t >> 32;
+    }
+  }
+}
+
+int decimal_divisor_prepare(decimal divisor, decimal_divisor *prepared) {
+  int flag = ARITHMETIC_OK;
+  if (prepared == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    wide_int all_ones;
+    prepared->scale = get_scale(&divisor);
+    prepared->sign = get_sign(&divisor);
+    wide_from_decimal(&divisor, &prepared->mantissa);
+    wide_zero(&prepared->reciprocal);
+    if (is_divisor_zero(divisor)) {
+      flag = ARITHMETIC_DIV_BY_ZERO;
+    } else {
+      wide_zero(&all_ones);
+      for (int i = 0; i < RECIPROCAL_WORDS; i++) all_ones.words[i] = ~0u;
+      wide_divmod(&all_ones, &prepared->mantissa, &prepared->reciprocal,
+                  NULL);
+    }
+  }
+  return flag;
+}
+
+// Same result as div(): trunc(value / divisor) as an integer. With the
+// reciprocal m = floor((2^192 - 1) / D), floor(N * m / 2^192) is either
+// the quotient or one below it for any N < 2^192, so one multiply-high and
+// one correction step replace the bit-serial loop.
+int decimal_div_by(const decimal_divisor *divisor, decimal value,
+                   decimal *result) {
+  int flag = ARITHMETIC_OK;
+
+  if (divisor == NULL || result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (wide_is_zero(&divisor->mantissa)) {
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  } else if (is_zero(value)) {
+    decimal_zero(result);
+  } else {
+    int scale = get_scale(&value);
+    int sign = get_sign(&value) ^ divisor->sign;
+    wide_int numerator;
+    wide_int quotient;
+    wide_int product;
+
+    wide_from_decimal(&value, &numerator);
+    if (divisor->scale > scale) {
+      wide_mul_pow10(&numerator, divisor->scale - scale);
+    }
+
+    mul_high(&numerator, &divisor->reciprocal, &quotient);
+    mul_low(&quotient, &divisor->mantissa, &product);
+    wide_sub(&numerator, &product);
+    if (wide_compare(&numerator, &divisor->mantissa) >= 0) {
+      wide_add_u32(&quotient, 1u);
+    }
+
+    for (int digits = scale - divisor->scale; digits > 0; digits -= 9) {
+      wide_div_u32(&quotient, kPow10U32[digits > 9 ? 9 : digits]);
+    }
+
+    if (!wide_fits_u96(&quotient)) {
+      flag = ARITHMETIC_BIG;
+    } else {
+      result->bits[0] = (int)quotient.words[0];
+      result->bits[1] = (int)quotient.words[1];
+      result->bits[2] = (int)quotient.words[2];
+      result->bits[3] = 0;
+      set_sign(result, sign);
+    }
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int decimal_div_by_array(const decimal_divisor *divisor,
+                         const decimal *values, decimal *results,
+                         size_t count) {
+  int flag = ARITHMETIC_OK;
+  if (divisor == NULL || (count > 0 && (values == NULL || results == NULL))) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      int status = decimal_div_by(divisor, values[i], &results[i]);
+      if (flag == ARITHMETIC_OK) flag = status;
+    }
+  }
+  return flag;
+}
@@ -0,0 +1,281 @@
+#include "decimal.h"
+
+#define EXPRESSION_INPUT 0
+#define EXPRESSION_CONSTANT 1
+#define EXPRESSION_ADD 2
+#define EXPRESSION_SUB 3
+#define EXPRESSION_MUL 4
+#define EXPRESSION_DIV 5
+#define EXPRESSION_NEGATE 6
+
+// Recursive descent over
+//   sum     = product (('+' | '-') product)*
+//   product = unary (('*' | '/') unary)*
+//   unary   = ('-' | '+') unary | primary
+//   primary = number | name | '(' sum ')'
+// emitting a postfix program as it goes.
+typedef struct {
+  const char *cursor;
+  const char *const *names;
+  int name_count;
+  int nesting;
+  int depth;
+  int flag;
+  decimal_expression *expression;
+} expression_parser;
+
+static void parse_sum(expression_parser *parser);
+
+static int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static int is_name_start(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static char peek(expression_parser *parser) {
+  while (*parser->cursor == ' ' || *parser->cursor == '\t') parser->cursor++;
+  return *parser->cursor;
+}
+
+static void emit(expression_parser *parser, int opcode, int operand) {
+  decimal_expression *expression = parser->expression;
+  if (parser->flag == ARITHMETIC_OK &&
+      expression->op_count == DECIMAL_EXPRESSION_MAX_OPS)
+    parser->flag = ARITHMETIC_BAD_INPUT;
+  if (parser->flag == ARITHMETIC_OK) {
+    expression->ops[expression->op_count].opcode = (unsigned char)opcode;
+    expression->ops[expression->op_count].operand = (unsigned char)operand;
+    expression->op_count++;
+    // Loads push one value, binary operators pop two and push one.
+    if (opcode == EXPRESSION_INPUT || opcode == EXPRESSION_CONSTANT)
+      parser->depth++;
+    else if (opcode != EXPRESSION_NEGATE)
+      parser->depth--;
+    if (parser->depth > DECIMAL_EXPRESSION_MAX_DEPTH)
+      parser->flag = ARITHMETIC_BAD_INPUT;
+    else if (parser->depth > expression->stack_depth)
+      expression->stack_depth = parser->depth;
+  }
+}
+
+// Literals keep up to WIDE_DECIMAL_DIGITS significant digits, so constants
+// such as 1/3 written out in full are not rounded to 28 places first.
+static void parse_number(expression_parser *parser) {
+  decimal_expression *expression = parser->expression;
+  wide_decimal value;
+  int any_digit = 0;
+  int digits = 0;
+  int seen_point = 0;
+  wide_zero(&value.mantissa);
+  value.exponent = 0;
+  value.sign = 0;
+  for (char c = *parser->cursor; is_digit(c) || (c == '.' && !seen_point);
+       c = *++parser->cursor) {
+    if (c == '.') {
+      seen_point = 1;
+    } else {
+      any_digit = 1;
+      if (!wide_is_zero(&value.mantissa) || c != '0') digits++;
+      wide_mul_u32(&value.mantissa, 10u);
+      wide_add_u32(&value.mantissa, (unsigned int)(c - '0'));
+      value.exponent -= seen_point;
+    }
+  }
+  if (!any_digit || digits > WIDE_DECIMAL_DIGITS ||
+      expression->constant_count == DECIMAL_EXPRESSION_MAX_CONSTANTS) {
+    parser->flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    wide_decimal_normalize(&value);
+    expression->constants[expression->constant_count] = value;
+    emit(parser, EXPRESSION_CONSTANT, expression->constant_count++);
+  }
+}
+
+static void parse_name(expression_parser *parser) {
+  const char *start = parser->cursor;
+  while (is_name_start(*parser->cursor) || is_digit(*parser->cursor))
+    parser->cursor++;
+  size_t length = (size_t)(parser->cursor - start);
+  int input = -1;
+  for (int i = 0; i < parser->name_count && input < 0; i++) {
+    if (parser->names[i] != NULL && strlen(parser->names[i]) == length &&
+        strncmp(parser->names[i], start, length) == 0)
+      input = i;
+  }
+  if (input < 0) parser->flag = ARITHMETIC_BAD_INPUT;
+  else emit(parser, EXPRESSION_INPUT, input);
+}
+
+static void parse_unary(expression_parser *parser) {
+  char c = peek(parser);
+  // Bounds the recursion for inputs such as "((((((...".
+  if (++parser->nesting > DECIMAL_EXPRESSION_MAX_OPS) {
+    parser->flag = ARITHMETIC_BAD_INPUT;
+  } else if (c == '-' || c == '+') {
+    parser->cursor++;
+    parse_unary(parser);
+    if (c == '-') emit(parser, EXPRESSION_NEGATE, 0);
+  } else if (c == '(') {
+    parser->cursor++;
+    parse_sum(parser);
+    if (peek(parser) == ')') parser->cursor++;
+    else parser->flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_digit(c) || c == '.') {
+    parse_number(parser);
+  } else if (is_name_start(c)) {
+    parse_name(parser);
+  } else {
+    parser->flag = ARITHMETIC_BAD_INPUT;
+  }
+  parser->nesting--;
+}
+
+static void parse_product(expression_parser *parser) {
+  parse_unary(parser);
+  for (char c = peek(parser);
+       parser->flag == ARITHMETIC_OK && (c == '*' || c == '/');
+       c = peek(parser)) {
+    parser->cursor++;
+    parse_unary(parser);
+    emit(parser, c == '*' ? EXPRESSION_MUL : EXPRESSION_DIV, 0);
+  }
+}
+
+static void parse_sum(expression_parser *parser) {
+  parse_product(parser);
+  for (char c = peek(parser);
+       parser->flag == ARITHMETIC_OK && (c == '+' || c == '-');
+       c = peek(parser)) {
+    parser->cursor++;
+    parse_product(parser);
+    emit(parser, c == '+' ? EXPRESSION_ADD : EXPRESSION_SUB, 0);
+  }
+}
+
+// Compiles a formula over the given input names. Failures to parse, unknown
+// names and formulas over the DECIMAL_EXPRESSION_MAX_* limits are
+// ARITHMETIC_BAD_INPUT.
+int decimal_expression_compile(const char *source, const char *const *names,
+                               int name_count,
+                               decimal_expression *expression) {
+  int flag = ARITHMETIC_OK;
+  expression_parser parser;
+
+  if (source == NULL || expression == NULL || name_count < 0 ||
+      name_count > DECIMAL_EXPRESSION_MAX_INPUTS ||
+      (name_count > 0 && names == NULL)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    memset(expression, 0, sizeof(*expression));
+    expression->input_count = name_count;
+    parser.cursor = source;
+    parser.names = names;
+    parser.name_count = name_count;
+    parser.nesting = 0;
+    parser.depth = 0;
+    parser.flag = ARITHMETIC_OK;
+    parser.expression = expression;
+    parse_sum(&parser);
+    if (parser.flag == ARITHMETIC_OK && peek(&parser) != '\0')
+      parser.flag = ARITHMETIC_BAD_INPUT;
+    flag = parser.flag;
+    if (flag != ARITHMETIC_OK) expression->op_count = 0;
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Runs the program on row `row` of the input columns. Every intermediate
+// stays a 38-digit wide_decimal; only the final value is rounded.
+static int run_program(const decimal_expression *expression,
+                       const decimal *const *columns, size_t row,
+                       decimal *result) {
+  int flag = ARITHMETIC_OK;
+  wide_decimal stack[DECIMAL_EXPRESSION_MAX_DEPTH];
+  int top = 0;
+
+  for (int i = 0; i < expression->op_count && flag == ARITHMETIC_OK; i++) {
+    const decimal_expression_op *op = &expression->ops[i];
+    wide_decimal *right = top > 0 ? &stack[top - 1] : NULL;
+    wide_decimal *left = top > 1 ? &stack[top - 2] : NULL;
+    switch (op->opcode) {
+      case EXPRESSION_INPUT:
+        wide_decimal_from_decimal(&columns[op->operand][row], &stack[top++]);
+        break;
+      case EXPRESSION_CONSTANT:
+        stack[top++] = expression->constants[op->operand];
+        break;
+      case EXPRESSION_NEGATE:
+        if (!wide_is_zero(&right->mantissa)) right->sign ^= 1;
+        break;
+      case EXPRESSION_ADD:
+      case EXPRESSION_SUB:
+        wide_decimal_add(left, right, op->opcode == EXPRESSION_SUB, left);
+        top--;
+        break;
+      case EXPRESSION_MUL:
+        wide_decimal_mul(left, right, left);
+        top--;
+        break;
+      default:
+        if (wide_is_zero(&right->mantissa)) flag = ARITHMETIC_DIV_BY_ZERO;
+        else wide_decimal_div(left, right, left);
+        top--;
+        break;
+    }
+  }
+  if (flag == ARITHMETIC_OK) flag = wide_decimal_to_decimal(&stack[0], result);
+  return flag;
+}
+
+static int expression_is_runnable(const decimal_expression *expression) {
+  return expression != NULL && expression->op_count > 0 &&
+         expression->stack_depth <= DECIMAL_EXPRESSION_MAX_DEPTH &&
+         expression->input_count <= DECIMAL_EXPRESSION_MAX_INPUTS;
+}
+
+// inputs[i] is the value of the i-th name given to the compiler.
+int decimal_expression_eval(const decimal_expression *expression,
+                            const decimal *inputs, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  const decimal *columns[DECIMAL_EXPRESSION_MAX_INPUTS];
+
+  if (!expression_is_runnable(expression) || result == NULL ||
+      (expression->input_count > 0 && inputs == NULL)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    for (int i = 0; i < expression->input_count; i++) columns[i] = &inputs[i];
+    flag = run_program(expression, columns, 0, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// columns[i][row] is the value of the i-th name for that row. Returns the
+// first failure; the remaining rows are still evaluated.
+int decimal_expression_eval_columns(const decimal_expression *expression,
+                                    const decimal *const *columns,
+                                    decimal *results, size_t count) {
+  int flag = ARITHMETIC_OK;
+
+  if (count > 0 &&
+      (!expression_is_runnable(expression) || results == NULL ||
+       (expression->input_count > 0 && columns == NULL))) {
+    flag = ARITHMETIC_BAD_INPUT;
+  }
+  for (int i = 0; count > 0 && flag == ARITHMETIC_OK &&
+                  i < expression->input_count; i++) {
+    if (columns[i] == NULL) flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK) {
+    for (size_t row = 0; row < count; row++) {
+      int status = run_program(expression, columns, row, &results[row]);
+      if (flag == ARITHMETIC_OK) flag = status;
+    }
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
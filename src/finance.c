@@ -0,0 +1,276 @@
+#include "decimal.h"
+
+// Every kernel is amount * multiplier, where the multiplier depends only on
+// the (rate, periods) pair:
+//   compound factor  f = (1 + r)^n          (amount is 1)
+//   present value    1 / f
+//   annuity payment  r * f / (f - 1), or 1 / n for a zero rate
+#define KERNEL_COMPOUND 0
+#define KERNEL_DISCOUNT 1
+#define KERNEL_ANNUITY 2
+
+// Open-addressed cache of multipliers for one batch call. Loan books repeat
+// a handful of rate/term pairs, so most contracts cost a single multiply.
+// The table starts on the stack and doubles into an arena once half full,
+// so every distinct pair in the batch is computed once.
+#define MULTIPLIER_CACHE_SLOTS 64
+
+typedef struct {
+  decimal rate;
+  int periods;
+  int used;
+  wide_decimal multiplier;
+} multiplier_entry;
+
+typedef struct {
+  multiplier_entry *slots;
+  size_t mask;
+  size_t used;
+  decimal_arena arena;
+} multiplier_cache;
+
+static void wide_decimal_from_int(int value, wide_decimal *result) {
+  decimal converted;
+  from_int_to_decimal(value, &converted);
+  wide_decimal_from_decimal(&converted, result);
+}
+
+static int pair_multiplier(decimal rate, int periods, int kernel,
+                           wide_decimal *multiplier) {
+  int flag = ARITHMETIC_OK;
+  wide_decimal one;
+  wide_decimal factor;
+  wide_decimal_from_int(1, &one);
+
+  if (periods < 0 || (kernel == KERNEL_ANNUITY && periods == 0)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (kernel == KERNEL_ANNUITY && is_zero(rate)) {
+    wide_decimal_from_int(periods, multiplier);
+    wide_decimal_div(&one, multiplier, multiplier);
+  } else {
+    wide_decimal_from_decimal(&rate, &factor);
+    wide_decimal_add(&one, &factor, 0, &factor);
+    wide_decimal_pow(&factor, (unsigned int)periods, &factor);
+    if (kernel == KERNEL_COMPOUND) {
+      *multiplier = factor;
+    } else if (kernel == KERNEL_DISCOUNT) {
+      if (wide_is_zero(&factor.mantissa)) flag = ARITHMETIC_DIV_BY_ZERO;
+      else wide_decimal_div(&one, &factor, multiplier);
+    } else {
+      wide_decimal excess;
+      wide_decimal_add(&factor, &one, 1, &excess);
+      if (wide_is_zero(&excess.mantissa)) {
+        flag = ARITHMETIC_DIV_BY_ZERO;
+      } else {
+        wide_decimal_div(&factor, &excess, multiplier);
+        wide_decimal_from_decimal(&rate, &factor);
+        wide_decimal_mul(multiplier, &factor, multiplier);
+      }
+    }
+  }
+  return flag;
+}
+
+static unsigned int multiplier_hash(decimal rate, int periods) {
+  unsigned int hash = (unsigned int)periods * 0x9E3779B1u;
+  for (int i = 0; i < 4; i++) {
+    hash = (hash ^ (unsigned int)rate.bits[i]) * 0x85EBCA6Bu;
+  }
+  return hash ^ (hash >> 16);
+}
+
+// The slot holding the pair, or the empty slot it would go into; NULL
+// only if every slot is taken.
+static multiplier_entry *find_entry(multiplier_entry *slots, size_t mask,
+                                    decimal rate, int periods) {
+  multiplier_entry *entry = NULL;
+  size_t at = multiplier_hash(rate, periods) & mask;
+  for (size_t probe = 0; probe <= mask && entry == NULL; probe++) {
+    multiplier_entry *slot = &slots[(at + probe) & mask];
+    if (!slot->used ||
+        (slot->periods == periods &&
+         memcmp(&slot->rate, &rate, sizeof(rate)) == 0))
+      entry = slot;
+  }
+  return entry;
+}
+
+// Rehashes into twice the slots. Keeps the old table if that fails.
+static void grow_cache(multiplier_cache *cache) {
+  size_t count = (cache->mask + 1) * 2;
+  multiplier_entry *slots =
+      decimal_arena_alloc(&cache->arena, count * sizeof(multiplier_entry));
+  if (slots != NULL) {
+    memset(slots, 0, count * sizeof(multiplier_entry));
+    for (size_t i = 0; i <= cache->mask; i++) {
+      const multiplier_entry *old = &cache->slots[i];
+      if (old->used)
+        *find_entry(slots, count - 1, old->rate, old->periods) = *old;
+    }
+    cache->slots = slots;
+    cache->mask = count - 1;
+  }
+}
+
+// Rates are matched bit for bit, so 0.05 and 0.050 take separate slots;
+// that only costs a recomputation. Should the table fill up because
+// memory ran out, new pairs are computed without being kept.
+static int cached_multiplier(multiplier_cache *cache, decimal rate,
+                             int periods, int kernel,
+                             wide_decimal *multiplier) {
+  int flag = ARITHMETIC_OK;
+  multiplier_entry *entry =
+      find_entry(cache->slots, cache->mask, rate, periods);
+  if (entry != NULL && entry->used) {
+    *multiplier = entry->multiplier;
+  } else {
+    flag = pair_multiplier(rate, periods, kernel, multiplier);
+    if (flag == ARITHMETIC_OK && entry != NULL) {
+      entry->rate = rate;
+      entry->periods = periods;
+      entry->used = 1;
+      entry->multiplier = *multiplier;
+      cache->used++;
+      if (cache->used * 2 > cache->mask + 1) grow_cache(cache);
+    }
+  }
+  return flag;
+}
+
+static int apply_multiplier(const decimal *amount,
+                            const wide_decimal *multiplier, decimal *result) {
+  wide_decimal value = *multiplier;
+  if (amount != NULL) {
+    wide_decimal_from_decimal(amount, &value);
+    wide_decimal_mul(&value, multiplier, &value);
+  }
+  return wide_decimal_to_decimal(&value, result);
+}
+
+static int run_kernel(const decimal *amount, decimal rate, int periods,
+                      int kernel, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  wide_decimal multiplier;
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = pair_multiplier(rate, periods, kernel, &multiplier);
+    if (flag == ARITHMETIC_OK)
+      flag = apply_multiplier(amount, &multiplier, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Returns the first failure; the remaining entries are still computed.
+static int run_kernel_array(const decimal *amounts, const decimal *rates,
+                            const int *periods, int kernel, decimal *results,
+                            size_t count) {
+  int flag = ARITHMETIC_OK;
+  multiplier_entry slots[MULTIPLIER_CACHE_SLOTS];
+  multiplier_cache cache = {slots, MULTIPLIER_CACHE_SLOTS - 1, 0, {0}};
+
+  if (count > 0 && (rates == NULL || periods == NULL || results == NULL ||
+                    (kernel != KERNEL_COMPOUND && amounts == NULL))) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    memset(slots, 0, sizeof(slots));
+    decimal_arena_init(&cache.arena, 0);
+    for (size_t i = 0; i < count; i++) {
+      wide_decimal multiplier;
+      int status = cached_multiplier(&cache, rates[i], periods[i], kernel,
+                                     &multiplier);
+      if (status == ARITHMETIC_OK) {
+        status = apply_multiplier(
+            kernel == KERNEL_COMPOUND ? NULL : &amounts[i], &multiplier,
+            &results[i]);
+      }
+      if (flag == ARITHMETIC_OK) flag = status;
+    }
+    decimal_arena_release(&cache.arena);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int decimal_compound_factor(decimal rate, int periods, decimal *result) {
+  return run_kernel(NULL, rate, periods, KERNEL_COMPOUND, result);
+}
+
+int decimal_present_value(decimal amount, decimal rate, int periods,
+                          decimal *result) {
+  return run_kernel(&amount, rate, periods, KERNEL_DISCOUNT, result);
+}
+
+int decimal_annuity_payment(decimal principal, decimal rate, int periods,
+                            decimal *result) {
+  return run_kernel(&principal, rate, periods, KERNEL_ANNUITY, result);
+}
+
+int decimal_compound_factor_array(const decimal *rates, const int *periods,
+                                  decimal *results, size_t count) {
+  return run_kernel_array(NULL, rates, periods, KERNEL_COMPOUND, results,
+                          count);
+}
+
+int decimal_present_value_array(const decimal *amounts, const decimal *rates,
+                                const int *periods, decimal *results,
+                                size_t count) {
+  return run_kernel_array(amounts, rates, periods, KERNEL_DISCOUNT, results,
+                          count);
+}
+
+int decimal_annuity_payment_array(const decimal *principals,
+                                  const decimal *rates, const int *periods,
+                                  decimal *results, size_t count) {
+  return run_kernel_array(principals, rates, periods, KERNEL_ANNUITY, results,
+                          count);
+}
+
+// The balance is carried at full working precision from row to row; the
+// last row pays off whatever remains so the schedule closes at exactly zero.
+int decimal_amortization_schedule(decimal principal, decimal rate,
+                                  int periods,
+                                  decimal_amortization_row *rows) {
+  int flag = ARITHMETIC_OK;
+  wide_decimal payment;
+
+  if (rows == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    flag = pair_multiplier(rate, periods, KERNEL_ANNUITY, &payment);
+  }
+
+  if (flag == ARITHMETIC_OK) {
+    wide_decimal balance;
+    wide_decimal periodic_rate;
+    wide_decimal_from_decimal(&principal, &balance);
+    wide_decimal_from_decimal(&rate, &periodic_rate);
+    wide_decimal_mul(&payment, &balance, &payment);
+    for (int i = 0; i < periods; i++) {
+      wide_decimal interest;
+      wide_decimal repaid;
+      wide_decimal_mul(&balance, &periodic_rate, &interest);
+      if (i == periods - 1) {
+        repaid = balance;
+        wide_decimal_add(&interest, &repaid, 0, &payment);
+      } else {
+        wide_decimal_add(&payment, &interest, 1, &repaid);
+      }
+      wide_decimal_add(&balance, &repaid, 1, &balance);
+
+      int status[4];
+      status[0] = wide_decimal_to_decimal(&payment, &rows[i].payment);
+      status[1] = wide_decimal_to_decimal(&interest, &rows[i].interest);
+      status[2] = wide_decimal_to_decimal(&repaid, &rows[i].principal);
+      status[3] = wide_decimal_to_decimal(&balance, &rows[i].balance);
+      for (int j = 0; j < 4 && flag == ARITHMETIC_OK; j++) flag = status[j];
+    }
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
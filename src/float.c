@@ -0,0 +1,277 @@
+#include "decimal.h"
+
+// Shortest round-trip conversion of a float (Ryu, Adams 2018). The value
+// m * 2^e is bracketed by the halfway points to its neighbours, both ends
+// are scaled by a tabled 2^k / 5^q or 5^i / 2^k into the decimal domain, and
+// digits are dropped while the interval still contains one candidate.
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_BIAS 127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT 61
+
+// |value| must lie in [1e-28, 2^96): below it nothing survives at scale 28,
+// from it on the mantissa no longer fits in 96 bits.
+#define FLOAT_MIN_BITS 0x10FD87B6u
+#define FLOAT_LIMIT_BITS 0x6F800000u
+
+// floor(2^(pow5bits(q) - 1 + 59) / 5^q) + 1
+static const unsigned long long kPow5InvSplit[31] = {
+    0x0800000000000001ull, 0x0666666666666667ull,
+    0x051EB851EB851EB9ull, 0x04189374BC6A7EFAull,
+    0x068DB8BAC710CB2Aull, 0x053E2D6238DA3C22ull,
+    0x0431BDE82D7B634Eull, 0x06B5FCA6AF2BD216ull,
+    0x055E63B88C230E78ull, 0x044B82FA09B5A52Dull,
+    0x06DF37F675EF6EAEull, 0x057F5FF85E592558ull,
+    0x0465E6604B7A8447ull, 0x0709709A125DA071ull,
+    0x05A126E1A84AE6C1ull, 0x0480EBE7B9D58567ull,
+    0x0734ACA5F6226F0Bull, 0x05C3BD5191B525A3ull,
+    0x049C97747490EAE9ull, 0x0760F253EDB4AB0Eull,
+    0x05E72843249088D8ull, 0x04B8ED0283A6D3E0ull,
+    0x078E480405D7B966ull, 0x060B6CD004AC9452ull,
+    0x04D5F0A66A23A9DBull, 0x07BCB43D769F762Bull,
+    0x063090312BB2C4EFull, 0x04F3A68DBC8F03F3ull,
+    0x07EC3DAF94180651ull, 0x065697BFA9ACD1DAull,
+    0x051212FFBAF0A7E2ull};
+// 5^i normalized to 61 bits.
+static const unsigned long long kPow5Split[48] = {
+    0x1000000000000000ull, 0x1400000000000000ull,
+    0x1900000000000000ull, 0x1F40000000000000ull,
+    0x1388000000000000ull, 0x186A000000000000ull,
+    0x1E84800000000000ull, 0x1312D00000000000ull,
+    0x17D7840000000000ull, 0x1DCD650000000000ull,
+    0x12A05F2000000000ull, 0x174876E800000000ull,
+    0x1D1A94A200000000ull, 0x12309CE540000000ull,
+    0x16BCC41E90000000ull, 0x1C6BF52634000000ull,
+    0x11C37937E0800000ull, 0x16345785D8A00000ull,
+    0x1BC16D674EC80000ull, 0x1158E460913D0000ull,
+    0x15AF1D78B58C4000ull, 0x1B1AE4D6E2EF5000ull,
+    0x10F0CF064DD59200ull, 0x152D02C7E14AF680ull,
+    0x1A784379D99DB420ull, 0x108B2A2C28029094ull,
+    0x14ADF4B7320334B9ull, 0x19D971E4FE8401E7ull,
+    0x1027E72F1F128130ull, 0x1431E0FAE6D7217Cull,
+    0x193E5939A08CE9DBull, 0x1F8DEF8808B02452ull,
+    0x13B8B5B5056E16B3ull, 0x18A6E32246C99C60ull,
+    0x1ED09BEAD87C0378ull, 0x13426172C74D822Bull,
+    0x1812F9CF7920E2B6ull, 0x1E17B84357691B64ull,
+    0x12CED32A16A1B11Eull, 0x178287F49C4A1D66ull,
+    0x1D6329F1C35CA4BFull, 0x125DFA371A19E6F7ull,
+    0x16F578C4E0A060B5ull, 0x1CB2D6F618C878E3ull,
+    0x11EFC659CF7D4B8Dull, 0x166BB7F0435C9E71ull,
+    0x1C06A5EC5433C60Dull, 0x118427B3B4A05BC8ull};
+
+// ceil(log2(5^e)), or 1 for e = 0.
+static int pow5bits(int e) {
+  return (int)(((unsigned int)e * 1217359u) >> 19) + 1;
+}
+
+// floor(log10(2^e)) and floor(log10(5^e)).
+static unsigned int log10_pow2(int e) {
+  return ((unsigned int)e * 78913u) >> 18;
+}
+
+static unsigned int log10_pow5(int e) {
+  return ((unsigned int)e * 732923u) >> 20;
+}
+
+static int multiple_of_pow5(unsigned int value, unsigned int power) {
+  unsigned int count = 0u;
+  while (value % 5u == 0u && count < power) {
+    value /= 5u;
+    count++;
+  }
+  return count >= power;
+}
+
+static int multiple_of_pow2(unsigned int value, unsigned int power) {
+  return (value & ((1u << power) - 1u)) == 0u;
+}
+
+// floor(m * factor / 2^shift) for shift > 32.
+static unsigned int mul_shift(unsigned int m, unsigned long long factor,
+                              int shift) {
+  unsigned long long low = (unsigned long long)m * (unsigned int)factor;
+  unsigned long long high =
+      (unsigned long long)m * (unsigned int)(factor >> 32);
+  return (unsigned int)(((low >> 32) + high) >> (shift - 32));
+}
+
+// Shortest digits * 10^*exponent that reads back as the same float, for a
+// finite non-zero float given by its biased exponent and mantissa fields.
+static unsigned int shortest_digits(unsigned int biased, unsigned int fraction,
+                                    int *exponent) {
+  int e2;
+  unsigned int m2;
+  if (biased == 0u) {
+    e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = fraction;
+  } else {
+    e2 = (int)biased - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = (1u << FLOAT_MANTISSA_BITS) | fraction;
+  }
+  int accept_bounds = (m2 & 1u) == 0u;
+
+  // The value and the halfway points to its neighbours, times 4.
+  unsigned int mv = 4u * m2;
+  unsigned int mp = 4u * m2 + 2u;
+  unsigned int mm_shift = fraction != 0u || biased <= 1u;
+  unsigned int mm = 4u * m2 - 1u - mm_shift;
+
+  unsigned int vr;
+  unsigned int vp;
+  unsigned int vm;
+  int e10;
+  int vm_trailing_zeros = 0;
+  int vr_trailing_zeros = 0;
+  unsigned int last_digit = 0u;
+  if (e2 >= 0) {
+    unsigned int q = log10_pow2(e2);
+    int k = FLOAT_POW5_INV_BITCOUNT + pow5bits((int)q) - 1;
+    int i = -e2 + (int)q + k;
+    e10 = (int)q;
+    vr = mul_shift(mv, kPow5InvSplit[q], i);
+    vp = mul_shift(mp, kPow5InvSplit[q], i);
+    vm = mul_shift(mm, kPow5InvSplit[q], i);
+    if (q != 0u && (vp - 1u) / 10u <= vm / 10u) {
+      int l = FLOAT_POW5_INV_BITCOUNT + pow5bits((int)q - 1) - 1;
+      last_digit =
+          mul_shift(mv, kPow5InvSplit[q - 1u], -e2 + (int)q - 1 + l) % 10u;
+    }
+    // 5^10 is the largest power of 5 below 2^26; only one of mp, mv and mm
+    // can be a multiple of 5.
+    if (q <= 9u) {
+      if (mv % 5u == 0u)
+        vr_trailing_zeros = multiple_of_pow5(mv, q);
+      else if (accept_bounds)
+        vm_trailing_zeros = multiple_of_pow5(mm, q);
+      else
+        vp -= multiple_of_pow5(mp, q);
+    }
+  } else {
+    unsigned int q = log10_pow5(-e2);
+    int i = -e2 - (int)q;
+    int k = pow5bits(i) - FLOAT_POW5_BITCOUNT;
+    int j = (int)q - k;
+    e10 = (int)q + e2;
+    vr = mul_shift(mv, kPow5Split[i], j);
+    vp = mul_shift(mp, kPow5Split[i], j);
+    vm = mul_shift(mm, kPow5Split[i], j);
+    if (q != 0u && (vp - 1u) / 10u <= vm / 10u) {
+      j = (int)q - 1 - (pow5bits(i + 1) - FLOAT_POW5_BITCOUNT);
+      last_digit = mul_shift(mv, kPow5Split[i + 1], j) % 10u;
+    }
+    if (q <= 1u) {
+      // mv has two trailing zero bits, mm one exactly when mm_shift is 1.
+      vr_trailing_zeros = 1;
+      if (accept_bounds)
+        vm_trailing_zeros = mm_shift == 1u;
+      else
+        vp--;
+    } else if (q < 31u) {
+      vr_trailing_zeros = multiple_of_pow2(mv, q - 1u);
+    }
+  }
+
+  int removed = 0;
+  unsigned int output;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    while (vp / 10u > vm / 10u) {
+      vm_trailing_zeros &= vm % 10u == 0u;
+      vr_trailing_zeros &= last_digit == 0u;
+      last_digit = vr % 10u;
+      vr /= 10u;
+      vp /= 10u;
+      vm /= 10u;
+      removed++;
+    }
+    if (vm_trailing_zeros) {
+      while (vm % 10u == 0u) {
+        vr_trailing_zeros &= last_digit == 0u;
+        last_digit = vr % 10u;
+        vr /= 10u;
+        vp /= 10u;
+        vm /= 10u;
+        removed++;
+      }
+    }
+    // An exact ...50..0 tail rounds to even.
+    if (vr_trailing_zeros && last_digit == 5u && vr % 2u == 0u)
+      last_digit = 4u;
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+                   last_digit >= 5u);
+  } else {
+    while (vp / 10u > vm / 10u) {
+      last_digit = vr % 10u;
+      vr /= 10u;
+      vp /= 10u;
+      vm /= 10u;
+      removed++;
+    }
+    output = vr + (vr == vm || last_digit >= 5u);
+  }
+  *exponent = e10 + removed;
+  return output;
+}
+
+static const unsigned int kPow10U32[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+
+// Returns 1 for NaN, infinities and magnitudes outside [1e-28, 2^96),
+// leaving *dst zero; zero converts to zero.
+int from_float_to_decimal(float src, decimal *dst) {
+  int status = 1;
+  if (dst != NULL) {
+    unsigned int bits;
+    memcpy(&bits, &src, sizeof(bits));
+    unsigned int magnitude = bits & 0x7FFFFFFFu;
+    decimal_zero(dst);
+    if (magnitude == 0u) {
+      status = 0;
+    } else if (magnitude >= FLOAT_MIN_BITS && magnitude < FLOAT_LIMIT_BITS) {
+      int exponent = 0;
+      unsigned int digits = shortest_digits(
+          magnitude >> FLOAT_MANTISSA_BITS,
+          magnitude & ((1u << FLOAT_MANTISSA_BITS) - 1u), &exponent);
+      while (exponent < 0 && digits % 10u == 0u) {
+        digits /= 10u;
+        exponent++;
+      }
+      if (exponent < -28) {
+        // At most 9 digits to drop; round half even.
+        unsigned int divisor = kPow10U32[-28 - exponent];
+        unsigned int remainder = digits % divisor;
+        digits /= divisor;
+        if (remainder > divisor / 2u ||
+            (remainder == divisor / 2u && (digits & 1u) != 0u))
+          digits++;
+        exponent = -28;
+      }
+      wide_int mantissa;
+      wide_zero(&mantissa);
+      mantissa.words[0] = digits;
+      wide_mul_pow10(&mantissa, exponent);
+      dst->bits[0] = (int)mantissa.words[0];
+      dst->bits[1] = (int)mantissa.words[1];
+      dst->bits[2] = (int)mantissa.words[2];
+      set_scale(dst, exponent < 0 ? -exponent : 0);
+      set_sign(dst, (int)(bits >> 31));
+      status = 0;
+    }
+  }
+  return status;
+}
+
+// Returns 1 if any entry failed; those entries are left zero.
+int from_float_to_decimal_array(const float *src, decimal *dst,
+                                size_t count) {
+  int status = 0;
+  if (count > 0 && (src == NULL || dst == NULL)) {
+    status = 1;
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      status |= from_float_to_decimal(src[i], &dst[i]);
+    }
+  }
+  return status;
+}
@@ -0,0 +1,211 @@
+#include "decimal.h"
+
+// e^x is evaluated as (e^(f / 2^8))^(2^8) with a degree-10 Taylor series;
+// the truncation error stays below 10^-35 after the squarings.
+#define EXP_SQUARINGS 8
+#define EXP_TERMS 10
+
+static const wide_decimal kOne = {
+    {{0x00000000u, 0x00F436A0u, 0xD5DA46D9u, 0x0785EE10u}}, -37, 0};
+static const wide_decimal kHalf = {
+    {{0x00000000u, 0x04C51120u, 0x2D43623Du, 0x259DA654u}}, -38, 0};
+// 2^-8 = 0.00390625
+static const wide_decimal kExpScale = {
+    {{0x00000000u, 0xABB9F561u, 0xC35CA4BFu, 0x1D6329F1u}}, -40, 0};
+static const wide_decimal kE = {
+    {{0x6935E2D2u, 0xE94BDBF9u, 0x370D2BDCu, 0x1473386Au}}, -37, 0};
+// 1/j! for j = 0..EXP_TERMS.
+static const wide_decimal kInverseFactorials[EXP_TERMS + 1] = {
+    {{{0x00000000u, 0x00F436A0u, 0xD5DA46D9u, 0x0785EE10u}}, -37, 0},
+    {{{0x00000000u, 0x00F436A0u, 0xD5DA46D9u, 0x0785EE10u}}, -37, 0},
+    {{{0x00000000u, 0x04C51120u, 0x2D43623Du, 0x259DA654u}}, -38, 0},
+    {{{0xAAAAAAABu, 0x56EC5B0Au, 0x0F167614u, 0x0C89E21Cu}}, -38, 0},
+    {{{0xAAAAAAABu, 0xD94EE39Au, 0x25B82732u, 0x1F58B546u}}, -39, 0},
+    {{{0x55555555u, 0xB29DC735u, 0x4B704E65u, 0x3EB16A8Cu}}, -40, 0},
+    {{{0x38E38E39u, 0xF31A4BDEu, 0x61E80D10u, 0x0A72E717u}}, -40, 0},
+    {{{0x75D75D76u, 0x5B4A233Du, 0x674B8061u, 0x0EED4A21u}}, -41, 0},
+    {{{0xD34D34D3u, 0xB21CAC0Cu, 0xC11E6079u, 0x12A89CA9u}}, -42, 0},
+    {{{0x401CE55Du, 0xC5E6F80Eu, 0x9DAFF96Au, 0x14BB58BCu}}, -43, 0},
+    {{{0x401CE55Du, 0xC5E6F80Eu, 0x9DAFF96Au, 0x14BB58BCu}}, -44, 0}};
+
+static long double wide_decimal_to_long_double(const wide_decimal *value) {
+  long double mantissa = 0.0L;
+  for (int i = 3; i >= 0; i--) {
+    mantissa = mantissa * 4294967296.0L + (long double)value->mantissa.words[i];
+  }
+  mantissa *= powl(10.0L, (long double)value->exponent);
+  return value->sign ? -mantissa : mantissa;
+}
+
+// Keeps 18 digits of a long double seed; Newton and Halley steps supply
+// the rest.
+static void wide_decimal_from_long_double(long double value,
+                                          wide_decimal *result) {
+  wide_zero(&result->mantissa);
+  result->exponent = 0;
+  result->sign = value < 0.0L;
+  if (value != 0.0L) {
+    long double magnitude = fabsl(value);
+    int power = 17 - (int)floorl(log10l(magnitude));
+    unsigned long long digits =
+        (unsigned long long)llroundl(magnitude * powl(10.0L, power));
+    result->mantissa.words[0] = (unsigned int)digits;
+    result->mantissa.words[1] = (unsigned int)(digits >> 32);
+    result->exponent = -power;
+  }
+  wide_decimal_normalize(result);
+}
+
+static void wide_decimal_exp(const wide_decimal *value,
+                             wide_decimal *result) {
+  long double estimate = wide_decimal_to_long_double(value);
+  if (estimate > 70.0L || estimate < -70.0L) {
+    *result = kOne;
+    result->exponent =
+        estimate > 0.0L ? WIDE_DECIMAL_RANGE : -2 * WIDE_DECIMAL_RANGE;
+  } else {
+    int whole = (int)roundl(estimate);
+    wide_decimal power;
+    wide_decimal fraction;
+    wide_decimal sum = kInverseFactorials[EXP_TERMS];
+
+    wide_decimal_from_long_double((long double)whole, &power);
+    wide_decimal_add(value, &power, 1, &fraction);
+    wide_decimal_mul(&fraction, &kExpScale, &fraction);
+    for (int j = EXP_TERMS - 1; j >= 0; j--) {
+      wide_decimal_mul(&sum, &fraction, &sum);
+      wide_decimal_add(&sum, &kInverseFactorials[j], 0, &sum);
+    }
+    for (int i = 0; i < EXP_SQUARINGS; i++) {
+      wide_decimal_mul(&sum, &sum, &sum);
+    }
+
+    wide_decimal_pow(&kE, whole < 0 ? (unsigned int)-whole
+                                    : (unsigned int)whole,
+                     &power);
+    if (whole < 0) {
+      wide_decimal_div(&sum, &power, result);
+    } else {
+      wide_decimal_mul(&sum, &power, result);
+    }
+  }
+}
+
+// One Newton step from a long double seed: the seed is good to about 19
+// digits and the step squares the error, which already exceeds the 29
+// digits a decimal can hold. value must be positive.
+void wide_decimal_sqrt(const wide_decimal *value, wide_decimal *result) {
+  wide_decimal root;
+  wide_decimal quotient;
+
+  // sqrt(M * 10^e) = sqrt(M * 10^odd) * 10^((e - odd) / 2).
+  int odd = value->exponent & 1;
+  root = *value;
+  root.exponent = odd;
+  wide_decimal_from_long_double(sqrtl(wide_decimal_to_long_double(&root)),
+                                &root);
+  root.exponent += (value->exponent - odd) / 2;
+
+  wide_decimal_div(value, &root, &quotient);
+  wide_decimal_add(&root, &quotient, 0, &root);
+  wide_decimal_mul(&root, &kHalf, result);
+}
+
+int decimal_sqrt(decimal value, decimal *result) {
+  int flag = ARITHMETIC_OK;
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_zero(value)) {
+    decimal_zero(result);
+  } else if (get_sign(&value)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    wide_decimal x;
+    wide_decimal root;
+    wide_decimal_from_decimal(&value, &x);
+    wide_decimal_sqrt(&x, &root);
+    flag = wide_decimal_to_decimal(&root, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int decimal_pow(decimal base, int exponent, decimal *result) {
+  int flag = ARITHMETIC_OK;
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_zero(base) && exponent < 0) {
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  } else if (is_zero(base)) {
+    decimal_zero(result);
+    result->bits[0] = exponent == 0;
+  } else {
+    wide_decimal x;
+    wide_decimal power;
+    unsigned int magnitude = exponent < 0 ? 0u - (unsigned int)exponent
+                                          : (unsigned int)exponent;
+    wide_decimal_from_decimal(&base, &x);
+    wide_decimal_pow(&x, magnitude, &power);
+    if (exponent < 0) wide_decimal_div(&kOne, &power, &power);
+    flag = wide_decimal_to_decimal(&power, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+int decimal_exp(decimal value, decimal *result) {
+  int flag = ARITHMETIC_OK;
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    wide_decimal x;
+    wide_decimal_from_decimal(&value, &x);
+    wide_decimal_exp(&x, &x);
+    flag = wide_decimal_to_decimal(&x, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// One Halley step y += 2 (x - e^y) / (x + e^y) from a logl() seed. The step
+// triples the number of correct digits, so a single exp() evaluation is
+// enough.
+int decimal_ln(decimal value, decimal *result) {
+  int flag = ARITHMETIC_OK;
+
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (is_zero(value) || get_sign(&value)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    wide_decimal x;
+    wide_decimal y;
+    wide_decimal power;
+    wide_decimal numerator;
+    wide_decimal denominator;
+    wide_decimal_from_decimal(&value, &x);
+
+    y = x;
+    y.exponent = 0;
+    wide_decimal_from_long_double(logl(wide_decimal_to_long_double(&y)) +
+                                      (long double)x.exponent * logl(10.0L),
+                                  &y);
+
+    wide_decimal_exp(&y, &power);
+    wide_decimal_add(&x, &power, 1, &numerator);
+    wide_decimal_add(&x, &power, 0, &denominator);
+    wide_decimal_div(&numerator, &denominator, &numerator);
+    wide_decimal_add(&numerator, &numerator, 0, &numerator);
+    wide_decimal_add(&y, &numerator, 0, &y);
+    flag = wide_decimal_to_decimal(&y, result);
+  }
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
@@ -0,0 +1,611 @@
+// Differential fuzzer: random operands, often near the 96-bit limit or at
+// scale 28, run through the library and through a reference model built on
+// plain arbitrary-precision integers with an explicit scale. The model
+// shares no code with the library.
+//
+//   ./fuzz_decimal [iterations] [seed]
+//
+// Exits with status 1 if any result differs from the model.
+
+#include <time.h>
+
+#define div stdlib_div
+#include <stdlib.h>
+#undef div
+
+#include "decimal.h"
+
+#define REF_WORDS 8
+#define FUZZ_DEFAULT_ITERATIONS 1000000
+#define FUZZ_MAX_REPORTS 10
+
+// value = (-1)^sign * magnitude * 10^-scale
+typedef struct {
+  unsigned int words[REF_WORDS];
+} ref_int;
+
+typedef struct {
+  ref_int magnitude;
+  int scale;
+  int sign;
+} ref_number;
+
+typedef struct {
+  int status;
+  decimal value;
+  // The sign of a zero result is not specified.
+  int any_zero_sign;
+} ref_result;
+
+static const ref_int kRefZero = {{0u}};
+
+static unsigned long long rng_state;
+
+static unsigned long long next_random(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+static int ref_is_zero(const ref_int *value) {
+  unsigned int any = 0u;
+  for (int i = 0; i < REF_WORDS; i++) any |= value->words[i];
+  return any == 0u;
+}
+
+static int ref_fits_96(const ref_int *value) {
+  unsigned int any = 0u;
+  for (int i = 3; i < REF_WORDS; i++) any |= value->words[i];
+  return any == 0u;
+}
+
+static int ref_compare(const ref_int *a, const ref_int *b) {
+  int result = 0;
+  for (int i = REF_WORDS - 1; i >= 0 && result == 0; i--) {
+    if (a->words[i] != b->words[i])
+      result = a->words[i] > b->words[i] ? 1 : -1;
+  }
+  return result;
+}
+
+static void ref_add(ref_int *a, const ref_int *b) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < REF_WORDS; i++) {
+    carry += (unsigned long long)a->words[i] + b->words[i];
+    a->words[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+}
+
+// Requires a >= b.
+static void ref_sub(ref_int *a, const ref_int *b) {
+  unsigned long long borrow = 0ull;
+  for (int i = 0; i < REF_WORDS; i++) {
+    unsigned long long t = (unsigned long long)a->words[i] - b->words[i] -
+                           borrow;
+    a->words[i] = (unsigned int)t;
+    borrow = (t >> 32) & 1ull;
+  }
+}
+
+static void ref_mul_small(ref_int *a, unsigned int factor) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < REF_WORDS; i++) {
+    carry += (unsigned long long)a->words[i] * factor;
+    a->words[i] = (unsigned int)carry;
+    carry >>= 32;
+  }
+}
+
+static void ref_mul_pow10(ref_int *a, int power) {
+  for (int i = 0; i < power; i++) ref_mul_small(a, 10u);
+}
+
+static unsigned int ref_div_small(ref_int *a, unsigned int divisor) {
+  unsigned long long remainder = 0ull;
+  for (int i = REF_WORDS - 1; i >= 0; i--) {
+    unsigned long long t = (remainder << 32) | a->words[i];
+    a->words[i] = (unsigned int)(t / divisor);
+    remainder = t % divisor;
+  }
+  return (unsigned int)remainder;
+}
+
+static void ref_mul(const ref_int *a, const ref_int *b, ref_int *product) {
+  *product = kRefZero;
+  for (int i = 0; i < REF_WORDS; i++) {
+    unsigned long long carry = 0ull;
+    for (int j = 0; i + j < REF_WORDS; j++) {
+      carry += (unsigned long long)a->words[i] * b->words[j] +
+               product->words[i + j];
+      product->words[i + j] = (unsigned int)carry;
+      carry >>= 32;
+    }
+  }
+}
+
+static int ref_bit(const ref_int *a, int bit) {
+  return (int)((a->words[bit / 32] >> (bit % 32)) & 1u);
+}
+
+// Schoolbook binary long division; b must be non-zero.
+static void ref_divmod(const ref_int *a, const ref_int *b, ref_int *quotient,
+                       ref_int *remainder) {
+  int top = REF_WORDS * 32 - 1;
+  while (top >= 0 && !ref_bit(a, top)) top--;
+  *quotient = kRefZero;
+  *remainder = kRefZero;
+  for (int bit = top; bit >= 0; bit--) {
+    for (int i = REF_WORDS - 1; i > 0; i--) {
+      remainder->words[i] =
+          (remainder->words[i] << 1) | (remainder->words[i - 1] >> 31);
+    }
+    remainder->words[0] =
+        (remainder->words[0] << 1) | (unsigned int)ref_bit(a, bit);
+    if (ref_compare(remainder, b) >= 0) {
+      ref_sub(remainder, b);
+      quotient->words[bit / 32] |= 1u << (bit % 32);
+    }
+  }
+}
+
+static void ref_from_decimal(const decimal *value, ref_number *result) {
+  result->magnitude = kRefZero;
+  for (int i = 0; i < 3; i++)
+    result->magnitude.words[i] = (unsigned int)value->bits[i];
+  result->scale = (int)(((unsigned int)value->bits[3] >> 16) & 0xFFu);
+  result->sign = (int)((unsigned int)value->bits[3] >> 31);
+}
+
+static void ref_to_decimal(const ref_int *magnitude, int scale, int sign,
+                           decimal *result) {
+  for (int i = 0; i < 3; i++) result->bits[i] = (int)magnitude->words[i];
+  result->bits[3] =
+      (int)(((unsigned int)scale << 16) | (sign ? 0x80000000u : 0u));
+}
+
+// Rounds magnitude * 10^-scale half-even to the fewest dropped digits that
+// give at most 96 bits and a scale of at most 28.
+static void ref_fit(const ref_int *magnitude, int scale, int sign,
+                    ref_result *result) {
+  int fitted = 0;
+  result->status = ARITHMETIC_OK;
+  for (int drop = scale > 28 ? scale - 28 : 0; !fitted; drop++) {
+    if (drop > scale) {
+      result->status = ARITHMETIC_BIG;
+      fitted = 1;
+    } else {
+      ref_int rounded = *magnitude;
+      unsigned int digit = 0u;
+      int sticky = 0;
+      for (int i = 0; i < drop; i++) {
+        sticky |= digit != 0u;
+        digit = ref_div_small(&rounded, 10u);
+      }
+      if (digit > 5u ||
+          (digit == 5u && (sticky || (rounded.words[0] & 1u) != 0u))) {
+        ref_int one = kRefZero;
+        one.words[0] = 1u;
+        ref_add(&rounded, &one);
+      }
+      if (ref_fits_96(&rounded)) {
+        ref_to_decimal(&rounded, scale - drop, sign, &result->value);
+        fitted = 1;
+      }
+    }
+  }
+}
+
+// Both operands brought to the larger scale, as signed magnitudes.
+static int align(const ref_number *x, const ref_number *y, ref_int *a,
+                 ref_int *b) {
+  int scale = x->scale > y->scale ? x->scale : y->scale;
+  *a = x->magnitude;
+  *b = y->magnitude;
+  ref_mul_pow10(a, scale - x->scale);
+  ref_mul_pow10(b, scale - y->scale);
+  return scale;
+}
+
+static int ref_compare_values(const ref_number *x, const ref_number *y) {
+  ref_int a;
+  ref_int b;
+  align(x, y, &a, &b);
+  int sign_x = ref_is_zero(&a) ? 0 : (x->sign ? -1 : 1);
+  int sign_y = ref_is_zero(&b) ? 0 : (y->sign ? -1 : 1);
+  int result = (sign_x > sign_y) - (sign_x < sign_y);
+  if (result == 0 && sign_x != 0)
+    result = sign_x * ref_compare(&a, &b);
+  return result;
+}
+
+static void ref_add_values(const ref_number *x, const ref_number *y,
+                           int negate_y, ref_result *result) {
+  ref_int a;
+  ref_int b;
+  int scale = align(x, y, &a, &b);
+  int sign = x->sign;
+  if (x->sign == (y->sign ^ negate_y)) {
+    ref_add(&a, &b);
+  } else if (ref_compare(&a, &b) >= 0) {
+    ref_sub(&a, &b);
+  } else {
+    ref_sub(&b, &a);
+    a = b;
+    sign = !sign;
+  }
+  ref_fit(&a, scale, sign, result);
+  result->any_zero_sign = 1;
+}
+
+// The exact product rounded like a sum; a product that rounds to zero is
+// a plain zero at scale 0.
+static void ref_mul_values(const ref_number *x, const ref_number *y,
+                           ref_result *result) {
+  ref_int product;
+  ref_mul(&x->magnitude, &y->magnitude, &product);
+  ref_fit(&product, x->scale + y->scale, x->sign ^ y->sign, result);
+  result->any_zero_sign = 1;
+  if (result->status == ARITHMETIC_OK && result->value.bits[0] == 0 &&
+      result->value.bits[1] == 0 && result->value.bits[2] == 0)
+    result->value.bits[3] = 0;
+}
+
+// div returns the quotient truncated to an integer.
+static void ref_div_values(const ref_number *x, const ref_number *y,
+                           ref_result *result) {
+  ref_int a;
+  ref_int b;
+  ref_int quotient;
+  ref_int remainder;
+  align(x, y, &a, &b);
+  result->any_zero_sign = 1;
+  result->status = ARITHMETIC_OK;
+  if (ref_is_zero(&b)) {
+    result->status = ARITHMETIC_DIV_BY_ZERO;
+  } else {
+    ref_divmod(&a, &b, &quotient, &remainder);
+    if (!ref_fits_96(&quotient)) result->status = ARITHMETIC_BIG;
+    else ref_to_decimal(&quotient, 0, x->sign ^ y->sign, &result->value);
+  }
+}
+
+static void ref_divmod_values(const ref_number *x, const ref_number *y,
+                              ref_result *quotient, ref_result *remainder) {
+  ref_int a;
+  ref_int b;
+  ref_int q;
+  ref_int r;
+  int scale = align(x, y, &a, &b);
+  quotient->any_zero_sign = 1;
+  remainder->any_zero_sign = 1;
+  quotient->status = ARITHMETIC_OK;
+  remainder->status = ARITHMETIC_OK;
+  if (ref_is_zero(&b)) {
+    quotient->status = ARITHMETIC_DIV_BY_ZERO;
+    remainder->status = ARITHMETIC_DIV_BY_ZERO;
+  } else {
+    ref_divmod(&a, &b, &q, &r);
+    ref_to_decimal(&r, scale, x->sign, &remainder->value);
+    if (!ref_fits_96(&q)) {
+      quotient->status = ARITHMETIC_BIG;
+      remainder->status = ARITHMETIC_BIG;
+    } else {
+      ref_to_decimal(&q, 0, x->sign ^ y->sign, &quotient->value);
+    }
+  }
+}
+
+#define ROUND_FLOOR 0
+#define ROUND_HALF_UP 1
+#define ROUND_TRUNCATE 2
+
+static void ref_round_value(const ref_number *x, int mode,
+                            ref_result *result) {
+  ref_int integer = x->magnitude;
+  unsigned int first = 0u;
+  int fraction = 0;
+  for (int i = 0; i < x->scale; i++) {
+    fraction |= first != 0u;
+    first = ref_div_small(&integer, 10u);
+  }
+  fraction |= first != 0u;
+  if ((mode == ROUND_FLOOR && x->sign && fraction) ||
+      (mode == ROUND_HALF_UP && first >= 5u)) {
+    ref_int one = kRefZero;
+    one.words[0] = 1u;
+    ref_add(&integer, &one);
+  }
+  result->status = ARITHMETIC_OK;
+  result->any_zero_sign = 1;
+  ref_to_decimal(&integer, 0, x->sign, &result->value);
+}
+
+static unsigned int random_below(unsigned int bound) {
+  return (unsigned int)(next_random() % bound);
+}
+
+static void set_magnitude_bits(decimal *value, int bits) {
+  unsigned long long low = next_random();
+  unsigned long long high = next_random();
+  if (bits < 64) {
+    low &= (1ull << bits) - 1ull;
+    high = 0ull;
+  } else if (bits < 96) {
+    high &= (1ull << (bits - 64)) - 1ull;
+  }
+  value->bits[0] = (int)(unsigned int)low;
+  value->bits[1] = (int)(unsigned int)(low >> 32);
+  value->bits[2] = (int)(unsigned int)high;
+}
+
+static decimal random_decimal(void) {
+  static const int kScales[8] = {0, 0, 1, 2, 5, 10, 27, 28};
+  decimal value;
+  unsigned int kind = random_below(10u);
+  if (kind < 3u) {
+    set_magnitude_bits(&value, 1 + (int)random_below(96u));
+  } else if (kind < 6u) {
+    // Near the top of the 96-bit range.
+    set_magnitude_bits(&value, 1 + (int)random_below(40u));
+    value.bits[0] = ~value.bits[0];
+    value.bits[1] = ~value.bits[1];
+    value.bits[2] = ~value.bits[2];
+  } else if (kind < 8u) {
+    set_magnitude_bits(&value, 32 * (1 + (int)random_below(3u)));
+  } else if (kind < 9u) {
+    set_magnitude_bits(&value, 0);
+  } else {
+    set_magnitude_bits(&value, 10);
+  }
+  unsigned int pick = random_below(9u);
+  int scale = pick < 8u ? kScales[pick] : (int)random_below(29u);
+  value.bits[3] = (int)(((unsigned int)scale << 16) |
+                        ((unsigned int)random_below(2u) << 31));
+  return value;
+}
+
+// Mostly independent operands, with some sharing a scale, some equal and
+// some equal in value but written at a higher scale.
+static void random_pair(decimal *x, decimal *y) {
+  unsigned int kind = random_below(10u);
+  *x = random_decimal();
+  *y = random_decimal();
+  if (kind < 3u) {
+    y->bits[3] = (int)(((unsigned int)y->bits[3] & 0x80000000u) |
+                       ((unsigned int)x->bits[3] & 0x00FF0000u));
+  } else if (kind < 4u) {
+    *y = *x;
+  } else if (kind < 5u && get_scale(x) < 28) {
+    decimal scaled = *x;
+    if (!mul_by_ten(&scaled)) {
+      set_scale(&scaled, get_scale(x) + 1);
+      *y = scaled;
+    }
+  }
+}
+
+#define OP_ADD 0
+#define OP_SUB 1
+#define OP_MUL 2
+#define OP_DIV 3
+#define OP_DIV_BY 4
+#define OP_DIVMOD 5
+#define OP_MOD 6
+#define OP_COMPARE 7
+#define OP_KEY 8
+#define OP_FLOOR 9
+#define OP_ROUND 10
+#define OP_TRUNCATE 11
+#define OP_NEGATE 12
+#define OP_ADD_UNCHECKED 13
+#define OP_SUB_UNCHECKED 14
+#define OP_MUL_UNCHECKED 15
+#define OP_COMPARE_UNCHECKED 16
+#define OP_COUNT 17
+
+static const char *const kOpNames[OP_COUNT] = {
+    "add",           "sub",           "mul",
+    "div",           "decimal_div_by", "decimal_divmod",
+    "decimal_mod",   "compare",       "decimal_make_key",
+    "floor_decimal", "round_decimal", "truncate_decimal",
+    "negate_decimal", "add_unchecked", "sub_unchecked",
+    "mul_unchecked", "compare_unchecked"};
+
+static unsigned long long op_runs[OP_COUNT];
+static unsigned long long op_failures[OP_COUNT];
+
+static int same_result(const ref_result *expected, int status,
+                       const decimal *value) {
+  int same = status == expected->status;
+  if (same && status == ARITHMETIC_OK) {
+    decimal a = expected->value;
+    decimal b = *value;
+    if (expected->any_zero_sign && a.bits[0] == 0 && a.bits[1] == 0 &&
+        a.bits[2] == 0) {
+      a.bits[3] &= 0x7FFFFFFF;
+      b.bits[3] &= 0x7FFFFFFF;
+    }
+    same = memcmp(&a, &b, sizeof(a)) == 0;
+  }
+  return same;
+}
+
+static void print_decimal(const char *label, const decimal *value) {
+  printf("  %-9s %08X %08X %08X %08X\n", label,
+         (unsigned int)value->bits[3], (unsigned int)value->bits[2],
+         (unsigned int)value->bits[1], (unsigned int)value->bits[0]);
+}
+
+static void report(int op, const decimal *x, const decimal *y,
+                   const ref_result *expected, int status,
+                   const decimal *value) {
+  op_failures[op]++;
+  unsigned long long failures = 0ull;
+  for (int i = 0; i < OP_COUNT; i++) failures += op_failures[i];
+  if (failures <= FUZZ_MAX_REPORTS) {
+    printf("%s mismatch\n", kOpNames[op]);
+    print_decimal("x", x);
+    print_decimal("y", y);
+    printf("  expected status %d, got %d\n", expected->status, status);
+    if (expected->status == ARITHMETIC_OK)
+      print_decimal("expected", &expected->value);
+    if (status == ARITHMETIC_OK) print_decimal("got", value);
+  }
+}
+
+static void check(int op, const decimal *x, const decimal *y,
+                  const ref_result *expected, int status,
+                  const decimal *value) {
+  op_runs[op]++;
+  if (!same_result(expected, status, value))
+    report(op, x, y, expected, status, value);
+}
+
+// Comparisons are checked as three-way results in the status slot.
+static void check_order(int op, const decimal *x, const decimal *y,
+                        int expected, int got) {
+  ref_result result;
+  memset(&result, 0, sizeof(result));
+  result.status = expected;
+  check(op, x, y, &result, got, &result.value);
+}
+
+static int sign_of(int value) { return (value > 0) - (value < 0); }
+
+static void run_one(int op, decimal x, decimal y) {
+  ref_number rx;
+  ref_number ry;
+  ref_result expected;
+  ref_result expected_2;
+  decimal got;
+  decimal got_2;
+  int status = 0;
+  memset(&expected, 0, sizeof(expected));
+  memset(&got, 0, sizeof(got));
+  ref_from_decimal(&x, &rx);
+  ref_from_decimal(&y, &ry);
+
+  switch (op) {
+    case OP_ADD:
+    case OP_ADD_UNCHECKED:
+      ref_add_values(&rx, &ry, 0, &expected);
+      status = op == OP_ADD ? add(x, y, &got) : add_unchecked(x, y, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    case OP_SUB:
+    case OP_SUB_UNCHECKED:
+      ref_add_values(&rx, &ry, 1, &expected);
+      status = op == OP_SUB ? sub(x, y, &got) : sub_unchecked(x, y, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    case OP_MUL:
+    case OP_MUL_UNCHECKED:
+      ref_mul_values(&rx, &ry, &expected);
+      status = op == OP_MUL ? mul(x, y, &got) : mul_unchecked(x, y, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    case OP_DIV:
+      ref_div_values(&rx, &ry, &expected);
+      status = div(x, y, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    case OP_DIV_BY: {
+      decimal_divisor divisor;
+      ref_div_values(&rx, &ry, &expected);
+      status = decimal_divisor_prepare(y, &divisor);
+      if (status == ARITHMETIC_OK) status = decimal_div_by(&divisor, x, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    }
+    case OP_DIVMOD:
+      ref_divmod_values(&rx, &ry, &expected, &expected_2);
+      status = decimal_divmod(x, y, &got, &got_2);
+      check(op, &x, &y, &expected, status, &got);
+      if (status == ARITHMETIC_OK && expected.status == ARITHMETIC_OK &&
+          !same_result(&expected_2, status, &got_2))
+        report(op, &x, &y, &expected_2, status, &got_2);
+      break;
+    case OP_MOD:
+      ref_divmod_values(&rx, &ry, &expected_2, &expected);
+      // Only the quotient can overflow; decimal_mod never forms it.
+      if (expected.status == ARITHMETIC_BIG) expected.status = ARITHMETIC_OK;
+      status = decimal_mod(x, y, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    case OP_COMPARE: {
+      int order = ref_compare_values(&rx, &ry);
+      int got_order = decimal_compare(x, y);
+      int relations = (is_less(x, y) == (order < 0)) &&
+                      (is_less_or_equal(x, y) == (order <= 0)) &&
+                      (is_greater(x, y) == (order > 0)) &&
+                      (is_greater_or_equal(x, y) == (order >= 0)) &&
+                      (is_equal(x, y) == (order == 0)) &&
+                      (is_not_equal(x, y) == (order != 0));
+      check_order(op, &x, &y, order, relations ? got_order : 2);
+      break;
+    }
+    case OP_COMPARE_UNCHECKED:
+      check_order(op, &x, &y, ref_compare_values(&rx, &ry),
+                  decimal_compare_unchecked(x, y));
+      break;
+    case OP_KEY: {
+      decimal_key key_x;
+      decimal_key key_y;
+      decimal_make_key(&x, &key_x);
+      decimal_make_key(&y, &key_y);
+      check_order(op, &x, &y, ref_compare_values(&rx, &ry),
+                  sign_of(decimal_key_compare(&key_x, &key_y)));
+      break;
+    }
+    case OP_FLOOR:
+    case OP_ROUND:
+    case OP_TRUNCATE:
+      ref_round_value(&rx,
+                      op == OP_FLOOR   ? ROUND_FLOOR
+                      : op == OP_ROUND ? ROUND_HALF_UP
+                                       : ROUND_TRUNCATE,
+                      &expected);
+      status = op == OP_FLOOR   ? floor_decimal(x, &got)
+               : op == OP_ROUND ? round_decimal(x, &got)
+                                : truncate_decimal(x, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+    default:
+      expected.status = ARITHMETIC_OK;
+      expected.value = x;
+      expected.value.bits[3] ^= (int)0x80000000u;
+      status = negate_decimal(x, &got);
+      check(op, &x, &y, &expected, status, &got);
+      break;
+  }
+}
+
+int main(int argc, char **argv) {
+  long long iterations =
+      argc > 1 ? atoll(argv[1]) : (long long)FUZZ_DEFAULT_ITERATIONS;
+  rng_state = argc > 2 ? strtoull(argv[2], NULL, 0) : 1ull;
+  if (rng_state == 0ull) rng_state = 1ull;
+  printf("fuzz_decimal: %lld iterations, seed %s\n", iterations,
+         argc > 2 ? argv[2] : "1");
+
+  clock_t start = clock();
+  for (long long i = 0; i < iterations; i++) {
+    decimal x;
+    decimal y;
+    random_pair(&x, &y);
+    run_one((int)random_below(OP_COUNT), x, y);
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  unsigned long long failures = 0ull;
+  for (int op = 0; op < OP_COUNT; op++) {
+    printf("%-18s %10llu runs %8llu mismatches\n", kOpNames[op], op_runs[op],
+           op_failures[op]);
+    failures += op_failures[op];
+  }
+  printf("%llu mismatches, %.0f ops/s\n", failures,
+         seconds > 0.0 ? (double)iterations / seconds : 0.0);
+  return failures == 0ull ? 0 : 1;
+}
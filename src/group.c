@@ -0,0 +1,418 @@
+#include "decimal.h"
+
+#define GROUP_INITIAL_SLOTS 64
+
+// One open-addressing slot: the canonical key inline, so a probe touches a
+// single 32-byte slot (two per cache line) and never the group arrays.
+typedef struct {
+  decimal_key key;
+  unsigned long long group;  // group index + 1, 0 for an empty slot
+} group_slot;
+
+// The groups of one partition, in order of first appearance. Sums are
+// signed wide_ints at the column scale.
+typedef struct {
+  group_slot *slots;
+  size_t slot_mask;
+  size_t group_count;
+  size_t group_capacity;
+  size_t *first_rows;
+  size_t *counts;
+  wide_int *sums;
+  decimal *mins;
+  decimal *maxes;
+  decimal_arena arena;
+  int flag;
+} group_partition;
+
+// The inputs shared by every job. With more than one partition, keys and
+// hashes hold each row's key and hash, computed once, and rows lists the
+// row numbers partition by partition, in row order within each.
+typedef struct {
+  const long long *int_keys;
+  const decimal *decimal_keys;
+  const decimal *const *values;
+  const int *scales;
+  int value_count;
+  int partition_count;
+  decimal_key *keys;
+  unsigned long long *hashes;
+  size_t *rows;
+} group_input;
+
+// A hashing job covers the rows [begin, end) and counts them per
+// partition in offsets; a partition job covers rows[begin, end).
+typedef struct {
+  const group_input *input;
+  size_t begin;
+  size_t end;
+  size_t *offsets;
+  group_partition *table;
+} group_job;
+
+static void row_key(const group_input *input, size_t row,
+                    decimal_key *key) {
+  if (input->int_keys != NULL) {
+    key->limbs[0] = (unsigned long long)input->int_keys[row];
+    key->limbs[1] = 0ull;
+    key->limbs[2] = 0ull;
+  } else {
+    decimal_make_key(&input->decimal_keys[row], key);
+  }
+}
+
+static unsigned long long hash_key(const decimal_key *key) {
+  unsigned long long h = key->limbs[0] * 0x9E3779B97F4A7C15ull;
+  h ^= key->limbs[1] * 0xC2B2AE3D27D4EB4Full;
+  h ^= key->limbs[2] * 0x165667B19E3779F9ull;
+  h ^= h >> 32;
+  h *= 0xD6E8FEB86659FD93ull;
+  h ^= h >> 32;
+  return h;
+}
+
+static size_t partition_of(unsigned long long hash, int partition_count) {
+  return (size_t)((hash >> 32) % (unsigned int)partition_count);
+}
+
+static int same_key(const decimal_key *key_1, const decimal_key *key_2) {
+  return ((key_1->limbs[0] ^ key_2->limbs[0]) |
+          (key_1->limbs[1] ^ key_2->limbs[1]) |
+          (key_1->limbs[2] ^ key_2->limbs[2])) == 0ull;
+}
+
+static void *grow(decimal_arena *arena, void *old, size_t old_size,
+                  size_t size) {
+  void *fresh = decimal_arena_alloc(arena, size);
+  if (fresh != NULL && old_size > 0) memcpy(fresh, old, old_size);
+  return fresh;
+}
+
+// Doubles the group arrays. The old copies stay in the partition's arena
+// until the call ends, so the geometric growth at most doubles the memory.
+static int grow_groups(group_partition *table, int value_count) {
+  size_t old = table->group_capacity;
+  size_t capacity = old == 0 ? GROUP_INITIAL_SLOTS / 2 : old * 2;
+  size_t values_old = old * (size_t)value_count;
+  size_t values_new = capacity * (size_t)value_count;
+  table->first_rows = grow(&table->arena, table->first_rows,
+                           old * sizeof(size_t), capacity * sizeof(size_t));
+  table->counts = grow(&table->arena, table->counts, old * sizeof(size_t),
+                       capacity * sizeof(size_t));
+  table->sums = grow(&table->arena, table->sums,
+                     values_old * sizeof(wide_int),
+                     values_new * sizeof(wide_int));
+  table->mins = grow(&table->arena, table->mins,
+                     values_old * sizeof(decimal),
+                     values_new * sizeof(decimal));
+  table->maxes = grow(&table->arena, table->maxes,
+                      values_old * sizeof(decimal),
+                      values_new * sizeof(decimal));
+  table->group_capacity = capacity;
+  return table->first_rows != NULL && table->counts != NULL &&
+         table->sums != NULL && table->mins != NULL && table->maxes != NULL;
+}
+
+// Rehashes into twice the slots once the table is half full.
+static int grow_slots(group_partition *table) {
+  size_t slot_count = table->slots == NULL ? GROUP_INITIAL_SLOTS
+                                           : (table->slot_mask + 1) * 2;
+  group_slot *slots =
+      decimal_arena_alloc(&table->arena, slot_count * sizeof(group_slot));
+  if (slots != NULL) {
+    memset(slots, 0, slot_count * sizeof(group_slot));
+    for (size_t i = 0; table->slots != NULL && i <= table->slot_mask; i++) {
+      if (table->slots[i].group != 0ull) {
+        size_t at = hash_key(&table->slots[i].key) & (slot_count - 1);
+        while (slots[at].group != 0ull) at = (at + 1) & (slot_count - 1);
+        slots[at] = table->slots[i];
+      }
+    }
+    table->slots = slots;
+    table->slot_mask = slot_count - 1;
+  }
+  return slots != NULL;
+}
+
+// Index of the key's group, creating it at `row` if it is new; count when
+// memory runs out.
+static size_t find_group(group_partition *table, const decimal_key *key,
+                         unsigned long long hash, size_t row,
+                         int value_count) {
+  size_t group = table->group_count;
+  size_t at = hash & table->slot_mask;
+  while (table->slots[at].group != 0ull &&
+         !same_key(&table->slots[at].key, key))
+    at = (at + 1) & table->slot_mask;
+  if (table->slots[at].group != 0ull) {
+    group = (size_t)(table->slots[at].group - 1ull);
+  } else if (table->group_count < table->group_capacity ||
+             grow_groups(table, value_count)) {
+    table->slots[at].key = *key;
+    table->slots[at].group = (unsigned long long)group + 1ull;
+    table->first_rows[group] = row;
+    table->counts[group] = 0;
+    for (int v = 0; v < value_count; v++) {
+      wide_zero(&table->sums[group * (size_t)value_count + (size_t)v]);
+    }
+    table->group_count++;
+    if (table->group_count * 2 > table->slot_mask + 1 && !grow_slots(table))
+      table->flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    table->flag = ARITHMETIC_BAD_INPUT;
+  }
+  return group;
+}
+
+static void accumulate(group_partition *table, const group_input *input,
+                       size_t group, size_t row) {
+  size_t base = group * (size_t)input->value_count;
+  int first = table->counts[group] == 0;
+  table->counts[group]++;
+  for (int v = 0; v < input->value_count; v++) {
+    const decimal *value = &input->values[v][row];
+    wide_int scaled;
+    wide_from_decimal(value, &scaled);
+    wide_mul_pow10(&scaled, input->scales[v] - get_scale(value));
+    if (get_sign(value)) wide_sub(&table->sums[base + v], &scaled);
+    else wide_add(&table->sums[base + v], &scaled);
+    if (first || decimal_compare_unchecked(*value, table->mins[base + v]) < 0)
+      table->mins[base + v] = *value;
+    if (first || decimal_compare_unchecked(*value, table->maxes[base + v]) > 0)
+      table->maxes[base + v] = *value;
+  }
+}
+
+// Keys and hashes for a chunk of rows, counted by partition.
+static void *hash_chunk(void *argument) {
+  group_job *job = argument;
+  const group_input *input = job->input;
+  for (size_t row = job->begin; row < job->end; row++) {
+    row_key(input, row, &input->keys[row]);
+    input->hashes[row] = hash_key(&input->keys[row]);
+    job->offsets[partition_of(input->hashes[row],
+                              input->partition_count)]++;
+  }
+  return NULL;
+}
+
+// Writes a chunk's rows to their partitions, from the chunk's offsets.
+static void *scatter_chunk(void *argument) {
+  group_job *job = argument;
+  const group_input *input = job->input;
+  for (size_t row = job->begin; row < job->end; row++)
+    input->rows[job->offsets[partition_of(input->hashes[row],
+                                          input->partition_count)]++] = row;
+  return NULL;
+}
+
+// A single partition hashes its rows as it goes; the others take theirs
+// from the hashing pass, so partitions share nothing and need no merging
+// of partial groups.
+static void *run_partition(void *argument) {
+  group_job *job = argument;
+  const group_input *input = job->input;
+  group_partition *table = job->table;
+  if (!grow_slots(table)) table->flag = ARITHMETIC_BAD_INPUT;
+  for (size_t i = job->begin; i < job->end && table->flag == ARITHMETIC_OK;
+       i++) {
+    decimal_key key;
+    const decimal_key *at = &key;
+    unsigned long long hash;
+    size_t row = i;
+    if (input->rows != NULL) {
+      row = input->rows[i];
+      at = &input->keys[row];
+      hash = input->hashes[row];
+    } else {
+      row_key(input, row, &key);
+      hash = hash_key(&key);
+    }
+    size_t group = find_group(table, at, hash, row, input->value_count);
+    if (table->flag == ARITHMETIC_OK) accumulate(table, input, group, row);
+  }
+  return NULL;
+}
+
+// Splits the rows into contiguous chunks that hash their keys in
+// parallel, then scatters the row numbers so that partition p owns
+// rows[bounds[p], bounds[p + 1]). Running out of memory is
+// ARITHMETIC_BAD_INPUT.
+static int partition_rows(group_input *input, size_t count,
+                          decimal_arena *scratch, group_job *jobs,
+                          size_t *bounds) {
+  int flag = ARITHMETIC_OK;
+  int chunks = input->partition_count;
+  size_t *offsets = decimal_arena_alloc(
+      scratch, (size_t)chunks * (size_t)chunks * sizeof(size_t));
+  input->keys = decimal_arena_alloc(scratch, count * sizeof(decimal_key));
+  input->hashes =
+      decimal_arena_alloc(scratch, count * sizeof(unsigned long long));
+  input->rows = decimal_arena_alloc(scratch, count * sizeof(size_t));
+  if (offsets == NULL || input->keys == NULL || input->hashes == NULL ||
+      input->rows == NULL)
+    flag = ARITHMETIC_BAD_INPUT;
+
+  if (flag == ARITHMETIC_OK) {
+    memset(offsets, 0, (size_t)chunks * (size_t)chunks * sizeof(size_t));
+    for (int c = 0; c < chunks; c++) {
+      jobs[c] = (group_job){input, count * (size_t)c / (size_t)chunks,
+                            count * (size_t)(c + 1) / (size_t)chunks,
+                            &offsets[(size_t)c * (size_t)chunks], NULL};
+    }
+    decimal_run_parallel(chunks, hash_chunk, jobs, sizeof(*jobs));
+    // Partition by partition, each chunk starts where the one before
+    // it ends, so every partition keeps its rows in order.
+    size_t next = 0;
+    for (int p = 0; p < chunks; p++) {
+      bounds[p] = next;
+      for (int c = 0; c < chunks; c++) {
+        size_t *offset = &offsets[(size_t)c * (size_t)chunks + (size_t)p];
+        size_t rows = *offset;
+        *offset = next;
+        next += rows;
+      }
+    }
+    bounds[chunks] = next;
+    decimal_run_parallel(chunks, scatter_chunk, jobs, sizeof(*jobs));
+  }
+  return flag;
+}
+
+// Sums go back to the column scale, rounding half-even only if the integer
+// part needs the room; a sum that does not fit is ARITHMETIC_BIG and left
+// at zero.
+static int finish_sum(wide_int *sum, int scale, decimal *result) {
+  int sign = (sum->words[WIDE_WORDS - 1] >> 31) != 0u;
+  decimal_zero(result);
+  if (sign) wide_negate(sum);
+  return wide_to_decimal(sum, scale, sign && !wide_is_zero(sum), result);
+}
+
+// Merges the partitions by first row, so the groups come out in order of
+// first appearance whatever the thread count.
+static int collect(group_partition *tables, int partition_count,
+                   const int *scales, int value_count, decimal_arena *arena,
+                   decimal_groups *groups) {
+  int flag = ARITHMETIC_OK;
+  size_t total = 0;
+  size_t next[DECIMAL_MAX_THREADS] = {0};
+  for (int p = 0; p < partition_count; p++) total += tables[p].group_count;
+  groups->group_count = total;
+  groups->value_count = value_count;
+  groups->first_rows = decimal_arena_alloc(arena, total * sizeof(size_t));
+  groups->counts = decimal_arena_alloc(arena, total * sizeof(size_t));
+  groups->aggregates = decimal_arena_alloc(
+      arena, total * (size_t)value_count * sizeof(decimal_aggregate));
+  if (total > 0 && (groups->first_rows == NULL || groups->counts == NULL ||
+                    (value_count > 0 && groups->aggregates == NULL)))
+    flag = ARITHMETIC_BAD_INPUT;
+  for (size_t g = 0; g < total && flag != ARITHMETIC_BAD_INPUT; g++) {
+    int from = -1;
+    for (int p = 0; p < partition_count; p++) {
+      if (next[p] < tables[p].group_count &&
+          (from < 0 || tables[p].first_rows[next[p]] <
+                           tables[from].first_rows[next[from]]))
+        from = p;
+    }
+    group_partition *table = &tables[from];
+    size_t source = next[from]++;
+    groups->first_rows[g] = table->first_rows[source];
+    groups->counts[g] = table->counts[source];
+    for (int v = 0; v < value_count; v++) {
+      size_t in = source * (size_t)value_count + (size_t)v;
+      decimal_aggregate *out = &groups->aggregates[g * (size_t)value_count +
+                                                   (size_t)v];
+      int status = finish_sum(&table->sums[in], scales[v], &out->sum);
+      if (flag == ARITHMETIC_OK) flag = status;
+      out->min = table->mins[in];
+      out->max = table->maxes[in];
+    }
+  }
+  return flag;
+}
+
+static int group_by(const long long *int_keys, const decimal *decimal_keys,
+                    const decimal *const *values, int value_count,
+                    size_t count, int threads, decimal_arena *arena,
+                    decimal_groups *groups) {
+  int flag = ARITHMETIC_OK;
+  int scales[DECIMAL_GROUP_MAX_VALUES] = {0};
+  group_partition tables[DECIMAL_MAX_THREADS];
+  group_job jobs[DECIMAL_MAX_THREADS];
+  size_t bounds[DECIMAL_MAX_THREADS + 1];
+  group_input input;
+  decimal_arena scratch;
+
+  decimal_arena_init(&scratch, 0);
+  if (arena == NULL || groups == NULL || value_count < 0 ||
+      value_count > DECIMAL_GROUP_MAX_VALUES ||
+      (count > 0 && (int_keys == NULL && decimal_keys == NULL)) ||
+      (value_count > 0 && values == NULL)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  }
+  if (flag == ARITHMETIC_OK && decimal_keys != NULL &&
+      decimal_first_invalid(decimal_keys, count) != count)
+    flag = ARITHMETIC_BAD_INPUT;
+  for (int v = 0; v < value_count && flag == ARITHMETIC_OK; v++) {
+    if (count > 0 && (values[v] == NULL ||
+                      decimal_first_invalid(values[v], count) != count))
+      flag = ARITHMETIC_BAD_INPUT;
+    for (size_t row = 0; row < count && flag == ARITHMETIC_OK; row++) {
+      if (get_scale(&values[v][row]) > scales[v])
+        scales[v] = get_scale(&values[v][row]);
+    }
+  }
+
+  if (flag == ARITHMETIC_OK) {
+    if (threads < 1) threads = 1;
+    if (threads > DECIMAL_MAX_THREADS) threads = DECIMAL_MAX_THREADS;
+    if ((size_t)threads > count) threads = count > 0 ? (int)count : 1;
+    input = (group_input){int_keys, decimal_keys, values, scales,
+                          value_count, threads, NULL, NULL, NULL};
+    bounds[0] = 0;
+    bounds[1] = count;
+    if (threads > 1)
+      flag = partition_rows(&input, count, &scratch, jobs, bounds);
+  }
+  if (flag == ARITHMETIC_OK) {
+    for (int p = 0; p < threads; p++) {
+      memset(&tables[p], 0, sizeof(tables[p]));
+      decimal_arena_init(&tables[p].arena, 0);
+      jobs[p] = (group_job){&input, bounds[p], bounds[p + 1], NULL,
+                            &tables[p]};
+    }
+    decimal_run_parallel(threads, run_partition, jobs, sizeof(*jobs));
+    for (int p = 0; p < threads && flag == ARITHMETIC_OK; p++)
+      flag = tables[p].flag;
+    if (flag == ARITHMETIC_OK)
+      flag = collect(tables, threads, scales, value_count, arena, groups);
+    for (int p = 0; p < threads; p++) decimal_arena_release(&tables[p].arena);
+  }
+  decimal_arena_release(&scratch);
+
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Groups rows by keys[row] and aggregates each of the value columns per
+// group, splitting the rows across `threads` hash partitions. The result
+// arrays are allocated from `arena`. Invalid values, a missing column or
+// running out of memory are ARITHMETIC_BAD_INPUT; a sum that does not fit
+// is ARITHMETIC_BIG, with the other groups still complete.
+int decimal_group_by_int(const long long *keys, const decimal *const *values,
+                         int value_count, size_t count, int threads,
+                         decimal_arena *arena, decimal_groups *groups) {
+  return group_by(keys, NULL, values, value_count, count, threads, arena,
+                  groups);
+}
+
+// As decimal_group_by_int with decimal keys compared by value, so 1.5 and
+// 1.50 fall into the same group.
+int decimal_group_by_decimal(const decimal *keys,
+                             const decimal *const *values, int value_count,
+                             size_t count, int threads, decimal_arena *arena,
+                             decimal_groups *groups) {
+  return group_by(NULL, keys, values, value_count, count, threads, arena,
+                  groups);
+}
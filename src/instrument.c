@@ -0,0 +1,101 @@
+#include <time.h>
+
+#include "decimal.h"
+
+// Like the status context, the counters are per thread and updated without
+// locks. In a build without DECIMAL_INSTRUMENT nothing calls the recording
+// functions, so every snapshot is zero.
+static _Thread_local decimal_instrument_stats current_stats;
+
+static const char *const kOpNames[DECIMAL_OP_COUNT] = {
+    "add", "sub", "mul", "div", "divmod", "mod"};
+static const char *const kEventNames[DECIMAL_EVENT_COUNT] = {
+    "add rescale", "mul general",   "mul overflow", "bank_round",
+    "normalize",   "normalize x10", "div_abs step"};
+
+// Time stamp counter where there is one, nanoseconds otherwise.
+unsigned long long decimal_instrument_ticks(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+static int cycle_bucket(unsigned long long ticks) {
+  int bucket = 0;
+  while (ticks > 1ull && bucket < DECIMAL_INSTRUMENT_BUCKETS - 1) {
+    ticks >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+static void count_scale(const decimal *value) {
+  int scale = get_scale(value);
+  if (scale <= 28) current_stats.scales[scale]++;
+}
+
+void decimal_instrument_op(int op, unsigned long long start,
+                           const decimal *value_1, const decimal *value_2) {
+  unsigned long long elapsed = decimal_instrument_ticks() - start;
+  current_stats.calls[op]++;
+  current_stats.cycles[op][cycle_bucket(elapsed)]++;
+  count_scale(value_1);
+  count_scale(value_2);
+}
+
+void decimal_instrument_event(int event) { current_stats.events[event]++; }
+
+// Copies the calling thread's counters.
+void decimal_instrument_snapshot(decimal_instrument_stats *stats) {
+  if (stats != NULL) *stats = current_stats;
+}
+
+void decimal_instrument_reset(void) {
+  memset(&current_stats, 0, sizeof(current_stats));
+}
+
+// Adds one thread's snapshot into a running total.
+void decimal_instrument_merge(decimal_instrument_stats *total,
+                              const decimal_instrument_stats *stats) {
+  if (total != NULL && stats != NULL) {
+    for (int op = 0; op < DECIMAL_OP_COUNT; op++) {
+      total->calls[op] += stats->calls[op];
+      for (int b = 0; b < DECIMAL_INSTRUMENT_BUCKETS; b++)
+        total->cycles[op][b] += stats->cycles[op][b];
+    }
+    for (int event = 0; event < DECIMAL_EVENT_COUNT; event++)
+      total->events[event] += stats->events[event];
+    for (int scale = 0; scale <= 28; scale++)
+      total->scales[scale] += stats->scales[scale];
+  }
+}
+
+// One line per operation with its non-empty cycle buckets as
+// "2^b:count", then the slow-path events and the non-zero operand scales.
+void decimal_instrument_dump(const decimal_instrument_stats *stats,
+                             FILE *out) {
+  if (stats != NULL && out != NULL) {
+    for (int op = 0; op < DECIMAL_OP_COUNT; op++) {
+      fprintf(out, "%-8s %12llu calls", kOpNames[op], stats->calls[op]);
+      for (int b = 0; b < DECIMAL_INSTRUMENT_BUCKETS; b++) {
+        if (stats->cycles[op][b] != 0ull)
+          fprintf(out, " 2^%d:%llu", b, stats->cycles[op][b]);
+      }
+      fputc('\n', out);
+    }
+    for (int event = 0; event < DECIMAL_EVENT_COUNT; event++)
+      fprintf(out, "%-14s %12llu\n", kEventNames[event],
+              stats->events[event]);
+    fprintf(out, "scales");
+    for (int scale = 0; scale <= 28; scale++) {
+      if (stats->scales[scale] != 0ull)
+        fprintf(out, " %d:%llu", scale, stats->scales[scale]);
+    }
+    fputc('\n', out);
+  }
+}
@@ -0,0 +1,20 @@
+#include <pthread.h>
+
+#include "decimal.h"
+
+void decimal_run_parallel(int count, void *(*work)(void *), void *tasks,
+                          size_t size) {
+  unsigned char *task = tasks;
+  pthread_t workers[DECIMAL_MAX_THREADS];
+  int started[DECIMAL_MAX_THREADS] = {0};
+  if (count > DECIMAL_MAX_THREADS) count = DECIMAL_MAX_THREADS;
+  // A task whose thread cannot be started runs on this one.
+  for (int t = 1; t < count; t++)
+    started[t] = pthread_create(&workers[t], NULL, work,
+                                task + (size_t)t * size) == 0;
+  if (count > 0) work(task);
+  for (int t = 1; t < count; t++) {
+    if (started[t]) pthread_join(workers[t], NULL);
+    else work(task + (size_t)t * size);
+  }
+}
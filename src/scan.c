@@ -0,0 +1,246 @@
+#include "decimal.h"
+
+// Below this many values per thread the sequential loop is faster than
+// two passes plus thread start-up.
+#define SCAN_MIN_CHUNK 4096
+
+// A signed running total: a two's-complement wide_int at `scale`, the
+// largest scale among the values added so far.
+typedef struct {
+  wide_int sum;
+  int scale;
+} scan_total;
+
+typedef struct {
+  const decimal *values;
+  decimal *results;
+  int *flags;
+  size_t count;
+  size_t begin;
+  size_t end;
+  int exclusive;
+  // In-place scans write this chunk's results here instead; see scan.
+  decimal *staged;
+  scan_total total;
+  // First index whose running total the add loop would round, or `end`
+  // when there is none.
+  size_t first_unexact;
+} scan_chunk;
+
+static void total_add(scan_total *total, const decimal *value) {
+  int scale = get_scale(value);
+  wide_int addend;
+  wide_from_decimal(value, &addend);
+  if (scale > total->scale) {
+    wide_mul_pow10(&total->sum, scale - total->scale);
+    total->scale = scale;
+  } else {
+    wide_mul_pow10(&addend, total->scale - scale);
+  }
+  if (get_sign(value)) wide_sub(&total->sum, &addend);
+  else wide_add(&total->sum, &addend);
+}
+
+static void total_merge(scan_total *total, const scan_total *other) {
+  wide_int addend = other->sum;
+  if (other->scale > total->scale) {
+    wide_mul_pow10(&total->sum, other->scale - total->scale);
+    total->scale = other->scale;
+  } else {
+    wide_mul_pow10(&addend, total->scale - other->scale);
+  }
+  wide_add(&total->sum, &addend);
+}
+
+// The total as a decimal when it fits without rounding; that is exactly
+// what a chain of add calls produces up to this point.
+static int total_to_decimal(const scan_total *total, decimal *result) {
+  wide_int magnitude = total->sum;
+  int sign = (magnitude.words[WIDE_WORDS - 1] >> 31) != 0u;
+  if (sign) wide_negate(&magnitude);
+  int fits = wide_fits_u96(&magnitude);
+  if (fits) {
+    result->bits[0] = (int)magnitude.words[0];
+    result->bits[1] = (int)magnitude.words[1];
+    result->bits[2] = (int)magnitude.words[2];
+    result->bits[3] = (int)(((unsigned int)total->scale << 16) |
+                            ((unsigned int)sign << 31));
+  }
+  return fits;
+}
+
+static void total_from_decimal(const decimal *value, scan_total *total) {
+  wide_from_decimal(value, &total->sum);
+  if (get_sign(value)) wide_negate(&total->sum);
+  total->scale = get_scale(value);
+}
+
+// add is exact unless it has to give up scale, which is how it rounds.
+static int add_exact(decimal sum, decimal value, decimal *result) {
+  int scale = get_scale(&sum) > get_scale(&value) ? get_scale(&sum)
+                                                  : get_scale(&value);
+  return add_unchecked(sum, value, result) == ARITHMETIC_OK &&
+         get_scale(result) == scale;
+}
+
+// First pass: the chunk's sum through the same add chain as the second
+// pass, and through exact wide totals only if that chain would round.
+static void *sum_chunk(void *argument) {
+  scan_chunk *chunk = argument;
+  decimal sum;
+  size_t i = chunk->begin;
+  decimal_zero(&sum);
+  while (i < chunk->end && add_exact(sum, chunk->values[i], &sum)) i++;
+  if (i == chunk->end) {
+    total_from_decimal(&sum, &chunk->total);
+  } else {
+    for (i = chunk->begin; i < chunk->end; i++)
+      total_add(&chunk->total, &chunk->values[i]);
+  }
+  return NULL;
+}
+
+// Second pass: chunk->total holds the exact sum of everything before the
+// chunk, which is what the reference loop holds there as long as none of
+// its adds rounded. From that start the chunk runs the loop itself and
+// stops at the first add that would round.
+static void *write_chunk(void *argument) {
+  scan_chunk *chunk = argument;
+  decimal sum;
+  chunk->first_unexact = chunk->begin;
+  if (total_to_decimal(&chunk->total, &sum)) {
+    size_t i = chunk->begin;
+    for (; i < chunk->end && add_exact(sum, chunk->values[i], &sum); i++) {
+      if (chunk->staged != NULL) chunk->staged[i - chunk->begin] = sum;
+      else if (!chunk->exclusive) chunk->results[i] = sum;
+      else if (i + 1 < chunk->count) chunk->results[i + 1] = sum;
+      if (chunk->flags != NULL) chunk->flags[i] = ARITHMETIC_OK;
+    }
+    chunk->first_unexact = i;
+  }
+  return NULL;
+}
+
+// The reference loop from `begin` on, starting from `sum`. A failing add
+// leaves the running total unchanged.
+static int scan_sequential(const decimal *values, decimal *results,
+                           int *flags, size_t begin, size_t count,
+                           int exclusive, decimal sum) {
+  int flag = ARITHMETIC_OK;
+  for (size_t i = begin; i < count; i++) {
+    decimal value = values[i];
+    if (exclusive) results[i] = sum;
+    int status = add(sum, value, &sum);
+    if (!exclusive) results[i] = sum;
+    if (flags != NULL) flags[i] = status;
+    if (flag == ARITHMETIC_OK) flag = status;
+  }
+  return flag;
+}
+
+static int scan(const decimal *values, decimal *results, int *flags,
+                size_t count, int threads, int exclusive) {
+  int flag = ARITHMETIC_OK;
+  scan_chunk chunks[DECIMAL_MAX_THREADS];
+  decimal_arena arena;
+  decimal *staged = NULL;
+  decimal zero;
+  decimal_zero(&zero);
+  decimal_arena_init(&arena, 0);
+
+  if (count > 0 && (values == NULL || results == NULL)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    if (threads > DECIMAL_MAX_THREADS) threads = DECIMAL_MAX_THREADS;
+    if (threads > 1 && count / (size_t)threads < SCAN_MIN_CHUNK)
+      threads = (int)(count / SCAN_MIN_CHUNK);
+    // Malformed values take the reference loop, which reports them the
+    // way add does.
+    if (threads > 1 && decimal_first_invalid(values, count) != count)
+      threads = 1;
+    // In place, a chunk's results overwrite inputs that the reference
+    // loop reads again if an earlier chunk turns out to round. Chunks
+    // after the first write to a staging copy until that is known.
+    if (threads > 1 && results == values) {
+      size_t first_end = count / (size_t)threads;
+      staged = decimal_arena_alloc(&arena,
+                                   (count - first_end) * sizeof(decimal));
+      if (staged == NULL) threads = 1;
+    }
+  }
+
+  if (flag == ARITHMETIC_OK && threads <= 1) {
+    flag = scan_sequential(values, results, flags, 0, count, exclusive,
+                           zero);
+  } else if (flag == ARITHMETIC_OK) {
+    size_t unexact = count;
+    // Chunks that run on this thread may try adds the reference loop never
+    // makes; only the loop's own statuses are reported.
+    unsigned int status = decimal_context_get()->status;
+    for (int c = 0; c < threads; c++) {
+      size_t begin = count * (size_t)c / (size_t)threads;
+      chunks[c] = (scan_chunk){values, results, flags, count, begin,
+                               count * (size_t)(c + 1) / (size_t)threads,
+                               exclusive, NULL, {{{0}}, 0}, count};
+      if (staged != NULL && c > 0)
+        chunks[c].staged = staged + (begin - chunks[0].end);
+    }
+    decimal_run_parallel(threads, sum_chunk, chunks, sizeof(*chunks));
+    // Turn the chunk sums into the exact total before each chunk.
+    scan_total before = {{{0}}, 0};
+    for (int c = 0; c < threads; c++) {
+      scan_total sum = chunks[c].total;
+      chunks[c].total = before;
+      total_merge(&before, &sum);
+    }
+    decimal_run_parallel(threads, write_chunk, chunks, sizeof(*chunks));
+    decimal_context_get()->status = status;
+    for (int c = 0; c < threads && unexact == count; c++)
+      unexact = chunks[c].first_unexact < chunks[c].end
+                    ? chunks[c].first_unexact
+                    : count;
+    for (int c = 1; staged != NULL && c < threads; c++) {
+      size_t end = chunks[c].first_unexact < unexact ? chunks[c].first_unexact
+                                                     : unexact;
+      for (size_t i = chunks[c].begin; i < end; i++)
+        results[i] = chunks[c].staged[i - chunks[c].begin];
+    }
+    if (exclusive) results[0] = zero;
+    // From the first total that needs rounding on, the running sum depends
+    // on every earlier rounding step, so only the reference loop can
+    // reproduce it.
+    if (unexact < count) {
+      decimal sum = zero;
+      if (unexact > 0)
+        sum = exclusive ? results[unexact] : results[unexact - 1];
+      flag = scan_sequential(values, results, flags, unexact, count,
+                             exclusive, sum);
+    }
+  }
+
+  decimal_arena_release(&arena);
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// results[i] = values[0] + ... + values[i], bit-identical to the loop
+//   sum = 0; for each i: add(sum, values[i], &sum); results[i] = sum;
+// in which an add that fails leaves sum unchanged. flags, if not NULL,
+// receives each add's status. With threads > 1 the values are split
+// into chunks that each run the loop from their exact starting total,
+// found by a first pass over the chunk sums; the loop itself takes over
+// from the first add that would round. results may be values; in place,
+// the chunks after the first stage their results in scratch memory until
+// the first rounding add is known.
+int decimal_scan_inclusive(const decimal *values, decimal *results,
+                           int *flags, size_t count, int threads) {
+  return scan(values, results, flags, count, threads, 0);
+}
+
+// results[i] = values[0] + ... + values[i - 1], with results[0] = 0, from
+// the same loop writing sum before each add. results must not overlap
+// values.
+int decimal_scan_exclusive(const decimal *values, decimal *results,
+                           int *flags, size_t count, int threads) {
+  return scan(values, results, flags, count, threads, 1);
+}
@@ -0,0 +1,305 @@
+#include "decimal.h"
+
+// Below this many values per thread one thread is faster than several.
+#define STATS_MIN_CHUNK 4096
+#define STATS_SCALES 29
+#define STATS_PRODUCT_SCALES (2 * STATS_SCALES - 1)
+
+// Exact sums of mantissas, one two's-complement wide_int per scale so that
+// nothing is rescaled while accumulating. `sums` holds the values (or the
+// weights) at their scale; `products` the squares (or weight * value) at
+// the sum of the two scales. Each mantissa product is below 2^192, so
+// neither overflows before 2^63 values.
+typedef struct {
+  wide_int sums[STATS_SCALES];
+  wide_int products[STATS_PRODUCT_SCALES];
+  unsigned long long used_sums;      // bit s: sums[s] was touched
+  unsigned long long used_products;  // bit s: products[s] was touched
+} stats_moments;
+
+typedef struct {
+  const decimal *values;
+  const decimal *weights;  // NULL: products are squares of the values
+  size_t begin;
+  size_t end;
+  int products;  // products are wanted at all
+  stats_moments moments;
+} stats_chunk;
+
+// sum +/- the `length`-word magnitude in words, with the carry or borrow
+// carried only as far as it goes.
+static void add_words(wide_int *sum, const unsigned int *words, int length,
+                      int sign) {
+  unsigned long long carry = 0ull;
+  int i = 0;
+  if (!sign) {
+    for (; i < length; i++) {
+      carry += (unsigned long long)sum->words[i] + words[i];
+      sum->words[i] = (unsigned int)carry;
+      carry >>= 32;
+    }
+    for (; i < WIDE_WORDS && carry != 0ull; i++) carry = ++sum->words[i] == 0u;
+  } else {
+    for (; i < length; i++) {
+      unsigned long long t =
+          (unsigned long long)sum->words[i] - words[i] - carry;
+      sum->words[i] = (unsigned int)t;
+      carry = (t >> 32) != 0ull;
+    }
+    for (; i < WIDE_WORDS && carry != 0ull; i++)
+      carry = sum->words[i]-- == 0u;
+  }
+}
+
+static void accumulate(wide_int *sum, const decimal *value_1,
+                       const decimal *value_2, int sign) {
+  unsigned int words[6];
+  mul_words(value_1, value_2, words);
+  add_words(sum, words, 6, sign);
+}
+
+static void accumulate_value(wide_int *sum, const decimal *value) {
+  add_words(sum, (const unsigned int *)value->bits, 3, get_sign(value));
+}
+
+static void *run_chunk(void *argument) {
+  stats_chunk *chunk = argument;
+  stats_moments *moments = &chunk->moments;
+  memset(moments, 0, sizeof(*moments));
+  for (size_t i = chunk->begin; i < chunk->end; i++) {
+    const decimal *value = &chunk->values[i];
+    int scale = get_scale(value);
+    if (chunk->weights == NULL) {
+      accumulate_value(&moments->sums[scale], value);
+      moments->used_sums |= 1ull << scale;
+      if (chunk->products) {
+        accumulate(&moments->products[2 * scale], value, value, 0);
+        moments->used_products |= 1ull << (2 * scale);
+      }
+    } else {
+      const decimal *weight = &chunk->weights[i];
+      int weight_scale = get_scale(weight);
+      accumulate_value(&moments->sums[weight_scale], weight);
+      moments->used_sums |= 1ull << weight_scale;
+      accumulate(&moments->products[scale + weight_scale], value, weight,
+                 get_sign(value) ^ get_sign(weight));
+      moments->used_products |= 1ull << (scale + weight_scale);
+    }
+  }
+  return NULL;
+}
+
+// Splits [0, count) over up to `threads` threads and adds up their moments.
+static void gather(const decimal *values, const decimal *weights,
+                   size_t count, int products, int threads,
+                   stats_moments *moments) {
+  stats_chunk chunks[DECIMAL_MAX_THREADS];
+  if (threads > DECIMAL_MAX_THREADS) threads = DECIMAL_MAX_THREADS;
+  if (threads > 1 && count / (size_t)threads < STATS_MIN_CHUNK)
+    threads = (int)(count / STATS_MIN_CHUNK);
+  if (threads < 1) threads = 1;
+
+  for (int c = 0; c < threads; c++) {
+    chunks[c].values = values;
+    chunks[c].weights = weights;
+    chunks[c].begin = count * (size_t)c / (size_t)threads;
+    chunks[c].end = count * (size_t)(c + 1) / (size_t)threads;
+    chunks[c].products = products;
+  }
+  decimal_run_parallel(threads, run_chunk, chunks, sizeof(*chunks));
+
+  *moments = chunks[0].moments;
+  for (int c = 1; c < threads; c++) {
+    const stats_moments *other = &chunks[c].moments;
+    for (int s = 0; s < STATS_SCALES; s++)
+      if (other->used_sums >> s & 1u)
+        wide_add(&moments->sums[s], &other->sums[s]);
+    for (int s = 0; s < STATS_PRODUCT_SCALES; s++)
+      if (other->used_products >> s & 1u)
+        wide_add(&moments->products[s], &other->products[s]);
+    moments->used_sums |= other->used_sums;
+    moments->used_products |= other->used_products;
+  }
+}
+
+// The exact total of per-scale sums, sums[s] being at scale s.
+static int total(const wide_int *sums, unsigned long long used, int count,
+                 decimal_arena *arena, bigdecimal *result) {
+  int flag = ARITHMETIC_OK;
+  wide_int zero;
+  wide_zero(&zero);
+  flag = bigdecimal_from_wide(&zero, 0, 0, arena, result);
+  for (int s = 0; s < count && flag == ARITHMETIC_OK; s++) {
+    if (used >> s & 1u) {
+      wide_int magnitude = sums[s];
+      int sign = (magnitude.words[WIDE_WORDS - 1] >> 31) != 0u;
+      bigdecimal term;
+      bigdecimal next;
+      if (sign) wide_negate(&magnitude);
+      flag = bigdecimal_from_wide(&magnitude, s, sign, arena, &term);
+      if (flag == ARITHMETIC_OK)
+        flag = bigdecimal_add(result, &term, arena, &next);
+      if (flag == ARITHMETIC_OK) *result = next;
+    }
+  }
+  return flag;
+}
+
+static void wide_decimal_from_count(unsigned long long count,
+                                    wide_decimal *result) {
+  wide_zero(&result->mantissa);
+  result->mantissa.words[0] = (unsigned int)count;
+  result->mantissa.words[1] = (unsigned int)(count >> 32);
+  result->exponent = 0;
+  result->sign = 0;
+  wide_decimal_normalize(result);
+}
+
+// numerator / denominator into a decimal, both exact. The numerator is
+// rounded to 38 digits, the quotient (and root) is formed at 38 digits,
+// and that is rounded half-even into the result. A decimal has at most 29
+// digits, so at least nine guard digits separate the two roundings: the
+// result is the correctly rounded one unless the exact quotient lies
+// within a few units of its 38th digit of a half-way point.
+static int quotient(const bigdecimal *numerator,
+                    const wide_decimal *denominator, int root,
+                    decimal_arena *arena, decimal *result) {
+  wide_decimal value;
+  int flag = bigdecimal_to_wide_decimal(numerator, arena, &value);
+  if (flag == ARITHMETIC_OK) {
+    wide_decimal_div(&value, denominator, &value);
+    if (root && !wide_is_zero(&value.mantissa))
+      wide_decimal_sqrt(&value, &value);
+    flag = wide_decimal_to_decimal(&value, result);
+  }
+  return flag;
+}
+
+static int check_input(const decimal *values, const decimal *weights,
+                       size_t count, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (result == NULL || (count > 0 && values == NULL))
+    flag = ARITHMETIC_BAD_INPUT;
+  else if (decimal_first_invalid(values, count) != count)
+    flag = ARITHMETIC_BAD_INPUT;
+  else if (weights != NULL && decimal_first_invalid(weights, count) != count)
+    flag = ARITHMETIC_BAD_INPUT;
+  return flag;
+}
+
+// Variance (`root` 0) or standard deviation: n * sum(x^2) - sum(x)^2 is
+// formed exactly and divided by n^2, or by n * (n - 1) for a sample.
+static int spread(const decimal *values, size_t count, int sample,
+                  int threads, int root, decimal *result) {
+  int flag = check_input(values, NULL, count, result);
+  if (flag == ARITHMETIC_OK && count < (sample ? 2u : 1u))
+    flag = ARITHMETIC_DIV_BY_ZERO;
+  if (flag == ARITHMETIC_OK) {
+    stats_moments moments;
+    decimal_arena arena;
+    bigdecimal sum, squares, n, scaled, squared, centered;
+    wide_decimal divisor, other;
+    decimal_arena_init(&arena, 0);
+    gather(values, NULL, count, 1, threads, &moments);
+    flag = total(moments.sums, moments.used_sums, STATS_SCALES, &arena,
+                 &sum);
+    if (flag == ARITHMETIC_OK)
+      flag = total(moments.products, moments.used_products,
+                   STATS_PRODUCT_SCALES, &arena, &squares);
+    if (flag == ARITHMETIC_OK) {
+      wide_int wide_count;
+      wide_zero(&wide_count);
+      wide_count.words[0] = (unsigned int)count;
+      wide_count.words[1] = (unsigned int)((unsigned long long)count >> 32);
+      flag = bigdecimal_from_wide(&wide_count, 0, 0, &arena, &n);
+    }
+    if (flag == ARITHMETIC_OK)
+      flag = bigdecimal_mul(&n, &squares, &arena, &scaled);
+    if (flag == ARITHMETIC_OK)
+      flag = bigdecimal_mul(&sum, &sum, &arena, &squared);
+    if (flag == ARITHMETIC_OK)
+      flag = bigdecimal_sub(&scaled, &squared, &arena, &centered);
+    if (flag == ARITHMETIC_OK) {
+      wide_decimal_from_count(count, &divisor);
+      wide_decimal_from_count(sample ? count - 1 : count, &other);
+      wide_decimal_mul(&divisor, &other, &divisor);
+      flag = quotient(&centered, &divisor, root, &arena, result);
+    }
+    decimal_arena_release(&arena);
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// The arithmetic mean of values[0..count): the exact sum divided as in
+// quotient().
+// DIV_BY_ZERO when count is 0. threads > 1 splits large arrays across
+// threads; the result does not depend on the thread count.
+int decimal_mean(const decimal *values, size_t count, int threads,
+                 decimal *result) {
+  int flag = check_input(values, NULL, count, result);
+  if (flag == ARITHMETIC_OK && count == 0) flag = ARITHMETIC_DIV_BY_ZERO;
+  if (flag == ARITHMETIC_OK) {
+    stats_moments moments;
+    decimal_arena arena;
+    bigdecimal sum;
+    wide_decimal divisor;
+    decimal_arena_init(&arena, 0);
+    gather(values, NULL, count, 0, threads, &moments);
+    flag = total(moments.sums, moments.used_sums, STATS_SCALES, &arena,
+                 &sum);
+    wide_decimal_from_count(count, &divisor);
+    if (flag == ARITHMETIC_OK)
+      flag = quotient(&sum, &divisor, 0, &arena, result);
+    decimal_arena_release(&arena);
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
+// Population (sample 0) or sample (sample 1) variance from exact sums,
+// with the guard digits of quotient(). DIV_BY_ZERO without enough values.
+int decimal_variance(const decimal *values, size_t count, int sample,
+                     int threads, decimal *result) {
+  return spread(values, count, sample, threads, 0, result);
+}
+
+// The square root of decimal_variance, taken at 38 digits before the
+// final rounding.
+int decimal_stddev(const decimal *values, size_t count, int sample,
+                   int threads, decimal *result) {
+  return spread(values, count, sample, threads, 1, result);
+}
+
+// sum(values[i] * weights[i]) / sum(weights[i]) with both sums exact, as
+// for a volume-weighted average price. The weight sum is rounded to 38
+// digits like the numerator before dividing. DIV_BY_ZERO when the weights
+// add up to zero.
+int decimal_weighted_mean(const decimal *values, const decimal *weights,
+                          size_t count, int threads, decimal *result) {
+  int flag = check_input(values, weights, count, result);
+  if (flag == ARITHMETIC_OK && count > 0 && weights == NULL)
+    flag = ARITHMETIC_BAD_INPUT;
+  if (flag == ARITHMETIC_OK) {
+    stats_moments moments;
+    decimal_arena arena;
+    bigdecimal weight_sum, product_sum;
+    wide_decimal divisor;
+    decimal_arena_init(&arena, 0);
+    gather(values, weights, count, 1, threads, &moments);
+    flag = total(moments.sums, moments.used_sums, STATS_SCALES, &arena,
+                 &weight_sum);
+    if (flag == ARITHMETIC_OK)
+      flag = total(moments.products, moments.used_products,
+                   STATS_PRODUCT_SCALES, &arena, &product_sum);
+    if (flag == ARITHMETIC_OK)
+      flag = bigdecimal_to_wide_decimal(&weight_sum, &arena, &divisor);
+    if (flag == ARITHMETIC_OK && wide_is_zero(&divisor.mantissa))
+      flag = ARITHMETIC_DIV_BY_ZERO;
+    if (flag == ARITHMETIC_OK)
+      flag = quotient(&product_sum, &divisor, 0, &arena, result);
+    decimal_arena_release(&arena);
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
@@ -1,5 +1,9 @@
 #include <check.h>
+#include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
 
 #include "decimal.h"
 
@@ -853,6 +857,1606 @@ START_TEST(test_mul_large_scale) {
 }
 END_TEST
 
+START_TEST(test_add_same_scale_carry_into_high_word) {
+  decimal a = {{(int)0xFFFFFFFF, (int)0xFFFFFFFF, 0, 0}};
+  decimal b = {{1, 0, 0, 0}};
+  set_scale(&a, 3);
+  set_scale(&b, 3);
+  decimal result;
+
+  ck_assert_int_eq(add(a, b, &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 0);
+  ck_assert_int_eq(result.bits[1], 0);
+  ck_assert_int_eq(result.bits[2], 1);
+  ck_assert_int_eq(get_scale(&result), 3);
+  ck_assert_int_eq(get_sign(&result), 0);
+}
+END_TEST
+
+START_TEST(test_sub_same_scale_sign_flip) {
+  decimal a = make_dec_int(150, 2);
+  decimal b = make_dec_int(275, 2);
+  decimal result;
+
+  ck_assert_int_eq(sub(a, b, &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 125);
+  ck_assert_int_eq(get_scale(&result), 2);
+  ck_assert_int_eq(get_sign(&result), 1);
+
+  ck_assert_int_eq(add(b, make_dec_int(-275, 2), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(is_zero(result), 1);
+  ck_assert_int_eq(get_sign(&result), 0);
+  ck_assert_int_eq(get_scale(&result), 2);
+}
+END_TEST
+
+START_TEST(test_add_mixed_scale_near_overflow) {
+  decimal max = {{(int)0xFFFFFFFF, (int)0xFFFFFFFF, (int)0xFFFFFFFF, 0}};
+  decimal fraction = make_dec_int(4, 1);
+  decimal result;
+
+  ck_assert_int_eq(add(max, fraction, &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], (int)0xFFFFFFFF);
+  ck_assert_int_eq(result.bits[1], (int)0xFFFFFFFF);
+  ck_assert_int_eq(result.bits[2], (int)0xFFFFFFFF);
+  ck_assert_int_eq(get_scale(&result), 0);
+
+  ck_assert_int_eq(add(max, make_dec_int(5, 1), &result), ARITHMETIC_BIG);
+  ck_assert_int_eq(sub(max, make_dec_int(6, 1), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], (int)0xFFFFFFFE);
+  ck_assert_int_eq(get_scale(&result), 0);
+}
+END_TEST
+
+START_TEST(test_add_mixed_scale_bankers_rounding) {
+  decimal big = {{0x10000000, 0x3E250261, 0x204FCE5E, 0}};  // 10^28
+  decimal result;
+
+  ck_assert_int_eq(add(big, make_dec_int(5, 1), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 0x10000000);
+  ck_assert_int_eq(get_scale(&result), 0);
+
+  ck_assert_int_eq(add(big, make_dec_int(15, 1), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 0x10000002);
+  ck_assert_int_eq(get_scale(&result), 0);
+
+  ck_assert_int_eq(add(make_dec_int(15, 1), big, &result), ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 0x10000002);
+
+  ck_assert_int_eq(add(make_dec_int(0, 0), make_dec_int(15, 1), &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(result.bits[0], 15);
+  ck_assert_int_eq(get_scale(&result), 1);
+}
+END_TEST
+
+#define STRESS_THREADS 64
+#define STRESS_VALUES 256
+#define STRESS_ROUNDS 8
+#define STRESS_OPS 14
+
+typedef struct {
+  int status;
+  decimal value;
+} stress_result;
+
+typedef struct {
+  const decimal *inputs;
+  const stress_result *expected;
+  unsigned int expected_status;
+  int mismatches;
+} stress_job;
+
+static void stress_fill_inputs(decimal *inputs) {
+  unsigned int state = 12345u;
+  for (int i = 0; i < STRESS_VALUES; i++) {
+    decimal_zero(&inputs[i]);
+    for (int w = 0; w < 3; w++) {
+      state = state * 1103515245u + 12345u;
+      inputs[i].bits[w] = (int)(state >> (w == 2 && i % 3 ? 12 : 0));
+    }
+    set_scale(&inputs[i], (int)(state % 29u));
+    set_sign(&inputs[i], (int)((state >> 7) & 1u));
+  }
+  decimal_zero(&inputs[0]);
+}
+
+static void stress_run_ops(decimal a, decimal b, stress_result *out) {
+  memset(out, 0, sizeof(stress_result) * STRESS_OPS);
+  out[0].status = add(a, b, &out[0].value);
+  out[1].status = sub(a, b, &out[1].value);
+  out[2].status = mul(a, b, &out[2].value);
+  out[3].status = div(a, b, &out[3].value);
+  out[4].status = is_less(a, b);
+  out[5].status = is_less_or_equal(a, b);
+  out[6].status = is_greater(a, b);
+  out[7].status = is_greater_or_equal(a, b);
+  out[8].status = is_equal(a, b) | (is_not_equal(a, b) << 1);
+  out[9].status = floor_decimal(a, &out[9].value);
+  out[10].status = round_decimal(a, &out[10].value);
+  out[11].status = truncate_decimal(a, &out[11].value);
+  out[12].status = negate_decimal(a, &out[12].value);
+  out[13].status = from_decimal_to_int(b, &out[13].value.bits[0]);
+}
+
+static int stress_run_all(const decimal *inputs, stress_result *results) {
+  int mismatches = 0;
+  for (int i = 0; i < STRESS_VALUES; i++) {
+    stress_result current[STRESS_OPS];
+    int j = (i * 7 + 3) % STRESS_VALUES;
+    stress_run_ops(inputs[i], inputs[j], current);
+    stress_result *slot = &results[i * STRESS_OPS];
+    if (memcmp(slot, current, sizeof(current)) != 0) mismatches++;
+    memcpy(slot, current, sizeof(current));
+  }
+  return mismatches;
+}
+
+static void *stress_worker(void *arg) {
+  stress_job *job = (stress_job *)arg;
+  static _Thread_local stress_result results[STRESS_VALUES * STRESS_OPS];
+  decimal_context_reset();
+  for (int round = 0; round < STRESS_ROUNDS; round++) {
+    memcpy(results, job->expected, sizeof(results));
+    job->mismatches += stress_run_all(job->inputs, results);
+  }
+  if (decimal_context_get()->status != job->expected_status)
+    job->mismatches++;
+  return NULL;
+}
+
+START_TEST(test_threads_match_single_threaded) {
+  static decimal inputs[STRESS_VALUES];
+  static stress_result expected[STRESS_VALUES * STRESS_OPS];
+  stress_fill_inputs(inputs);
+  decimal_context_reset();
+  stress_run_all(inputs, expected);
+  unsigned int expected_status = decimal_context_get()->status;
+
+  pthread_t threads[STRESS_THREADS];
+  stress_job jobs[STRESS_THREADS];
+  for (int i = 0; i < STRESS_THREADS; i++) {
+    jobs[i].inputs = inputs;
+    jobs[i].expected = expected;
+    jobs[i].expected_status = expected_status;
+    jobs[i].mismatches = 0;
+    ck_assert_int_eq(pthread_create(&threads[i], NULL, stress_worker, &jobs[i]),
+                     0);
+  }
+  for (int i = 0; i < STRESS_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    ck_assert_int_eq(jobs[i].mismatches, 0);
+  }
+}
+END_TEST
+
+static void *overflow_worker(void *arg) {
+  decimal max = {{(int)0xFFFFFFFF, (int)0xFFFFFFFF, (int)0xFFFFFFFF, 0}};
+  decimal result;
+  decimal_context_reset();
+  add(max, max, &result);
+  *(unsigned int *)arg = decimal_context_get()->status;
+  return NULL;
+}
+
+START_TEST(test_context_is_per_thread) {
+  decimal_context_reset();
+  unsigned int worker_status = 0u;
+  pthread_t thread;
+  ck_assert_int_eq(
+      pthread_create(&thread, NULL, overflow_worker, &worker_status), 0);
+  pthread_join(thread, NULL);
+  ck_assert_int_eq(worker_status & DECIMAL_STATUS_OVERFLOW,
+                   DECIMAL_STATUS_OVERFLOW);
+  ck_assert_int_eq(decimal_context_get()->status, 0);
+
+  decimal result;
+  ck_assert_int_eq(div(make_dec_int(1, 0), make_dec_int(0, 0), &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+  ck_assert_int_eq(decimal_context_get()->status, DECIMAL_STATUS_DIV_BY_ZERO);
+  decimal_context_reset();
+  ck_assert_int_eq(decimal_context_get()->status, 0);
+}
+END_TEST
+
+START_TEST(test_compare_mixed_scale_near_overflow) {
+  decimal a = {{0, 0, (int)0xA0000000, 0}};
+  decimal b = {{(int)0xFFFFFFFF, (int)0xFFFFFFFF, (int)0xFFFFFFFF, 0}};
+  set_scale(&b, 1);
+  ck_assert_int_eq(is_greater(a, b), 1);
+  ck_assert_int_eq(is_less(b, a), 1);
+  ck_assert_int_eq(decimal_compare(a, b), 1);
+  ck_assert_int_eq(compare_abs(b, a), -1);
+  set_sign(&a, 1);
+  ck_assert_int_eq(decimal_compare(a, b), -1);
+}
+END_TEST
+
+START_TEST(test_decimal_key_order) {
+  decimal values[6] = {make_dec_int(-15, 1), make_dec_int(0, 0),
+                       make_dec_int(0, 2), make_dec_int(2, 0),
+                       make_dec_int(2000, 3), make_dec_int(3, 0)};
+  set_sign(&values[1], 1);
+  decimal_key keys[6];
+  for (int i = 0; i < 6; i++) decimal_make_key(&values[i], &keys[i]);
+
+  ck_assert_int_eq(decimal_key_compare(&keys[0], &keys[1]), -1);
+  ck_assert_int_eq(decimal_key_compare(&keys[1], &keys[2]), 0);
+  ck_assert_int_eq(decimal_key_compare(&keys[2], &keys[3]), -1);
+  ck_assert_int_eq(decimal_key_compare(&keys[3], &keys[4]), 0);
+  ck_assert_int_eq(decimal_key_compare(&keys[5], &keys[4]), 1);
+}
+END_TEST
+
+START_TEST(test_decimal_compare_mask) {
+  decimal a[8];
+  decimal b[8];
+  for (int i = 0; i < 8; i++) {
+    a[i] = make_dec_int(i * 10, 1);
+    b[i] = make_dec_int(4, 0);
+  }
+  b[7] = make_dec_int(-4, 0);
+
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 8, DECIMAL_CMP_LT), 0x0Fu);
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 8, DECIMAL_CMP_LE), 0x1Fu);
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 8, DECIMAL_CMP_EQ), 0x10u);
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 8, DECIMAL_CMP_GT), 0xE0u);
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 4, DECIMAL_CMP_GE), 0x0u);
+  ck_assert_uint_eq(decimal_compare_mask(a, b, 8, DECIMAL_CMP_NE), 0xEFu);
+
+  // A full block of signs, zeros and high words, mostly at one scale.
+  decimal c[32];
+  decimal d[32];
+  for (int i = 0; i < 32; i++) {
+    c[i] = (decimal)DECIMAL_INIT_WORDS((unsigned)i % 3, 0, (unsigned)i % 2,
+                                       2, i % 4 == 1);
+    d[i] = (decimal)DECIMAL_INIT_WORDS((unsigned)i % 5, 0, (unsigned)i % 3,
+                                       i % 7 == 0 ? 5 : 2, i % 3 == 2);
+  }
+  c[12] = (decimal)DECIMAL_INIT_WORDS(0, 0, 0, 2, 1);
+  d[12] = (decimal)DECIMAL_INIT_WORDS(0, 0, 0, 2, 0);
+  for (int relation = DECIMAL_CMP_LT; relation <= DECIMAL_CMP_NE;
+       relation++) {
+    unsigned int expected = 0u;
+    for (int i = 0; i < 32; i++) {
+      int order = decimal_compare(c[i], d[i]);
+      int hit = relation == DECIMAL_CMP_LT   ? order < 0
+                : relation == DECIMAL_CMP_LE ? order <= 0
+                : relation == DECIMAL_CMP_GT ? order > 0
+                : relation == DECIMAL_CMP_GE ? order >= 0
+                : relation == DECIMAL_CMP_EQ ? order == 0
+                                             : order != 0;
+      expected |= (unsigned int)hit << i;
+    }
+    ck_assert_uint_eq(decimal_compare_mask(c, d, 32, relation), expected);
+  }
+}
+END_TEST
+
+START_TEST(test_div_by_matches_div) {
+  decimal divisor = make_dec_int(-37, 1);
+  decimal values[6];
+  decimal results[6];
+  decimal_divisor prepared;
+  values[0] = make_dec_int(1000, 0);
+  values[1] = make_dec_int(-123456789, 3);
+  values[2] = make_dec_int(37, 1);
+  values[3] = make_dec_int(36, 1);
+  values[4] = make_dec_int(0, 0);
+  values[5] = make_dec_int(2147483647, 0);
+
+  ck_assert_int_eq(decimal_divisor_prepare(divisor, &prepared),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_div_by_array(&prepared, values, results, 6),
+                   ARITHMETIC_OK);
+  for (int i = 0; i < 6; i++) {
+    decimal expected;
+    ck_assert_int_eq(div(values[i], divisor, &expected), ARITHMETIC_OK);
+    ck_assert_int_eq(results[i].bits[0], expected.bits[0]);
+    ck_assert_int_eq(results[i].bits[1], expected.bits[1]);
+    ck_assert_int_eq(results[i].bits[2], expected.bits[2]);
+    ck_assert_int_eq(results[i].bits[3], expected.bits[3]);
+  }
+}
+END_TEST
+
+START_TEST(test_div_by_wide_quotient) {
+  decimal max;
+  decimal result;
+  decimal_divisor prepared;
+  max.bits[0] = -1;
+  max.bits[1] = -1;
+  max.bits[2] = -1;
+  max.bits[3] = 0;
+
+  // 79228162514264337593543950335 / 3 = 26409387504754779197847983445.
+  ck_assert_int_eq(decimal_divisor_prepare(make_dec_int(3, 0), &prepared),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_div_by(&prepared, max, &result), ARITHMETIC_OK);
+  ck_assert_uint_eq((unsigned int)result.bits[0], 0x55555555u);
+  ck_assert_uint_eq((unsigned int)result.bits[1], 0x55555555u);
+  ck_assert_uint_eq((unsigned int)result.bits[2], 0x55555555u);
+
+  ck_assert_int_eq(decimal_divisor_prepare(make_dec_int(1, 1), &prepared),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_div_by(&prepared, max, &result), ARITHMETIC_BIG);
+
+  ck_assert_int_eq(decimal_divisor_prepare(make_dec_int(0, 3), &prepared),
+                   ARITHMETIC_DIV_BY_ZERO);
+  ck_assert_int_eq(decimal_div_by(&prepared, max, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+}
+END_TEST
+
+START_TEST(test_divmod_signs) {
+  decimal quotient;
+  decimal remainder;
+
+  // -7.5 = 2 * -3.2 + -1.1
+  ck_assert_int_eq(decimal_divmod(make_dec_int(-75, 1), make_dec_int(32, 1),
+                                  &quotient, &remainder),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(quotient.bits[0], 2);
+  ck_assert_int_eq(get_sign(&quotient), 1);
+  ck_assert_int_eq(get_scale(&quotient), 0);
+  ck_assert_int_eq(remainder.bits[0], 11);
+  ck_assert_int_eq(get_sign(&remainder), 1);
+  ck_assert_int_eq(get_scale(&remainder), 1);
+
+  ck_assert_int_eq(decimal_divmod(make_dec_int(64, 1), make_dec_int(-32, 1),
+                                  &quotient, &remainder),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(quotient.bits[0], 2);
+  ck_assert_int_eq(get_sign(&quotient), 1);
+  ck_assert_int_eq(remainder.bits[0], 0);
+  ck_assert_int_eq(get_sign(&remainder), 0);
+
+  ck_assert_int_eq(decimal_divmod(make_dec_int(1, 0), make_dec_int(0, 2),
+                                  &quotient, &remainder),
+                   ARITHMETIC_DIV_BY_ZERO);
+}
+END_TEST
+
+START_TEST(test_mod_mixed_scale_large_quotient) {
+  decimal max;
+  decimal quotient;
+  decimal remainder;
+  max.bits[0] = -1;
+  max.bits[1] = -1;
+  max.bits[2] = -1;
+  max.bits[3] = 0;
+
+  // 79228162514264337593543950335 mod 0.011 = 0.003, but the quotient
+  // needs more than 96 bits.
+  ck_assert_int_eq(decimal_mod(max, make_dec_int(11, 3), &remainder),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(remainder.bits[0], 3);
+  ck_assert_int_eq(get_scale(&remainder), 3);
+  ck_assert_int_eq(decimal_divmod(max, make_dec_int(11, 3), &quotient,
+                                  &remainder),
+                   ARITHMETIC_BIG);
+
+  // 1.25 mod 0.5 = 0.25 at the larger scale.
+  ck_assert_int_eq(decimal_mod(make_dec_int(125, 2), make_dec_int(5, 1),
+                               &remainder),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(remainder.bits[0], 25);
+  ck_assert_int_eq(get_scale(&remainder), 2);
+}
+END_TEST
+
+static int has_words(decimal value, unsigned int low, unsigned int mid,
+                     unsigned int high, int scale, int sign) {
+  return (unsigned int)value.bits[0] == low &&
+         (unsigned int)value.bits[1] == mid &&
+         (unsigned int)value.bits[2] == high && get_scale(&value) == scale &&
+         get_sign(&value) == sign;
+}
+
+START_TEST(test_sqrt) {
+  decimal result;
+
+  // sqrt(2) = 1.4142135623730950488016887242
+  ck_assert_int_eq(decimal_sqrt(make_dec_int(2, 0), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0x5B611DCAu, 0x5778CD49u, 0x2DB219B4u, 28, 0), 1);
+
+  ck_assert_int_eq(decimal_sqrt(make_dec_int(225, 2), &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(result, 15u, 0u, 0u, 1, 0), 1);
+
+  ck_assert_int_eq(decimal_sqrt(make_dec_int(-4, 0), &result),
+                   ARITHMETIC_BAD_INPUT);
+}
+END_TEST
+
+START_TEST(test_pow_exp_ln) {
+  decimal result;
+
+  // 1.05^30 = 4.3219423751506620091572881989
+  ck_assert_int_eq(decimal_pow(make_dec_int(105, 2), 30, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0x9E030A45u, 0x3F6CD4C8u, 0x8BA644F8u, 28, 0), 1);
+  ck_assert_int_eq(decimal_pow(make_dec_int(-2, 0), -3, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(result, 125u, 0u, 0u, 3, 1), 1);
+  ck_assert_int_eq(decimal_pow(make_dec_int(10, 0), 29, &result),
+                   ARITHMETIC_BIG);
+  ck_assert_int_eq(decimal_pow(make_dec_int(0, 0), -1, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+
+  // e^-1 = 0.3678794411714423215955237702
+  ck_assert_int_eq(decimal_exp(make_dec_int(-1, 0), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0x8E19DB46u, 0xAA58AC52u, 0x0BE30704u, 28, 0), 1);
+  ck_assert_int_eq(decimal_exp(make_dec_int(67, 0), &result),
+                   ARITHMETIC_BIG);
+  ck_assert_int_eq(decimal_exp(make_dec_int(-70, 0), &result),
+                   ARITHMETIC_SMALL);
+
+  // ln(10) = 2.3025850929940456840179914547
+  ck_assert_int_eq(decimal_ln(make_dec_int(10, 0), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0x9FA69733u, 0x1414B220u, 0x4A668998u, 28, 0), 1);
+  ck_assert_int_eq(decimal_ln(make_dec_int(1, 0), &result), ARITHMETIC_OK);
+  ck_assert_int_eq(is_zero(result), 1);
+  ck_assert_int_eq(decimal_ln(make_dec_int(0, 0), &result),
+                   ARITHMETIC_BAD_INPUT);
+}
+END_TEST
+
+START_TEST(test_compound_factor_and_present_value) {
+  decimal rates[3];
+  decimal amounts[3];
+  decimal results[3];
+  int periods[3] = {10, 10, 0};
+  decimal result;
+
+  // 1.05^10 = 1.62889462677744140625
+  ck_assert_int_eq(decimal_compound_factor(make_dec_int(5, 2), 10, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0xB1304151u, 0xD48B9F47u, 0x00000008u, 20, 0), 1);
+
+  for (int i = 0; i < 3; i++) {
+    rates[i] = make_dec_int(5, 2);
+    amounts[i] = make_dec_int(1000, 0);
+  }
+  // 1000 / 1.05^10 = 613.9132535407593743585468986
+  ck_assert_int_eq(
+      decimal_present_value_array(amounts, rates, periods, results, 3),
+      ARITHMETIC_OK);
+  for (int i = 0; i < 2; i++) {
+    ck_assert_int_eq(
+        has_words(results[i], 0x2291623Au, 0x9A6FC247u, 0x13D62BE1u, 25, 0),
+        1);
+  }
+  ck_assert_int_eq(has_words(results[2], 1000u, 0u, 0u, 0, 0), 1);
+
+  // Far more distinct pairs than the initial table holds, each seen twice.
+  enum { kLoans = 600 };
+  static decimal many_rates[kLoans];
+  static decimal many_results[kLoans];
+  static int many_periods[kLoans];
+  for (int i = 0; i < kLoans; i++) {
+    many_rates[i] = make_dec_int(i % 300 + 1, 4);
+    many_periods[i] = 12 + i % 7;
+  }
+  ck_assert_int_eq(decimal_compound_factor_array(many_rates, many_periods,
+                                                 many_results, kLoans),
+                   ARITHMETIC_OK);
+  for (int i = 0; i < kLoans; i++) {
+    ck_assert_int_eq(
+        decimal_compound_factor(many_rates[i], many_periods[i], &result),
+        ARITHMETIC_OK);
+    ck_assert(is_equal(result, many_results[i]));
+    ck_assert_int_eq(get_scale(&result), get_scale(&many_results[i]));
+  }
+
+  ck_assert_int_eq(decimal_compound_factor(make_dec_int(5, 2), -1, &result),
+                   ARITHMETIC_BAD_INPUT);
+}
+END_TEST
+
+START_TEST(test_annuity_payment_and_schedule) {
+  decimal_amortization_row rows[12];
+  decimal result;
+  decimal repaid;
+  int whole = 0;
+
+  // 100000 at 0.5% per period over 360 periods.
+  ck_assert_int_eq(decimal_annuity_payment(make_dec_int(100000, 0),
+                                           make_dec_int(5, 3), 360, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(
+      has_words(result, 0x783F4C50u, 0x6D5CB8F0u, 0xC1B9A835u, 26, 0), 1);
+
+  ck_assert_int_eq(decimal_annuity_payment(make_dec_int(1200, 0),
+                                           make_dec_int(0, 0), 12, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(result, 100u, 0u, 0u, 0, 0), 1);
+
+  ck_assert_int_eq(decimal_amortization_schedule(make_dec_int(1200, 0),
+                                                 make_dec_int(1, 2), 12, rows),
+                   ARITHMETIC_OK);
+  decimal_zero(&repaid);
+  for (int i = 0; i < 12; i++) {
+    add(repaid, rows[i].principal, &repaid);
+    ck_assert_int_eq(is_less(rows[i].balance, make_dec_int(0, 0)), 0);
+  }
+  ck_assert_int_eq(is_zero(rows[11].balance), 1);
+  round_decimal(repaid, &repaid);
+  from_decimal_to_int(repaid, &whole);
+  ck_assert_int_eq(whole, 1200);
+}
+END_TEST
+
+START_TEST(test_allocate_largest_remainder) {
+  decimal weights[4] = {make_dec_int(1, 0), make_dec_int(1, 0),
+                        make_dec_int(1, 0), make_dec_int(0, 0)};
+  decimal shares[4];
+
+  // 100.00 over three equal weights: the first share takes the extra cent.
+  ck_assert_int_eq(decimal_allocate(make_dec_int(10000, 2), weights, 4, 2,
+                                    shares),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(shares[0], 3334u, 0u, 0u, 2, 0), 1);
+  ck_assert_int_eq(has_words(shares[1], 3333u, 0u, 0u, 2, 0), 1);
+  ck_assert_int_eq(has_words(shares[2], 3333u, 0u, 0u, 2, 0), 1);
+  ck_assert_int_eq(has_words(shares[3], 0u, 0u, 0u, 2, 0), 1);
+
+  // -10 by 0.2 / 0.35 / 0.45: quotas 2, 3.5, 4.5 tie on the remainders.
+  weights[0] = make_dec_int(2, 1);
+  weights[1] = make_dec_int(35, 2);
+  weights[2] = make_dec_int(45, 2);
+  ck_assert_int_eq(decimal_allocate(make_dec_int(-10, 0), weights, 3, 0,
+                                    shares),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(shares[0], 2u, 0u, 0u, 0, 1), 1);
+  ck_assert_int_eq(has_words(shares[1], 4u, 0u, 0u, 0, 1), 1);
+  ck_assert_int_eq(has_words(shares[2], 4u, 0u, 0u, 0, 1), 1);
+
+  // With W above 2^64 the remainders 2^69 and 2^69 + 10 differ only below
+  // their leading 64 bits; the larger one still wins.
+  weights[0] = (decimal)DECIMAL_INIT_WORDS(0u, 0u, 0x10u, 0, 0);
+  weights[1] = (decimal)DECIMAL_INIT_WORDS(5u, 0u, 0x10u, 0, 0);
+  weights[2] = (decimal)DECIMAL_INIT_WORDS(0u, 0u, 0x20u, 0, 0);
+  ck_assert_int_eq(decimal_allocate(make_dec_int(2, 0), weights, 3, 0,
+                                    shares),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(has_words(shares[0], 0u, 0u, 0u, 0, 0), 1);
+  ck_assert_int_eq(has_words(shares[1], 1u, 0u, 0u, 0, 0), 1);
+  ck_assert_int_eq(has_words(shares[2], 1u, 0u, 0u, 0, 0), 1);
+
+  ck_assert_int_eq(decimal_allocate(make_dec_int(1, 3), weights, 3, 2,
+                                    shares),
+                   ARITHMETIC_BAD_INPUT);
+  weights[1] = make_dec_int(-1, 0);
+  ck_assert_int_eq(decimal_allocate(make_dec_int(1, 0), weights, 3, 0,
+                                    shares),
+                   ARITHMETIC_BAD_INPUT);
+  weights[0] = weights[1] = weights[2] = make_dec_int(0, 0);
+  ck_assert_int_eq(decimal_allocate(make_dec_int(1, 0), weights, 3, 0,
+                                    shares),
+                   ARITHMETIC_DIV_BY_ZERO);
+}
+END_TEST
+
+START_TEST(test_from_float_to_decimal_shortest) {
+  float src[8] = {0.1f, 123.456f, -2.5f, 16777216.0f,
+                  3.4e10f, 1e-28f, 0.0f, 1e-29f};
+  decimal dst[8];
+
+  ck_assert_int_eq(from_float_to_decimal_array(src, dst, 8), 1);
+  ck_assert_int_eq(has_words(dst[0], 1u, 0u, 0u, 1, 0), 1);
+  ck_assert_int_eq(has_words(dst[1], 123456u, 0u, 0u, 3, 0), 1);
+  ck_assert_int_eq(has_words(dst[2], 25u, 0u, 0u, 1, 1), 1);
+  ck_assert_int_eq(has_words(dst[3], 16777216u, 0u, 0u, 0, 0), 1);
+  ck_assert_int_eq(has_words(dst[4], 0xEA8ED400u, 7u, 0u, 0, 0), 1);
+  ck_assert_int_eq(has_words(dst[5], 1u, 0u, 0u, 28, 0), 1);
+  ck_assert_int_eq(has_words(dst[6], 0u, 0u, 0u, 0, 0), 1);
+  ck_assert_int_eq(has_words(dst[7], 0u, 0u, 0u, 0, 0), 1);
+
+  ck_assert_int_eq(from_float_to_decimal(1e29f, &dst[0]), 1);
+  ck_assert_int_eq(from_float_to_decimal(NAN, &dst[0]), 1);
+  ck_assert_int_eq(from_float_to_decimal(-INFINITY, &dst[0]), 1);
+  ck_assert_int_eq(from_float_to_decimal(-7.9e28f, &dst[0]), 0);
+  ck_assert_int_eq(get_sign(&dst[0]), 1);
+}
+END_TEST
+
+static const decimal kCent = DECIMAL_INIT(1, 2);
+
+START_TEST(test_decimal_literals) {
+  decimal power = DECIMAL_ONE;
+  decimal result;
+
+  ck_assert_int_eq(has_words(DECIMAL_LIT(12345, 2), 12345u, 0u, 0u, 2, 0),
+                   1);
+  ck_assert_int_eq(has_words(DECIMAL_LIT(-1, 8), 1u, 0u, 0u, 8, 1), 1);
+  ck_assert_int_eq(has_words(DECIMAL_LIT(-9000000000000000000ll, 0),
+                             0xE2840000u, 0x7CE66C50u, 0u, 0, 1),
+                   1);
+  ck_assert_int_eq(has_words(DECIMAL_MIN, ~0u, ~0u, ~0u, 0, 1), 1);
+  ck_assert_int_eq(is_zero(DECIMAL_ZERO), 1);
+  ck_assert_int_eq(is_equal(DECIMAL_MINUS_ONE, make_dec_int(-1, 0)), 1);
+
+  ck_assert_int_eq(mul(kCent, decimal_powers_of_ten[2], &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(is_equal(result, DECIMAL_ONE), 1);
+  for (int k = 0; k <= 28; k++) {
+    ck_assert_int_eq(
+        memcmp(&decimal_powers_of_ten[k], &power, sizeof(power)), 0);
+    ck_assert_int_eq(has_words(decimal_inverse_powers_of_ten[k], 1u, 0u, 0u,
+                               k, 0),
+                     1);
+    mul_by_ten(&power);
+  }
+}
+END_TEST
+
+START_TEST(test_unchecked_matches_checked) {
+  decimal values[6] = {make_dec_int(12345, 2), make_dec_int(-7, 0),
+                       make_dec_int(0, 3),     make_dec_int(999999, 6),
+                       DECIMAL_MAX,            make_dec_int(-1, 28)};
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++) {
+      decimal checked;
+      decimal unchecked;
+      ck_assert_int_eq(add(values[i], values[j], &checked),
+                       add_unchecked(values[i], values[j], &unchecked));
+      ck_assert_int_eq(is_equal(checked, unchecked), 1);
+      ck_assert_int_eq(sub(values[i], values[j], &checked),
+                       sub_unchecked(values[i], values[j], &unchecked));
+      ck_assert_int_eq(is_equal(checked, unchecked), 1);
+      ck_assert_int_eq(mul(values[i], values[j], &checked),
+                       mul_unchecked(values[i], values[j], &unchecked));
+      ck_assert_int_eq(memcmp(&checked, &unchecked, sizeof(checked)), 0);
+      if (!is_zero(values[j])) {
+        ck_assert_int_eq(div(values[i], values[j], &checked),
+                         div_unchecked(values[i], values[j], &unchecked));
+        ck_assert_int_eq(memcmp(&checked, &unchecked, sizeof(checked)), 0);
+      }
+      ck_assert_int_eq(decimal_compare(values[i], values[j]),
+                       decimal_compare_unchecked(values[i], values[j]));
+      ck_assert_int_eq(is_less(values[i], values[j]),
+                       is_less_unchecked(values[i], values[j]));
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_decimal_validation) {
+  decimal value = make_dec_int(-12345, 28);
+  ck_assert_int_eq(decimal_is_valid(value), 1);
+  ck_assert_int_eq(decimal_is_valid(DECIMAL_MIN), 1);
+  value.bits[3] = 29 << 16;
+  ck_assert_int_eq(decimal_is_valid(value), 0);
+  value.bits[3] = 1;
+  ck_assert_int_eq(decimal_is_valid(value), 0);
+  value.bits[3] = 1 << 24;
+  ck_assert_int_eq(decimal_is_valid(value), 0);
+
+  decimal values[40];
+  for (int i = 0; i < 40; i++) values[i] = make_dec_int(i - 20, i % 29);
+  ck_assert_uint_eq(decimal_first_invalid(values, 40), 40);
+  ck_assert_uint_eq(decimal_first_invalid(NULL, 40), 0);
+  int bad[3] = {0, 21, 37};
+  for (int i = 0; i < 3; i++) {
+    decimal saved = values[bad[i]];
+    values[bad[i]].bits[3] |= 0x00008000;
+    ck_assert_uint_eq(decimal_first_invalid(values, 40), (size_t)bad[i]);
+    ck_assert_uint_eq(decimal_first_invalid(values, (size_t)bad[i]),
+                      (size_t)bad[i]);
+    values[bad[i]] = saved;
+  }
+}
+END_TEST
+
+START_TEST(test_expression_eval) {
+  static const char *const names[5] = {"a", "b", "c", "d", "e"};
+  decimal_expression expression;
+  decimal result;
+
+  ck_assert_int_eq(
+      decimal_expression_compile("(a*b - c) / d + e", names, 5, &expression),
+      ARITHMETIC_OK);
+  decimal inputs[5] = {make_dec_int(1250, 2), make_dec_int(4, 0),
+                       make_dec_int(2, 0), make_dec_int(8, 0),
+                       make_dec_int(-1, 1)};
+  ck_assert_int_eq(decimal_expression_eval(&expression, inputs, &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 59, 0, 0, 1, 0));
+
+  // Precedence, unary minus and literals.
+  ck_assert_int_eq(
+      decimal_expression_compile("-(2 - 5) + 3 * 0.25", NULL, 0, &expression),
+      ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_expression_eval(&expression, NULL, &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 375, 0, 0, 2, 0));
+
+  // a / b * b rounds once: 1 rather than 0.9999999999999999999999999999.
+  ck_assert_int_eq(decimal_expression_compile("a / b * b", names, 2,
+                                              &expression),
+                   ARITHMETIC_OK);
+  inputs[0] = make_dec_int(1, 0);
+  inputs[1] = make_dec_int(3, 0);
+  ck_assert_int_eq(decimal_expression_eval(&expression, inputs, &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 1, 0, 0, 0, 0));
+
+  // An intermediate above 2^96 is fine when the result fits.
+  inputs[0] = DECIMAL_MAX;
+  inputs[1] = make_dec_int(2, 0);
+  ck_assert_int_eq(decimal_expression_compile("a * b / b", names, 2,
+                                              &expression),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_expression_eval(&expression, inputs, &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, ~0u, ~0u, ~0u, 0, 0));
+
+  inputs[1] = make_dec_int(0, 3);
+  ck_assert_int_eq(decimal_expression_compile("a / b", names, 2,
+                                              &expression),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_expression_eval(&expression, inputs, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+
+  ck_assert_int_eq(decimal_expression_compile("a + f", names, 5,
+                                              &expression),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_expression_compile("a + (b", names, 5,
+                                              &expression),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_expression_compile("a b", names, 5, &expression),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_expression_eval(&expression, inputs, &result),
+                   ARITHMETIC_BAD_INPUT);
+}
+END_TEST
+
+START_TEST(test_expression_eval_columns) {
+  static const char *const names[2] = {"price", "qty"};
+  decimal_expression expression;
+  decimal prices[3] = {make_dec_int(1999, 2), make_dec_int(5, 1),
+                       make_dec_int(-300, 2)};
+  decimal quantities[3] = {make_dec_int(3, 0), make_dec_int(0, 0),
+                           make_dec_int(7, 0)};
+  const decimal *columns[2] = {prices, quantities};
+  decimal results[3];
+
+  ck_assert_int_eq(decimal_expression_compile("price * qty - 1", names, 2,
+                                              &expression),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(
+      decimal_expression_eval_columns(&expression, columns, results, 3),
+      ARITHMETIC_OK);
+  ck_assert(has_words(results[0], 5897, 0, 0, 2, 0));
+  ck_assert(has_words(results[1], 1, 0, 0, 0, 1));
+  ck_assert(has_words(results[2], 22, 0, 0, 0, 1));
+
+  // The failing row is reported; the others are still evaluated.
+  ck_assert_int_eq(decimal_expression_compile("qty / price", names, 2,
+                                              &expression),
+                   ARITHMETIC_OK);
+  prices[0] = make_dec_int(0, 0);
+  ck_assert_int_eq(
+      decimal_expression_eval_columns(&expression, columns, results, 3),
+      ARITHMETIC_DIV_BY_ZERO);
+  ck_assert(has_words(results[2], 0x25555555, 0x9101058D, 0x4B64E186, 28, 1));
+}
+END_TEST
+
+START_TEST(test_instrument_counters) {
+  decimal_instrument_stats stats;
+  decimal_instrument_stats total;
+  decimal result;
+
+  decimal_instrument_reset();
+  add(make_dec_int(1, 2), make_dec_int(1, 3), &result);
+  add(make_dec_int(1, 2), make_dec_int(1, 2), &result);
+  mul(make_dec_int(1, 20), make_dec_int(1, 20), &result);
+  div(make_dec_int(7, 0), make_dec_int(2, 1), &result);
+  decimal_mod(make_dec_int(7, 0), make_dec_int(2, 0), &result);
+  decimal_instrument_snapshot(&stats);
+  memset(&total, 0, sizeof(total));
+  decimal_instrument_merge(&total, &stats);
+  decimal_instrument_merge(&total, &stats);
+#ifdef DECIMAL_INSTRUMENT
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_ADD], 2);
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_MUL], 1);
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_DIV], 1);
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_MOD], 1);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_ADD_RESCALE], 1);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_MUL_GENERAL], 1);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_MUL_OVERFLOW], 0);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_NORMALIZE], 1);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_NORMALIZE_STEP], 1);
+  ck_assert(stats.events[DECIMAL_EVENT_DIV_STEP] > 0);
+  ck_assert_uint_eq(stats.scales[2], 3);
+  ck_assert_uint_eq(stats.scales[20], 2);
+  ck_assert_uint_eq(total.calls[DECIMAL_OP_ADD], 4);
+  unsigned long long timed = 0;
+  for (int b = 0; b < DECIMAL_INSTRUMENT_BUCKETS; b++)
+    timed += stats.cycles[DECIMAL_OP_ADD][b];
+  ck_assert_uint_eq(timed, 2);
+#else
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_ADD], 0);
+  ck_assert_uint_eq(stats.events[DECIMAL_EVENT_BANK_ROUND], 0);
+  ck_assert_uint_eq(total.calls[DECIMAL_OP_ADD], 0);
+#endif
+  decimal_instrument_reset();
+  decimal_instrument_snapshot(&stats);
+  ck_assert_uint_eq(stats.calls[DECIMAL_OP_ADD], 0);
+}
+END_TEST
+
+// Products beyond 96 bits or scale 28 are rounded half-even, not
+// rejected or rounded to an integer.
+START_TEST(test_mul_rounds_wide_product) {
+  decimal third =
+      DECIMAL_INIT_WORDS(0x05555555, 0x14B700CB, 0x0AC544CA, 28, 0);
+  decimal result;
+
+  // 0.3333333333333333333333333333^2 = 0.1111111111111111111111111111
+  ck_assert_int_eq(mul(third, third, &result), ARITHMETIC_OK);
+  ck_assert(has_words(result, 0x571C71C7, 0x06E7AAEE, 0x039716EE, 28, 0));
+
+  // 10^-20 * -10^-20 underflows to a plain zero.
+  ck_assert_int_eq(mul(make_dec_int(1, 20), make_dec_int(-1, 20), &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 0, 0, 0, 0, 0));
+
+  // MAX * 0.5 needs 97 bits before the scale is dropped.
+  ck_assert_int_eq(mul(DECIMAL_MAX, make_dec_int(5, 1), &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 0x00000000, 0x00000000, 0x80000000, 0, 0));
+}
+END_TEST
+
+// The dividend cannot be raised to the divisor's scale in 96 bits.
+START_TEST(test_div_unaligned_scales) {
+  decimal result;
+  decimal big = DECIMAL_INIT_WORDS(0xFFFFFFFF, 0xFFFFFFFF, 0x0FFFFFFF, 0, 0);
+
+  ck_assert_int_eq(div(big, make_dec_int(25, 1), &result), ARITHMETIC_OK);
+  ck_assert(has_words(result, 0x66666666, 0x66666666, 0x06666666, 0, 0));
+  ck_assert_int_eq(div(big, make_dec_int(1, 5), &result), ARITHMETIC_BIG);
+}
+END_TEST
+
+// Overflowing results continue exactly as bigdecimals and come back to
+// the fixed-size type when they fit again.
+START_TEST(test_decimal_number_escalation) {
+  decimal_arena arena;
+  decimal_number max;
+  decimal_number one;
+  decimal_number half;
+  decimal_number tenth;
+  decimal_number twice;
+  decimal_number result;
+  decimal value;
+
+  decimal_arena_init(&arena, 0);
+  decimal_context_reset();
+  decimal_number_from_decimal(DECIMAL_MAX, &max);
+  decimal_number_from_decimal(make_dec_int(1, 0), &one);
+  decimal_number_from_decimal(make_dec_int(5, 1), &half);
+  decimal_number_from_decimal(make_dec_int(1, 1), &tenth);
+
+  // Results that fit never touch the arena.
+  ck_assert_int_eq(decimal_number_add(&one, &one, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert(!result.is_big);
+  ck_assert(has_words(result.value, 2, 0, 0, 0, 0));
+  ck_assert_uint_eq(arena.capacity, 0);
+
+  ck_assert_int_eq(decimal_number_add(&max, &max, &arena, &twice),
+                   ARITHMETIC_OK);
+  ck_assert(twice.is_big);
+  ck_assert_uint_eq(decimal_context_get()->status, 0u);
+  ck_assert_int_eq(decimal_number_to_decimal(&twice, &arena, &value),
+                   ARITHMETIC_BIG);
+  ck_assert_uint_eq(decimal_context_get()->status, DECIMAL_STATUS_OVERFLOW);
+  ck_assert_int_eq(decimal_number_sub(&twice, &max, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert(!result.is_big);
+  ck_assert(has_words(result.value, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0,
+                      0));
+  // (MAX + MAX) * 0.1 narrows once its trailing zero is dropped.
+  ck_assert_int_eq(decimal_number_mul(&twice, &tenth, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert(!result.is_big);
+  ck_assert(has_words(result.value, 0x33333333, 0x33333333, 0x33333333, 0,
+                      0));
+
+  // MAX + 0.5 only fits after rounding, which overflows; MAX - 0.5 rounds
+  // half-even to MAX - 1.
+  ck_assert_int_eq(decimal_number_add(&twice, &half, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_number_sub(&result, &max, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert(result.is_big);
+  ck_assert_int_eq(decimal_number_to_decimal(&result, &arena, &value),
+                   ARITHMETIC_BIG);
+  ck_assert_int_eq(decimal_number_sub(&result, &one, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_number_to_decimal(&result, &arena, &value),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(value, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0, 0));
+
+  ck_assert_int_eq(decimal_number_mul(&max, &max, &arena, &result),
+                   ARITHMETIC_OK);
+  ck_assert(result.is_big);
+  ck_assert_int_eq(result.big.length, 6);
+  ck_assert_int_eq(decimal_number_to_decimal(&result, &arena, &value),
+                   ARITHMETIC_BIG);
+
+  // A long chain of products stays big, but narrows by rounding however
+  // many limbs and digits of scale it has gathered.
+  decimal_number third;
+  decimal_number_from_decimal(
+      (decimal)DECIMAL_INIT_WORDS(0x05555555, 0x14B700CB, 0x0AC544CA, 28, 0),
+      &third);
+  result = twice;
+  for (int i = 0; i < 11; i++)
+    decimal_number_mul(&result, &third, &arena, &result);
+  ck_assert(result.is_big);
+  ck_assert(result.big.length > 32);
+  ck_assert_int_eq(decimal_number_to_decimal(&result, &arena, &value),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(value, 0xF27B17C9, 0xF282DCB0, 0x1CE70D81, 4, 0));
+  // The scratch copy goes back to the arena, so narrowing again reuses it.
+  size_t capacity = arena.capacity;
+  ck_assert_int_eq(decimal_number_to_decimal(&result, &arena, &value),
+                   ARITHMETIC_OK);
+  ck_assert_uint_eq(arena.capacity, capacity);
+  decimal_arena_release(&arena);
+  decimal_context_reset();
+}
+END_TEST
+
+// After a reset the same workload runs in the blocks already allocated.
+START_TEST(test_arena_reset_reuses_blocks) {
+  decimal_arena arena;
+  decimal_number max;
+  decimal_number result;
+  size_t capacity = 0;
+
+  decimal_arena_init(&arena, 256);
+  decimal_number_from_decimal(DECIMAL_MAX, &max);
+  for (int pass = 0; pass < 3; pass++) {
+    decimal_arena_reset(&arena);
+    decimal_number_from_decimal(DECIMAL_MAX, &result);
+    for (int i = 0; i < 50; i++)
+      decimal_number_mul(&result, &max, &arena, &result);
+    ck_assert(result.is_big);
+    if (pass == 0) capacity = arena.capacity;
+    ck_assert_uint_eq(arena.capacity, capacity);
+  }
+  ck_assert(capacity > 256);
+  ck_assert(decimal_arena_alloc(&arena, 1 << 20) != NULL);
+  decimal_arena_release(&arena);
+  ck_assert_uint_eq(arena.capacity, 0);
+}
+END_TEST
+
+// Scratch taken from a caller's arena is given back, so a batch loop
+// settles into the blocks it already has.
+START_TEST(test_arena_mark_rewind) {
+  decimal_arena arena;
+  decimal weights[600];
+  decimal shares[600];
+  decimal expected[600];
+
+  decimal_arena_init(&arena, 1024);
+  unsigned char *kept = decimal_arena_alloc(&arena, 100);
+  decimal_arena_mark mark = decimal_arena_get_mark(&arena);
+  void *scratch = decimal_arena_alloc(&arena, 5000);
+  ck_assert(kept != NULL && scratch != NULL);
+  decimal_arena_rewind(&arena, mark);
+  ck_assert(decimal_arena_alloc(&arena, 16) == kept + 112);
+  decimal_arena_rewind(&arena, mark);
+
+  for (int i = 0; i < 600; i++) weights[i] = make_dec_int(1 + i % 7, 1);
+  ck_assert_int_eq(decimal_allocate(make_dec_int(1000001, 2), weights, 600,
+                                    2, expected),
+                   ARITHMETIC_OK);
+  size_t capacity = 0;
+  for (int pass = 0; pass < 3; pass++) {
+    ck_assert_int_eq(decimal_allocate_arena(make_dec_int(1000001, 2),
+                                            weights, 600, 2, &arena, shares),
+                     ARITHMETIC_OK);
+    for (int i = 0; i < 600; i++) ck_assert(is_equal(shares[i], expected[i]));
+    if (pass == 0) capacity = arena.capacity;
+    ck_assert_uint_eq(arena.capacity, capacity);
+    ck_assert(decimal_arena_get_mark(&arena).block == mark.block);
+    ck_assert_uint_eq(decimal_arena_get_mark(&arena).used, mark.used);
+  }
+  ck_assert_int_eq(decimal_allocate_arena(make_dec_int(1, 0), weights, 600,
+                                          0, NULL, shares),
+                   ARITHMETIC_BAD_INPUT);
+  decimal_arena_release(&arena);
+}
+END_TEST
+
+START_TEST(test_group_by) {
+  decimal_arena arena;
+  decimal_groups groups;
+  long long keys[6] = {7, 3, 7, 9, 3, 7};
+  decimal amounts[6] = {make_dec_int(150, 2), make_dec_int(-2, 0),
+                        make_dec_int(325, 2), make_dec_int(10, 0),
+                        make_dec_int(5, 1),   make_dec_int(-75, 2)};
+  decimal quantities[6] = {make_dec_int(1, 0), make_dec_int(2, 0),
+                           make_dec_int(3, 0), make_dec_int(4, 0),
+                           make_dec_int(5, 0), make_dec_int(6, 0)};
+  const decimal *columns[2] = {amounts, quantities};
+
+  decimal_arena_init(&arena, 0);
+  for (int threads = 1; threads <= 4; threads += 3) {
+    ck_assert_int_eq(decimal_group_by_int(keys, columns, 2, 6, threads,
+                                          &arena, &groups),
+                     ARITHMETIC_OK);
+    ck_assert_uint_eq(groups.group_count, 3);
+    ck_assert_uint_eq(groups.first_rows[0], 0);
+    ck_assert_uint_eq(groups.first_rows[1], 1);
+    ck_assert_uint_eq(groups.first_rows[2], 3);
+    ck_assert_uint_eq(groups.counts[0], 3);
+    ck_assert_uint_eq(groups.counts[1], 2);
+    ck_assert_uint_eq(groups.counts[2], 1);
+    decimal_aggregate *seven = &groups.aggregates[0];
+    ck_assert(has_words(seven[0].sum, 400, 0, 0, 2, 0));
+    ck_assert(has_words(seven[0].min, 75, 0, 0, 2, 1));
+    ck_assert(has_words(seven[0].max, 325, 0, 0, 2, 0));
+    ck_assert(has_words(seven[1].sum, 10, 0, 0, 0, 0));
+    decimal_aggregate *three = &groups.aggregates[2];
+    ck_assert(has_words(three[0].sum, 150, 0, 0, 2, 1));
+    ck_assert(has_words(three[0].min, 2, 0, 0, 0, 1));
+    ck_assert(has_words(three[0].max, 5, 0, 0, 1, 0));
+    ck_assert(has_words(groups.aggregates[4].sum, 1000, 0, 0, 2, 0));
+    decimal_arena_reset(&arena);
+  }
+
+  // Decimal keys group by value.
+  decimal prices[3] = {make_dec_int(15, 1), make_dec_int(2, 0),
+                       make_dec_int(150, 2)};
+  ck_assert_int_eq(decimal_group_by_decimal(prices, columns, 1, 3, 2,
+                                            &arena, &groups),
+                   ARITHMETIC_OK);
+  ck_assert_uint_eq(groups.group_count, 2);
+  ck_assert_uint_eq(groups.counts[0], 2);
+  ck_assert(has_words(groups.aggregates[0].sum, 475, 0, 0, 2, 0));
+
+  // An overflowing sum is reported; the other groups are still complete.
+  amounts[0] = amounts[2] = DECIMAL_MAX;
+  ck_assert_int_eq(decimal_group_by_int(keys, columns, 1, 4, 1, &arena,
+                                        &groups),
+                   ARITHMETIC_BIG);
+  ck_assert(has_words(groups.aggregates[0].sum, 0, 0, 0, 0, 0));
+  ck_assert(has_words(groups.aggregates[1].sum, 2, 0, 0, 0, 1));
+  amounts[1].bits[3] = 29 << 16;
+  ck_assert_int_eq(decimal_group_by_int(keys, columns, 1, 6, 1, &arena,
+                                        &groups),
+                   ARITHMETIC_BAD_INPUT);
+  decimal_arena_release(&arena);
+}
+END_TEST
+
+// Partitions only decide which thread owns a group, never the result.
+START_TEST(test_group_by_threads_match) {
+  enum { kRows = 20000 };
+  static long long keys[kRows];
+  static decimal values[kRows];
+  const decimal *columns[1] = {values};
+  decimal_arena arena;
+  decimal_groups single;
+  decimal_groups parallel;
+
+  for (int i = 0; i < kRows; i++) {
+    keys[i] = (long long)(i * 7919 % 1009) - 500;
+    values[i] = make_dec_int(i * 37 % 20011 - 10000, i % 5);
+  }
+  decimal_arena_init(&arena, 0);
+  ck_assert_int_eq(decimal_group_by_int(keys, columns, 1, kRows, 1, &arena,
+                                        &single),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_group_by_int(keys, columns, 1, kRows, 5, &arena,
+                                        &parallel),
+                   ARITHMETIC_OK);
+  ck_assert_uint_eq(single.group_count, 1009);
+  ck_assert_uint_eq(parallel.group_count, single.group_count);
+  ck_assert(memcmp(single.first_rows, parallel.first_rows,
+                   single.group_count * sizeof(size_t)) == 0);
+  ck_assert(memcmp(single.counts, parallel.counts,
+                   single.group_count * sizeof(size_t)) == 0);
+  ck_assert(memcmp(single.aggregates, parallel.aggregates,
+                   single.group_count * sizeof(decimal_aggregate)) == 0);
+  decimal expected = make_dec_int(0, 0);
+  for (int i = 0; i < kRows; i++) {
+    if (keys[i] == keys[0]) add(expected, values[i], &expected);
+  }
+  ck_assert(is_equal(single.aggregates[0].sum, expected));
+  // More threads than rows.
+  ck_assert_int_eq(decimal_group_by_int(keys, columns, 1, 3, 8, &arena,
+                                        &parallel),
+                   ARITHMETIC_OK);
+  ck_assert_uint_eq(parallel.group_count, 3);
+  ck_assert_uint_eq(parallel.first_rows[2], 2);
+  decimal_arena_release(&arena);
+}
+END_TEST
+
+// The parallel scan must reproduce the add loop bit for bit, including
+// its rounding and overflow once the totals no longer fit.
+START_TEST(test_scan_matches_add_loop) {
+  enum { kValues = 40000 };
+  static decimal values[kValues];
+  static decimal expected[kValues];
+  static decimal results[kValues];
+  static int expected_flags[kValues];
+  static int flags[kValues];
+
+  for (int exclusive = 0; exclusive < 2; exclusive++) {
+    int (*scan)(const decimal *, decimal *, int *, size_t, int) =
+        exclusive ? decimal_scan_exclusive : decimal_scan_inclusive;
+    unsigned int state = 12345u;
+    for (int i = 0; i < kValues; i++) {
+      state = state * 1103515245u + 12345u;
+      values[i] = make_dec_int((int)(state >> 8) - (1 << 23), (int)(i % 7));
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      if (pass == 1) {
+        // Totals outgrow 96 bits two thirds of the way in: first they
+        // round, then the add overflows and is skipped.
+        for (int i = 26000; i < kValues; i++) {
+          values[i] = (decimal)DECIMAL_INIT_WORDS(
+              0xFFFFFFFF, 0xFFFFFFFF, 0x3FFFFFFF, i % 3 == 0 ? 6 : 0, 0);
+        }
+      }
+      int want = scan(values, expected, expected_flags, kValues, 1);
+      int got = scan(values, results, flags, kValues, 4);
+      ck_assert_int_eq(got, want);
+      ck_assert_int_eq(want, pass == 0 ? ARITHMETIC_OK : ARITHMETIC_BIG);
+      ck_assert(memcmp(results, expected, sizeof(results)) == 0);
+      ck_assert(memcmp(flags, expected_flags, sizeof(flags)) == 0);
+    }
+  }
+  // In place, as an inclusive running balance.
+  decimal_scan_inclusive(values, expected, NULL, kValues, 1);
+  decimal_scan_inclusive(values, values, NULL, kValues, 3);
+  ck_assert(memcmp(values, expected, sizeof(values)) == 0);
+  // In place with an early rounding add: 2^95 + 0.5 rounds in the first
+  // chunk, after the second chunk's start total already fits.
+  for (int i = 0; i < 16384; i++) values[i] = make_dec_int(1, 0);
+  values[0] = (decimal)DECIMAL_INIT_WORDS(0, 0, 0x80000000, 0, 0);
+  values[1] = make_dec_int(5, 1);
+  values[2] = (decimal)DECIMAL_INIT_WORDS(0, 0, 0x80000000, 0, 1);
+  decimal_scan_inclusive(values, expected, NULL, 16384, 1);
+  decimal_scan_inclusive(values, values, NULL, 16384, 2);
+  ck_assert(memcmp(values, expected, 16384 * sizeof(decimal)) == 0);
+  decimal_context_reset();
+}
+END_TEST
+
+START_TEST(test_csv_parse) {
+  decimal value;
+  decimal expected = DECIMAL_INIT(1234, 2);
+  ck_assert_int_eq(decimal_csv_parse("12.34", 5, &value), ARITHMETIC_OK);
+  ck_assert(memcmp(&value, &expected, sizeof(value)) == 0);
+  expected = DECIMAL_LIT(-50, 2);
+  ck_assert_int_eq(decimal_csv_parse(" \"-0.50\" ", 9, &value),
+                   ARITHMETIC_OK);
+  ck_assert(memcmp(&value, &expected, sizeof(value)) == 0);
+  expected = DECIMAL_LIT(5, 1);
+  ck_assert_int_eq(decimal_csv_parse("+.5", 3, &value), ARITHMETIC_OK);
+  ck_assert(memcmp(&value, &expected, sizeof(value)) == 0);
+  // Past 19 digits the mantissa widens.
+  const char *wide = "1234567890123456789012.5";
+  ck_assert_int_eq(decimal_csv_parse(wide, strlen(wide), &value),
+                   ARITHMETIC_OK);
+  expected = (decimal)DECIMAL_INIT_WORDS(0x714244CD, 0x42B64E76, 0x29D, 1, 0);
+  ck_assert(memcmp(&value, &expected, sizeof(value)) == 0);
+  // More than 28 places round half to even.
+  const char *places = "0.12345678901234567890123456785";
+  ck_assert_int_eq(decimal_csv_parse(places, strlen(places), &value),
+                   ARITHMETIC_OK);
+  decimal rounded;
+  decimal_csv_parse("0.1234567890123456789012345678", 30, &rounded);
+  ck_assert(memcmp(&value, &rounded, sizeof(value)) == 0);
+  const char *huge = "79228162514264337593543950336";
+  ck_assert_int_eq(decimal_csv_parse(huge, strlen(huge), &value),
+                   ARITHMETIC_BIG);
+  ck_assert_int_eq(decimal_csv_parse("1e5", 3, &value), ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_csv_parse("1.2.3", 5, &value),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_csv_parse(" ", 1, &value), ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_csv_parse("-", 1, &value), ARITHMETIC_BAD_INPUT);
+  ck_assert(is_zero(value));
+  decimal_context_reset();
+}
+END_TEST
+
+START_TEST(test_csv_read_buffer) {
+  const char *text =
+      "id,name,price,qty\r\n"
+      "1,\"Smith, J\",10.50,3\r\n"
+      "2,plain,x,4\n"
+      "3,short\n"
+      "4,last,-0.25,\"7\"";
+  const int fields[] = {3, 2};
+  decimal qty[2], price[2];
+  decimal *columns[] = {qty, price};
+  int flags[2];
+  size_t rows = 0;
+  decimal_csv_reader reader;
+  ck_assert_int_eq(decimal_csv_open_buffer(&reader, text, strlen(text), ',',
+                                           fields, 2),
+                   ARITHMETIC_OK);
+  ck_assert_int_eq(decimal_csv_skip_rows(&reader, 1), ARITHMETIC_OK);
+
+  ck_assert_int_eq(decimal_csv_read(&reader, columns, flags, 2, 1, &rows),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_uint_eq(rows, 2);
+  ck_assert_int_eq(flags[0], ARITHMETIC_OK);
+  ck_assert_int_eq(flags[1], ARITHMETIC_BAD_INPUT);
+  ck_assert(is_equal(qty[0], (decimal)DECIMAL_LIT(3, 0)));
+  ck_assert(is_equal(price[0], (decimal)DECIMAL_LIT(1050, 2)));
+  ck_assert(is_equal(qty[1], (decimal)DECIMAL_LIT(4, 0)));
+  ck_assert(is_zero(price[1]));
+
+  ck_assert_int_eq(decimal_csv_read(&reader, columns, flags, 2, 1, &rows),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_uint_eq(rows, 2);
+  ck_assert_int_eq(flags[0], ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(flags[1], ARITHMETIC_OK);
+  ck_assert(is_zero(qty[0]) && is_zero(price[0]));
+  ck_assert(is_equal(qty[1], (decimal)DECIMAL_LIT(7, 0)));
+  ck_assert(is_equal(price[1], (decimal)DECIMAL_LIT(-25, 2)));
+  ck_assert_uint_eq(reader.row, 5);
+
+  ck_assert_int_eq(decimal_csv_read(&reader, columns, flags, 2, 1, &rows),
+                   ARITHMETIC_OK);
+  ck_assert_uint_eq(rows, 0);
+  decimal_csv_close(&reader);
+
+  const int twice[] = {1, 1};
+  ck_assert_int_eq(decimal_csv_open_buffer(&reader, text, strlen(text), ',',
+                                           twice, 2),
+                   ARITHMETIC_BAD_INPUT);
+  decimal_context_reset();
+}
+END_TEST
+
+typedef struct {
+  int fd;
+  const char *text;
+  size_t length;
+} csv_writer;
+
+static void *write_csv(void *argument) {
+  csv_writer *writer = argument;
+  size_t written = 0;
+  while (written < writer->length) {
+    ssize_t count = write(writer->fd, writer->text + written,
+                          writer->length - written);
+    written += count > 0 ? (size_t)count : writer->length;
+  }
+  close(writer->fd);
+  return NULL;
+}
+
+// Reads `text` through a pipe, in batches of `batch` rows, with the given
+// block size; -1 if the pipe cannot be set up.
+static int read_csv_pipe(const char *text, size_t block_size,
+                         const int *fields, decimal *const *columns,
+                         int *flags, size_t capacity, size_t batch,
+                         size_t *rows, int *error) {
+  int pipe_fds[2];
+  if (pipe(pipe_fds) != 0) return -1;
+  csv_writer writer = {pipe_fds[1], text, strlen(text)};
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, write_csv, &writer) != 0) {
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return -1;
+  }
+
+  decimal_arena arena;
+  decimal_arena_init(&arena, 0);
+  decimal_csv_reader reader;
+  int flag = decimal_csv_open_fd(&reader, pipe_fds[0], block_size, ',',
+                                 fields, 2, &arena);
+  size_t got = 1;
+  *rows = 0;
+  while (got > 0 && *rows < capacity) {
+    decimal *offsets[2] = {columns[0] + *rows, columns[1] + *rows};
+    size_t room = capacity - *rows < batch ? capacity - *rows : batch;
+    int status = decimal_csv_read(&reader, offsets, flags + *rows, room, 1,
+                                  &got);
+    if (flag == ARITHMETIC_OK) flag = status;
+    *rows += got;
+  }
+  *error = reader.error;
+  decimal_csv_close(&reader);
+  // Drain what a stopped reader left, so the writer never sees SIGPIPE.
+  char rest[4096];
+  while (read(pipe_fds[0], rest, sizeof(rest)) > 0) continue;
+  close(pipe_fds[0]);
+  pthread_join(thread, NULL);
+  decimal_arena_release(&arena);
+  return flag;
+}
+
+START_TEST(test_csv_threads_and_fd_match) {
+  enum { kRows = 20000, kLine = 48 };
+  static char text[kRows * kLine];
+  static decimal expected[2][kRows + 1];
+  static decimal got[2][kRows + 1];
+  static int expected_flags[kRows + 1];
+  static int flags[kRows + 1];
+  decimal *expected_columns[] = {expected[0], expected[1]};
+  decimal *columns[] = {got[0], got[1]};
+  const int fields[] = {1, 3};
+  unsigned int state = 777u;
+  size_t length = 0;
+  for (int i = 0; i < kRows; i++) {
+    state = state * 1103515245u + 12345u;
+    unsigned int cents = state >> 9;
+    // Every 1000th row has a bad amount.
+    length += (size_t)snprintf(text + length, kLine, "%d,%s%u.%02u,x,%s%u\n",
+                               i, (state & 1u) ? "-" : "", cents / 100u,
+                               cents % 100u, i % 1000 == 999 ? "?" : "",
+                               state % 1000u);
+  }
+
+  decimal_csv_reader reader;
+  size_t rows = 0;
+  ck_assert_int_eq(decimal_csv_open_buffer(&reader, text, length, ',',
+                                           fields, 2),
+                   ARITHMETIC_OK);
+  int want = decimal_csv_read(&reader, expected_columns, expected_flags,
+                              kRows + 1, 1, &rows);
+  ck_assert_int_eq(want, ARITHMETIC_BAD_INPUT);
+  ck_assert_uint_eq(rows, kRows);
+  ck_assert_int_eq(expected_flags[999], ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(expected_flags[1000], ARITHMETIC_OK);
+
+  decimal_csv_open_buffer(&reader, text, length, ',', fields, 2);
+  ck_assert_int_eq(decimal_csv_read(&reader, columns, flags, kRows + 1, 4,
+                                    &rows),
+                   want);
+  ck_assert_uint_eq(rows, kRows);
+  ck_assert(memcmp(got, expected, sizeof(got)) == 0);
+  ck_assert(memcmp(flags, expected_flags, sizeof(flags)) == 0);
+
+  // Small blocks put rows across block boundaries.
+  int error = 0;
+  memset(got, 0, sizeof(got));
+  memset(flags, 0, sizeof(flags));
+  ck_assert_int_eq(read_csv_pipe(text, 256, fields, columns, flags, kRows + 1,
+                                 777, &rows, &error),
+                   want);
+  ck_assert_int_eq(error, 0);
+  ck_assert_uint_eq(rows, kRows);
+  ck_assert(memcmp(got, expected, sizeof(got)) == 0);
+  ck_assert(memcmp(flags, expected_flags, sizeof(flags)) == 0);
+
+  // A row longer than a block stops the reader.
+  ck_assert_int_eq(read_csv_pipe(text, 16, fields, columns, flags, kRows + 1,
+                                 kRows, &rows, &error),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(error, ERANGE);
+  decimal_context_reset();
+}
+END_TEST
+
+static decimal parse_text(const char *text) {
+  decimal value;
+  decimal_csv_parse(text, strlen(text), &value);
+  return value;
+}
+
+START_TEST(test_statistics) {
+  decimal values[8];
+  decimal result;
+  const int small[] = {2, 4, 4, 4, 5, 5, 7, 9};
+  for (int i = 0; i < 8; i++) values[i] = make_dec_int(small[i], 0);
+  ck_assert_int_eq(decimal_mean(values, 8, 1, &result), ARITHMETIC_OK);
+  ck_assert(is_equal(result, make_dec_int(5, 0)));
+  ck_assert_int_eq(decimal_variance(values, 8, 0, 1, &result), ARITHMETIC_OK);
+  ck_assert(is_equal(result, make_dec_int(4, 0)));
+  ck_assert_int_eq(decimal_stddev(values, 8, 0, 1, &result), ARITHMETIC_OK);
+  ck_assert(is_equal(result, make_dec_int(2, 0)));
+  decimal_variance(values, 8, 1, 1, &result);
+  ck_assert(is_equal(result, parse_text("4.5714285714285714285714285714")));
+  decimal_stddev(values, 8, 1, 1, &result);
+  ck_assert(is_equal(result, parse_text("2.1380899352993950774764278470")));
+
+  // Mixed scales and signs.
+  values[0] = parse_text("1.5");
+  values[1] = parse_text("2.25");
+  values[2] = parse_text("-3");
+  values[3] = parse_text("0.125");
+  decimal_mean(values, 4, 1, &result);
+  ck_assert(is_equal(result, parse_text("0.21875")));
+  decimal_variance(values, 4, 1, 1, &result);
+  ck_assert(is_equal(result, parse_text("5.37890625")));
+  decimal_stddev(values, 4, 1, 1, &result);
+  ck_assert(is_equal(result, parse_text("2.3192469144099340592745430440")));
+
+  // Sum-of-squares cancellation that a rounded chain cannot survive.
+  values[0] = parse_text("100000000000000000001");
+  values[1] = parse_text("100000000000000000002");
+  values[2] = parse_text("100000000000000000003");
+  decimal_variance(values, 3, 0, 1, &result);
+  ck_assert(is_equal(result, parse_text("0.6666666666666666666666666667")));
+
+  // A volume-weighted average price.
+  decimal weights[3];
+  values[0] = parse_text("10.10");
+  values[1] = parse_text("10.20");
+  values[2] = parse_text("10.00");
+  weights[0] = make_dec_int(100, 0);
+  weights[1] = make_dec_int(300, 0);
+  weights[2] = make_dec_int(50, 0);
+  ck_assert_int_eq(decimal_weighted_mean(values, weights, 3, 1, &result),
+                   ARITHMETIC_OK);
+  ck_assert(is_equal(result, parse_text("10.155555555555555555555555556")));
+
+  ck_assert_int_eq(decimal_mean(values, 0, 1, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+  ck_assert_int_eq(decimal_variance(values, 1, 1, 1, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+  weights[2] = make_dec_int(-400, 0);
+  ck_assert_int_eq(decimal_weighted_mean(values, weights, 3, 1, &result),
+                   ARITHMETIC_DIV_BY_ZERO);
+  decimal_context_reset();
+}
+END_TEST
+
+START_TEST(test_statistics_threads_match) {
+  enum { kValues = 50000 };
+  static decimal values[kValues];
+  static decimal weights[kValues];
+  unsigned int state = 4242u;
+  for (int i = 0; i < kValues; i++) {
+    state = state * 1103515245u + 12345u;
+    values[i] = make_dec_int((int)(state >> 4) - (1 << 27), (int)(i % 5));
+    weights[i] = make_dec_int((int)(state >> 20), (int)(i % 3));
+  }
+  for (int threads = 2; threads <= 5; threads += 3) {
+    decimal want, got;
+    decimal_mean(values, kValues, 1, &want);
+    decimal_mean(values, kValues, threads, &got);
+    ck_assert(memcmp(&want, &got, sizeof(got)) == 0);
+    decimal_stddev(values, kValues, 1, 1, &want);
+    decimal_stddev(values, kValues, 1, threads, &got);
+    ck_assert(memcmp(&want, &got, sizeof(got)) == 0);
+    decimal_weighted_mean(values, weights, kValues, 1, &want);
+    decimal_weighted_mean(values, weights, kValues, threads, &got);
+    ck_assert(memcmp(&want, &got, sizeof(got)) == 0);
+  }
+  decimal_context_reset();
+}
+END_TEST
+
+START_TEST(test_integer_part_arrays) {
+  static const char *const texts[] = {
+      "2.5",    "-2.5",  "-2.1", "-2.9",  "1.000", "-1.000", "0.49999",
+      "123",    "-0.0",  "7.5",  "-0.001", "79228162514264337593543950335",
+      "7.9228162514264337593543950335", "-7.9228162514264337593543950335"};
+  enum { kCount = sizeof(texts) / sizeof(texts[0]) };
+  decimal values[kCount];
+  decimal results[kCount];
+  decimal expected;
+  for (int i = 0; i < kCount; i++) values[i] = parse_text(texts[i]);
+
+  ck_assert_int_eq(decimal_round_array(values, results, kCount),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(results[0], 3u, 0u, 0u, 0, 0));
+  ck_assert(has_words(results[1], 3u, 0u, 0u, 0, 1));
+  ck_assert(has_words(results[6], 0u, 0u, 0u, 0, 0));
+  ck_assert(has_words(results[12], 8u, 0u, 0u, 0, 0));
+  decimal_floor_array(values, results, kCount);
+  ck_assert(has_words(results[2], 3u, 0u, 0u, 0, 1));
+  ck_assert(has_words(results[5], 1u, 0u, 0u, 0, 1));
+  ck_assert(has_words(results[10], 1u, 0u, 0u, 0, 1));
+  ck_assert(has_words(results[13], 8u, 0u, 0u, 0, 1));
+  decimal_truncate_array(values, results, kCount);
+  ck_assert(has_words(results[3], 2u, 0u, 0u, 0, 1));
+  ck_assert(has_words(results[4], 1u, 0u, 0u, 0, 0));
+
+  // Each array call matches its scalar function bit for bit, on mixed
+  // scales, on a column sharing one scale, and on malformed scales.
+  unsigned int state = 17u;
+  for (int pass = 0; pass < 3; pass++) {
+    for (int i = 0; i < kCount; i++) {
+      state = state * 1103515245u + 12345u;
+      values[i].bits[0] = (int)state;
+      state = state * 1103515245u + 12345u;
+      values[i].bits[1] = (int)state;
+      values[i].bits[2] = (int)(state >> (i % 32));
+      int scale = pass == 0 ? i * 2 : pass == 1 ? 9 : 28 + i % 3;
+      values[i].bits[3] =
+          (int)(((unsigned int)scale << 16) | ((state & 1u) << 31));
+    }
+    for (int op = 0; op < 3; op++) {
+      int (*scalar)(decimal, decimal *) =
+          op == 0 ? floor_decimal : op == 1 ? round_decimal : truncate_decimal;
+      if (op == 0) decimal_floor_array(values, results, kCount);
+      else if (op == 1) decimal_round_array(values, results, kCount);
+      else decimal_truncate_array(values, results, kCount);
+      for (int i = 0; i < kCount; i++) {
+        scalar(values[i], &expected);
+        ck_assert_int_eq(memcmp(&results[i], &expected, sizeof(expected)),
+                         0);
+      }
+    }
+  }
+
+  // In place.
+  expected = values[0];
+  decimal_round_array(values, values, 1);
+  round_decimal(expected, &expected);
+  ck_assert_int_eq(memcmp(&values[0], &expected, sizeof(expected)), 0);
+  ck_assert_int_eq(decimal_floor_array(NULL, results, 1),
+                   ARITHMETIC_BAD_INPUT);
+  ck_assert_int_eq(decimal_truncate_array(NULL, NULL, 0), ARITHMETIC_OK);
+}
+END_TEST
+
+START_TEST(test_reduce) {
+  decimal result;
+  ck_assert_int_eq(decimal_reduce(parse_text("1.2500"), &result),
+                   ARITHMETIC_OK);
+  ck_assert(has_words(result, 125u, 0u, 0u, 2, 0));
+  decimal_reduce(parse_text("-100.00"), &result);
+  ck_assert(has_words(result, 100u, 0u, 0u, 0, 1));
+  decimal_reduce(parse_text("0.000"), &result);
+  ck_assert(has_words(result, 0u, 0u, 0u, 0, 0));
+  decimal_reduce(parse_text("1.0000000000000000000000000000"), &result);
+  ck_assert(has_words(result, 1u, 0u, 0u, 0, 0));
+  decimal_reduce(parse_text("7922816251426433759354395033.50"), &result);
+  ck_assert_int_eq(get_scale(&result), 1);
+  decimal_reduce(parse_text("0.0000000000000000000000000010"), &result);
+  ck_assert(has_words(result, 1u, 0u, 0u, 27, 0));
+  ck_assert_int_eq(decimal_reduce(DECIMAL_ONE, NULL), ARITHMETIC_BAD_INPUT);
+
+  // 7 * 10^zeros at every scale: the value is kept and exactly
+  // min(zeros, scale) digits go.
+  decimal ten = make_dec_int(10, 0);
+  for (int scale = 0; scale <= 28; scale++) {
+    for (int zeros = 0; zeros <= 28; zeros++) {
+      decimal value;
+      decimal mantissa;
+      decimal last_digit;
+      mul(decimal_powers_of_ten[zeros], make_dec_int(7, 0), &value);
+      set_scale(&value, scale);
+      decimal_reduce(value, &result);
+      ck_assert(is_equal(result, value));
+      ck_assert_int_eq(get_scale(&result),
+                       scale - (zeros < scale ? zeros : scale));
+      mantissa = result;
+      set_scale(&mantissa, 0);
+      decimal_mod(mantissa, ten, &last_digit);
+      ck_assert(get_scale(&result) == 0 || !is_zero(last_digit));
+    }
+  }
+
+  // The context option reduces every product of mul and mul_unchecked.
+  mul(parse_text("1.50"), parse_text("2.0"), &result);
+  ck_assert(has_words(result, 3000u, 0u, 0u, 3, 0));
+  decimal_context_get()->options |= DECIMAL_OPTION_REDUCE_MUL;
+  mul(parse_text("1.50"), parse_text("2.0"), &result);
+  ck_assert(has_words(result, 3u, 0u, 0u, 0, 0));
+  mul_unchecked(parse_text("-0.25"), parse_text("0.40"), &result);
+  ck_assert(has_words(result, 1u, 0u, 0u, 1, 1));
+  decimal_context_reset();
+}
+END_TEST
+
 static Suite *decimal_suite(void) {
   Suite *s = suite_create("decimal");
 
@@ -870,12 +2474,17 @@ static Suite *decimal_suite(void) {
   tcase_add_test(tc_core, test_compare_scale_normalization_order);
   tcase_add_test(tc_core, test_compare_negatives_order);
   tcase_add_test(tc_core, test_compare_mixed_scale_sign);
+  tcase_add_test(tc_core, test_compare_mixed_scale_near_overflow);
+  tcase_add_test(tc_core, test_decimal_key_order);
+  tcase_add_test(tc_core, test_decimal_compare_mask);
 
   tcase_add_test(tc_core, test_compare_abs);
   tcase_add_test(tc_core, test_mul_by_ten);
   tcase_add_test(tc_core, test_normalize);
   tcase_add_test(tc_core, test_bank_round);
   tcase_add_test(tc_core, test_conversions);
+  tcase_add_test(tc_core, test_decimal_literals);
+  tcase_add_test(tc_core, test_decimal_validation);
   suite_add_tcase(s, tc_core);
 
   TCase *tc_arithmetic = tcase_create("arithmetic");
@@ -894,12 +2503,23 @@ static Suite *decimal_suite(void) {
   tcase_add_test(tc_arithmetic, test_mul_negative);
   tcase_add_test(tc_arithmetic, test_mul_zero);
   tcase_add_test(tc_arithmetic, test_mul_overflow);
+  tcase_add_test(tc_arithmetic, test_mul_rounds_wide_product);
   tcase_add_test(tc_arithmetic, test_mul_null_result);
 
   tcase_add_test(tc_arithmetic, test_div_simple);
   tcase_add_test(tc_arithmetic, test_div_negative);
   tcase_add_test(tc_arithmetic, test_div_zero_dividend);
   tcase_add_test(tc_arithmetic, test_div_by_zero);
+  tcase_add_test(tc_arithmetic, test_div_unaligned_scales);
+  tcase_add_test(tc_arithmetic, test_decimal_number_escalation);
+  tcase_add_test(tc_arithmetic, test_arena_reset_reuses_blocks);
+  tcase_add_test(tc_arithmetic, test_arena_mark_rewind);
+  tcase_add_test(tc_arithmetic, test_group_by);
+  tcase_add_test(tc_arithmetic, test_csv_parse);
+  tcase_add_test(tc_arithmetic, test_csv_read_buffer);
+  tcase_add_test(tc_arithmetic, test_statistics);
+  tcase_add_test(tc_arithmetic, test_integer_part_arrays);
+  tcase_add_test(tc_arithmetic, test_reduce);
   tcase_add_test(tc_arithmetic, test_div_null_result);
 
   tcase_add_test(tc_arithmetic, test_arithmetic_with_scale);
@@ -919,6 +2539,22 @@ static Suite *decimal_suite(void) {
   tcase_add_test(tc_arithmetic, test_sub_different_signs_as_addition);
   tcase_add_test(tc_arithmetic, test_sub_with_borrow);
   tcase_add_test(tc_arithmetic, test_mul_large_scale);
+  tcase_add_test(tc_arithmetic, test_add_same_scale_carry_into_high_word);
+  tcase_add_test(tc_arithmetic, test_sub_same_scale_sign_flip);
+  tcase_add_test(tc_arithmetic, test_add_mixed_scale_near_overflow);
+  tcase_add_test(tc_arithmetic, test_add_mixed_scale_bankers_rounding);
+  tcase_add_test(tc_arithmetic, test_div_by_matches_div);
+  tcase_add_test(tc_arithmetic, test_div_by_wide_quotient);
+  tcase_add_test(tc_arithmetic, test_divmod_signs);
+  tcase_add_test(tc_arithmetic, test_mod_mixed_scale_large_quotient);
+  tcase_add_test(tc_arithmetic, test_sqrt);
+  tcase_add_test(tc_arithmetic, test_pow_exp_ln);
+  tcase_add_test(tc_arithmetic, test_compound_factor_and_present_value);
+  tcase_add_test(tc_arithmetic, test_annuity_payment_and_schedule);
+  tcase_add_test(tc_arithmetic, test_allocate_largest_remainder);
+  tcase_add_test(tc_arithmetic, test_expression_eval);
+  tcase_add_test(tc_arithmetic, test_expression_eval_columns);
+  tcase_add_test(tc_arithmetic, test_unchecked_matches_checked);
 
   suite_add_tcase(s, tc_arithmetic);
 
@@ -943,11 +2579,23 @@ static Suite *decimal_suite(void) {
   tcase_add_test(tc_conversion, test_from_int_to_decimal_positive);
   tcase_add_test(tc_conversion, test_from_int_to_decimal_negative);
   tcase_add_test(tc_conversion, test_from_float_to_decimal_fraction);
+  tcase_add_test(tc_conversion, test_from_float_to_decimal_shortest);
   tcase_add_test(tc_conversion, test_from_decimal_to_int_positive);
   tcase_add_test(tc_conversion, test_from_decimal_to_float_integer);
 
   suite_add_tcase(s, tc_conversion);
 
+  TCase *tc_threads = tcase_create("threads");
+  tcase_set_timeout(tc_threads, 60);
+  tcase_add_test(tc_threads, test_threads_match_single_threaded);
+  tcase_add_test(tc_threads, test_context_is_per_thread);
+  tcase_add_test(tc_threads, test_instrument_counters);
+  tcase_add_test(tc_threads, test_group_by_threads_match);
+  tcase_add_test(tc_threads, test_scan_matches_add_loop);
+  tcase_add_test(tc_threads, test_csv_threads_and_fd_match);
+  tcase_add_test(tc_threads, test_statistics_threads_match);
+  suite_add_tcase(s, tc_threads);
+
   return s;
 }
 
@@ -2,7 +2,6 @@
 
 static const unsigned int kSignMask = 0x80000000u;
 static const unsigned int kScaleMask = 0x00FF0000u;
-static const long double kMaxDecimal = 79228162514264337593543950335.0L;
 
 static long double pow10_ld(int exponent) {
   long double result = 1.0L;
@@ -126,9 +125,9 @@ int shift_right(decimal *value) {
     lost_bit = value->bits[0] & 1;
     int carry0 = (value->bits[1] & 1);
     int carry1 = (value->bits[2] & 1);
-    value->bits[2] >>= 1;
-    value->bits[1] >>= 1;
-    value->bits[0] >>= 1;
+    value->bits[2] = (int)((unsigned int)value->bits[2] >> 1);
+    value->bits[1] = (int)((unsigned int)value->bits[1] >> 1);
+    value->bits[0] = (int)((unsigned int)value->bits[0] >> 1);
     if (carry1) value->bits[1] |= 0x80000000;
     if (carry0) value->bits[0] |= 0x80000000;
   }
@@ -157,12 +156,14 @@ void normalize(decimal *value_1, decimal *value_2) {
   int s1 = get_scale(value_1);
   int s2 = get_scale(value_2);
   if (s1 == s2) return;
+  DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_NORMALIZE);
 
   if (s1 < s2) {
     int diff = s2 - s1;
     int i = 0;
     while (i < diff) {
       decimal tmp = *value_1;
+      DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_NORMALIZE_STEP);
       if (mul_by_ten(&tmp) != 0) {
         diff = i;
       } else {
@@ -177,6 +178,7 @@ void normalize(decimal *value_1, decimal *value_2) {
     int i = 0;
     while (i < diff) {
       decimal tmp = *value_2;
+      DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_NORMALIZE_STEP);
       if (mul_by_ten(&tmp) != 0) {
         diff = i;
       } else {
@@ -191,23 +193,22 @@ void normalize(decimal *value_1, decimal *value_2) {
 
 int compare_abs(decimal value_1, decimal value_2) {
   int result = 0;
-  decimal a = value_1;
-  decimal b = value_2;
-  set_sign(&a, 0);
-  set_sign(&b, 0);
-  normalize(&a, &b);
-  if ((unsigned int)a.bits[2] > (unsigned int)b.bits[2])
-    result = 1;
-  else if ((unsigned int)a.bits[2] < (unsigned int)b.bits[2])
-    result = -1;
-  else if ((unsigned int)a.bits[1] > (unsigned int)b.bits[1])
-    result = 1;
-  else if ((unsigned int)a.bits[1] < (unsigned int)b.bits[1])
-    result = -1;
-  else if ((unsigned int)a.bits[0] > (unsigned int)b.bits[0])
-    result = 1;
-  else if ((unsigned int)a.bits[0] < (unsigned int)b.bits[0])
-    result = -1;
+  set_sign(&value_1, 0);
+  set_sign(&value_2, 0);
+  if (get_scale(&value_1) == get_scale(&value_2)) {
+    unsigned long long a = (unsigned int)value_1.bits[0] |
+                           (unsigned long long)(unsigned int)value_1.bits[1]
+                               << 32;
+    unsigned long long b = (unsigned int)value_2.bits[0] |
+                           (unsigned long long)(unsigned int)value_2.bits[1]
+                               << 32;
+    unsigned long long high =
+        (unsigned long long)(unsigned int)value_1.bits[2] -
+        (unsigned int)value_2.bits[2] - (a < b);
+    result = (int)(((a - b) | high) != 0ull) - 2 * (int)(high >> 63);
+  } else {
+    result = decimal_compare(value_1, value_2);
+  }
   return result;
 }
 
@@ -269,6 +270,7 @@ static int convert_to_decimal(long double rounded, decimal *result) {
 
 int bank_round(decimal value, decimal *result) {
   int status = 1;
+  DECIMAL_INSTRUMENT_EVENT(DECIMAL_EVENT_BANK_ROUND);
   if (result != NULL) {
     long double mantissa = 0.0L;
     int sign = 0;
@@ -341,62 +343,153 @@ int from_decimal_to_float(decimal src, float *dst) {
   return result;
 }
 
-int from_float_to_decimal(float src, decimal *dst) {
-  int status = 1;
-  if (dst) {
-    decimal_zero(dst);
-    long double x = src;
-    int sign = 0;
-    if (isnan(x) || isinf(x) || fabsl(x) > kMaxDecimal) {
-      // overflow / invalid
-    } else if (fabsl(x) > 0.0L && fabsl(x) < 1e-28L) {
-      // underflow to zero
-    } else {
-      if (x < 0.0L) {
-        sign = 1;
-        x = -x;
-      }
-      int scale = 0;
-      long double frac = x - floorl(x);
-      while (frac > 0.0L && scale < 7) {
-        x *= 10.0L;
-        scale++;
-        frac = x - floorl(x);
-      }
-      x = roundl(x);
-      unsigned long long lo = (unsigned long long)fmodl(x, 4294967296.0L);
-      unsigned long long mid =
-          (unsigned long long)fmodl(x / 4294967296.0L, 4294967296.0L);
-      unsigned long long hi =
-          (unsigned long long)floorl(x / (4294967296.0L * 4294967296.0L));
-      dst->bits[0] = (unsigned int)lo;
-      dst->bits[1] = (unsigned int)mid;
-      dst->bits[2] = (unsigned int)hi;
-      dst->bits[3] = 0;
-      set_scale(dst, scale);
-      set_sign(dst, sign);
-      status = 0;
-    }
+// floor((2^128 - 1) / 10^s), little-endian. For a 96-bit N the top 128 bits
+// of N * m are floor(N / 10^s) or one less, so one multiply and at most one
+// correction replace s divisions by 10. Entry 0 is unused.
+static const unsigned int kPow10Reciprocals[29][4] = {
+    {0u, 0u, 0u, 0u},
+    {0x99999999u, 0x99999999u, 0x99999999u, 0x19999999u},
+    {0x5C28F5C2u, 0x28F5C28Fu, 0xF5C28F5Cu, 0x028F5C28u},
+    {0x56041893u, 0x9DB22D0Eu, 0x4BC6A7EFu, 0x00418937u},
+    {0x089A0275u, 0x295E9E1Bu, 0xBAC710CBu, 0x00068DB8u},
+    {0x80DC3372u, 0x84230FCFu, 0xAC471B47u, 0x0000A7C5u},
+    {0xF3493858u, 0x8D36B4C7u, 0xF7A0B5EDu, 0x000010C6u},
+    {0x6520EC08u, 0xF485787Au, 0x7F29ABCAu, 0x000001ADu},
+    {0x70834ACDu, 0x1873BF3Fu, 0xF31DC461u, 0x0000002Au},
+    {0x8B405447u, 0xB5A52CB9u, 0x4B82FA09u, 0x00000004u},
+    {0x5AB9A207u, 0x5EF6EADFu, 0x6DF37F67u, 0u},
+    {0xEF78F69Au, 0xBCB24AAFu, 0x0AFEBFF0u, 0u},
+    {0x97F27F0Fu, 0x12DEA111u, 0x01197998u, 0u},
+    {0xC2650CB4u, 0x68497681u, 0x001C25C2u, 0u},
+    {0x603D4E12u, 0x70D42573u, 0x0002D093u, 0u},
+    {0x566C87CEu, 0xBE7B9D58u, 0x0000480Eu, 0u},
+    {0x6F0ADA61u, 0xACA5F622u, 0x00000734u, 0u},
+    {0xA4B44909u, 0x77AA3236u, 0x000000B8u, 0u},
+    {0x43ABA0E7u, 0x725DD1D2u, 0x00000012u, 0u},
+    {0x6D2AC34Au, 0xD83C94FBu, 0x00000001u, 0u},
+    {0x248446BAu, 0x2F394219u, 0u, 0u},
+    {0x83A6D3DFu, 0x04B8ED02u, 0u, 0u},
+    {0x405D7B96u, 0x0078E480u, 0u, 0u},
+    {0xA0095928u, 0x000C16D9u, 0u, 0u},
+    {0x299A88EAu, 0x0001357Cu, 0u, 0u},
+    {0xD0F5DA7Du, 0x00001EF2u, 0u, 0u},
+    {0x481895D9u, 0x00000318u, 0u, 0u},
+    {0x3A68DBC8u, 0x0000004Fu, 0u, 0u},
+    {0xEC3DAF94u, 0x00000007u, 0u, 0u},
+};
+
+// What the digits dropped by an integer conversion amount to.
+#define FRACTION_ZERO 0
+#define FRACTION_BELOW_HALF 1
+#define FRACTION_HALF_OR_MORE 2
+
+#define TO_TRUNCATE 0
+#define TO_FLOOR 1
+#define TO_ROUND 2
+
+// result's mantissa = value's mantissa / 10^scale for 1 <= scale <= 28,
+// from the tabled reciprocal. The remainder classifies the dropped digits:
+// the first of them is 5 or more exactly when remainder >= 10^scale / 2.
+static int split_fraction(const decimal *value, int scale, decimal *result) {
+  const unsigned int *reciprocal = kPow10Reciprocals[scale];
+  const decimal *power = &decimal_powers_of_ten[scale];
+#ifdef DECIMAL_HAVE_INT128
+  unsigned long long n_low =
+      ((unsigned long long)(unsigned int)value->bits[1] << 32) |
+      (unsigned int)value->bits[0];
+  unsigned long long n_high = (unsigned int)value->bits[2];
+  unsigned long long m_low =
+      ((unsigned long long)reciprocal[1] << 32) | reciprocal[0];
+  unsigned long long m_high =
+      ((unsigned long long)reciprocal[3] << 32) | reciprocal[2];
+  decimal_u128 low_low = (decimal_u128)n_low * m_low;
+  decimal_u128 low_high = (decimal_u128)n_low * m_high;
+  decimal_u128 high_low = (decimal_u128)n_high * m_low;
+  decimal_u128 middle = (low_low >> 64) + (unsigned long long)low_high +
+                        (unsigned long long)high_low;
+  decimal_u128 quotient = (decimal_u128)n_high * m_high + (low_high >> 64) +
+                          (high_low >> 64) + (middle >> 64);
+  decimal_u128 divisor =
+      ((decimal_u128)(unsigned int)power->bits[2] << 64) |
+      ((decimal_u128)(unsigned int)power->bits[1] << 32) |
+      (unsigned int)power->bits[0];
+  decimal_u128 remainder =
+      (((decimal_u128)n_high << 64) | n_low) - quotient * divisor;
+  if (remainder >= divisor) {
+    quotient++;
+    remainder -= divisor;
   }
-  return status;
-}
-
-static unsigned int divide_by_10_u96(unsigned int *w2, unsigned int *w1,
-                                     unsigned int *w0) {
-  unsigned long long remainder = 0ULL;
-  unsigned long long cur = (remainder << 32) | (unsigned long long)(*w2);
-  unsigned long long q2 = cur / 10ULL;
-  remainder = cur % 10ULL;
-  cur = (remainder << 32) | (unsigned long long)(*w1);
-  unsigned long long q1 = cur / 10ULL;
-  remainder = cur % 10ULL;
-  cur = (remainder << 32) | (unsigned long long)(*w0);
-  unsigned long long q0 = cur / 10ULL;
-  remainder = cur % 10ULL;
-  *w2 = (unsigned int)q2;
-  *w1 = (unsigned int)q1;
-  *w0 = (unsigned int)q0;
-  return remainder;
+  result->bits[0] = (int)(unsigned int)quotient;
+  result->bits[1] = (int)(unsigned int)(quotient >> 32);
+  result->bits[2] = (int)(unsigned int)(quotient >> 64);
+  return remainder == 0u               ? FRACTION_ZERO
+         : remainder >= divisor >> 1u ? FRACTION_HALF_OR_MORE
+                                       : FRACTION_BELOW_HALF;
+#else
+  unsigned long long n0 = (unsigned int)value->bits[0];
+  unsigned long long n1 = (unsigned int)value->bits[1];
+  unsigned long long n2 = (unsigned int)value->bits[2];
+  // The twelve 32x32-bit partial products, summed by column with their
+  // halves kept apart so that no column overflows.
+  unsigned long long p00 = n0 * reciprocal[0], p01 = n0 * reciprocal[1];
+  unsigned long long p02 = n0 * reciprocal[2], p03 = n0 * reciprocal[3];
+  unsigned long long p10 = n1 * reciprocal[0], p11 = n1 * reciprocal[1];
+  unsigned long long p12 = n1 * reciprocal[2], p13 = n1 * reciprocal[3];
+  unsigned long long p20 = n2 * reciprocal[0], p21 = n2 * reciprocal[1];
+  unsigned long long p22 = n2 * reciprocal[2], p23 = n2 * reciprocal[3];
+  unsigned long long column =
+      (p00 >> 32) + (unsigned int)p01 + (unsigned int)p10;
+  column = (column >> 32) + (p01 >> 32) + (p10 >> 32) + (unsigned int)p02 +
+           (unsigned int)p11 + (unsigned int)p20;
+  column = (column >> 32) + (p02 >> 32) + (p11 >> 32) + (p20 >> 32) +
+           (unsigned int)p03 + (unsigned int)p12 + (unsigned int)p21;
+  column = (column >> 32) + (p03 >> 32) + (p12 >> 32) + (p21 >> 32) +
+           (unsigned int)p13 + (unsigned int)p22;
+  unsigned long long q0 = (unsigned int)column;
+  column = (column >> 32) + (p13 >> 32) + (p22 >> 32) + (unsigned int)p23;
+  unsigned long long q1 = (unsigned int)column;
+  unsigned long long q2 = (unsigned int)((column >> 32) + (p23 >> 32));
+  // The remainder is below 2 * 10^scale < 2^96, so it is formed modulo
+  // 2^96: 64 low bits and 32 high ones.
+  unsigned long long d0 = (unsigned int)power->bits[0];
+  unsigned long long d1 = (unsigned int)power->bits[1];
+  unsigned int d2 = (unsigned int)power->bits[2];
+  unsigned long long divisor_low = (d1 << 32) | d0;
+  unsigned long long t00 = q0 * d0, t01 = q0 * d1, t10 = q1 * d0;
+  column = (t00 >> 32) + (unsigned int)t01 + (unsigned int)t10;
+  unsigned long long product_low = (column << 32) | (unsigned int)t00;
+  unsigned int product_high =
+      (unsigned int)((column >> 32) + (t01 >> 32) + (t10 >> 32)) +
+      (unsigned int)q0 * d2 + (unsigned int)(q1 * d1) +
+      (unsigned int)(q2 * d0);
+  unsigned long long number_low = (n1 << 32) | n0;
+  unsigned long long remainder_low = number_low - product_low;
+  unsigned int remainder_high = (unsigned int)n2 - product_high -
+                                (unsigned int)(number_low < product_low);
+  if (remainder_high > d2 ||
+      (remainder_high == d2 && remainder_low >= divisor_low)) {
+    remainder_high -= d2 + (unsigned int)(remainder_low < divisor_low);
+    remainder_low -= divisor_low;
+    q0++;
+    q1 += q0 >> 32;
+    q2 += q1 >> 32;
+  }
+  result->bits[0] = (int)(unsigned int)q0;
+  result->bits[1] = (int)(unsigned int)q1;
+  result->bits[2] = (int)(unsigned int)q2;
+  // 10^scale is even, so the first dropped digit is 5 or more exactly
+  // when the remainder reaches half of it.
+  unsigned long long half_low =
+      (divisor_low >> 1) | ((unsigned long long)d2 << 63);
+  unsigned int half_high = d2 >> 1;
+  int fraction = FRACTION_ZERO;
+  if ((remainder_low | remainder_high) != 0u)
+    fraction = remainder_high > half_high || (remainder_high == half_high &&
+                                              remainder_low >= half_low)
+                   ? FRACTION_HALF_OR_MORE
+                   : FRACTION_BELOW_HALF;
+  return fraction;
+#endif
 }
 
 static int add_one_u96(unsigned int *w2, unsigned int *w1, unsigned int *w0) {
@@ -426,76 +519,66 @@ static void add_one(decimal *result) {
   result->bits[2] = (int)w2;
 }
 
-static int drop_last_digits(decimal *value, int digits_to_remove) {
-  int status = 1;
-  if (value != NULL && digits_to_remove >= 0) {
-    int scale = get_scale(value);
-    if (digits_to_remove <= scale) {
-      unsigned int w0 = value->bits[0];
-      unsigned int w1 = value->bits[1];
-      unsigned int w2 = value->bits[2];
-      for (int i = 0; i < digits_to_remove; i++) {
-        (void)divide_by_10_u96(&w2, &w1, &w0);
-      }
-      value->bits[0] = (int)w0;
-      value->bits[1] = (int)w1;
-      value->bits[2] = (int)w2;
-      set_scale(value, scale - digits_to_remove);
-      status = 0;
-    }
-  }
-  return status;
-}
-
-static void floor_truncate(const decimal *value, decimal *result,
-                           int scale) {
-  unsigned int w0 = (unsigned int)value->bits[0];
-  unsigned int w1 = (unsigned int)value->bits[1];
-  unsigned int w2 = (unsigned int)value->bits[2];
-  int had_fraction = 0;
-  for (int i = 0; i < scale; i++) {
-    unsigned int rem = divide_by_10_u96(&w2, &w1, &w0);
-    if (rem != 0) had_fraction = 1;
-  }
-  int sign = get_sign(value);
-  if (sign && had_fraction) {
-    // floor to -int
-    (void)add_one_u96(&w2, &w1, &w0);
-  }
-  result->bits[0] = (int)w0;
-  result->bits[1] = (int)w1;
-  result->bits[2] = (int)w2;
-  set_scale(result, 0);
-  set_sign(result, sign);
+static int rounds_up(int mode, int sign, int fraction) {
+  return (mode == TO_FLOOR && sign && fraction != FRACTION_ZERO) ||
+         (mode == TO_ROUND && fraction == FRACTION_HALF_OR_MORE);
 }
 
-static unsigned int get_first_fraction_digit(const decimal *value) {
-  unsigned int digit = 0u;
+// The integer part of value under mode, with value's sign and scale 0.
+// Malformed scales above 28 drop every digit; only at scale 29 is the
+// first dropped digit significant for rounding.
+static void to_integer(const decimal *value, int mode, decimal *result) {
   int scale = get_scale(value);
-  if (scale > 0) {
-    unsigned int w0 = (unsigned int)value->bits[0];
-    unsigned int w1 = (unsigned int)value->bits[1];
-    unsigned int w2 = (unsigned int)value->bits[2];
-    for (int i = 0; i < scale - 1; i++) {
-      (void)divide_by_10_u96(&w2, &w1, &w0);
+  int fraction = FRACTION_ZERO;
+  decimal integer = *value;
+  if (scale > 28) {
+    decimal digit;
+    if (!is_zero(*value)) fraction = FRACTION_BELOW_HALF;
+    split_fraction(value, 28, &digit);
+    if (scale == 29 && digit.bits[0] >= 5) fraction = FRACTION_HALF_OR_MORE;
+    integer.bits[0] = integer.bits[1] = integer.bits[2] = 0;
+  } else if (scale > 0) {
+    fraction = split_fraction(value, scale, &integer);
+  }
+  if (rounds_up(mode, get_sign(value), fraction)) add_one(&integer);
+  set_scale(&integer, 0);
+  *result = integer;
+}
+
+static int to_integer_array(const decimal *values, decimal *results,
+                            size_t count, int mode) {
+  int flag = ARITHMETIC_OK;
+  if (count > 0 && (values == NULL || results == NULL)) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else if (count > 0) {
+    unsigned int meta = (unsigned int)values[0].bits[3];
+    size_t shared = 1;
+    while (shared < count &&
+           (((unsigned int)values[shared].bits[3] ^ meta) & kScaleMask) == 0u)
+      shared++;
+    int scale = get_scale(&values[0]);
+    if (shared == count && scale > 0 && scale <= 28) {
+      // One scale for the whole column: no per-value dispatch, and the
+      // reciprocal and power stay in registers.
+      for (size_t i = 0; i < count; i++) {
+        decimal value = values[i];
+        int fraction = split_fraction(&value, scale, &results[i]);
+        results[i].bits[3] = (int)((unsigned int)value.bits[3] & ~kScaleMask);
+        if (rounds_up(mode, get_sign(&value), fraction)) add_one(&results[i]);
+      }
+    } else {
+      for (size_t i = 0; i < count; i++)
+        to_integer(&values[i], mode, &results[i]);
     }
-    digit = divide_by_10_u96(&w2, &w1, &w0);
   }
-  return digit;
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
 }
 
 int floor_decimal(decimal value, decimal *result) {
   int status = 1;
   if (result) {
-    decimal_zero(result);
-    int scale = get_scale(&value);
-    if (scale > 0) {
-      floor_truncate(&value, result, scale);
-    } else {
-      *result = value;
-      set_scale(result, 0);
-      set_sign(result, get_sign(&value));
-    }
+    to_integer(&value, TO_FLOOR, result);
     status = 0;
   }
   return status;
@@ -504,22 +587,7 @@ int floor_decimal(decimal value, decimal *result) {
 int round_decimal(decimal value, decimal *result) {
   int status = 1;
   if (result) {
-    decimal_zero(result);
-    int scale = get_scale(&value);
-    int sign = get_sign(&value);
-    if (scale > 0) {
-      unsigned int first_frac = get_first_fraction_digit(&value);
-      decimal tmp = value;
-      drop_last_digits(&tmp, scale);
-      *result = tmp;
-      if (first_frac >= 5) {
-        add_one(result);
-      }
-    } else {
-      *result = value;
-    }
-    set_scale(result, 0);
-    set_sign(result, sign);
+    to_integer(&value, TO_ROUND, result);
     status = 0;
   }
   return status;
@@ -528,19 +596,80 @@ int round_decimal(decimal value, decimal *result) {
 int truncate_decimal(decimal value, decimal *result) {
   int status = 1;
   if (result) {
-    decimal_zero(result);
-    int scale = get_scale(&value);
-    int sign = get_sign(&value);
-    decimal tmp = value;
-    (void)drop_last_digits(&tmp, scale);
-    *result = tmp;
-    set_scale(result, 0);
-    set_sign(result, sign);
+    to_integer(&value, TO_TRUNCATE, result);
     status = 0;
   }
   return status;
 }
 
+// floor_decimal, round_decimal and truncate_decimal over a column:
+// results[i] is exactly what the scalar call gives for values[i]. A column
+// whose values share one scale takes a loop with that scale hoisted out.
+// results may be values. ARITHMETIC_BAD_INPUT for a NULL array.
+int decimal_floor_array(const decimal *values, decimal *results,
+                        size_t count) {
+  return to_integer_array(values, results, count, TO_FLOOR);
+}
+
+int decimal_round_array(const decimal *values, decimal *results,
+                        size_t count) {
+  return to_integer_array(values, results, count, TO_ROUND);
+}
+
+int decimal_truncate_array(const decimal *values, decimal *results,
+                           size_t count) {
+  return to_integer_array(values, results, count, TO_TRUNCATE);
+}
+
+// Divides the mantissa by `power` = 10^digits if that leaves no remainder.
+// 10^digits is a multiple of 2^digits, so most mantissas are ruled out by
+// their low bits before any division.
+static int strip_power(unsigned int *words, unsigned int power, int digits) {
+  int stripped = 0;
+  if ((words[0] & ((1u << digits) - 1u)) == 0u) {
+    unsigned long long high = words[2] / power;
+    unsigned long long rest =
+        ((unsigned long long)(words[2] % power) << 32) | words[1];
+    unsigned long long middle = rest / power;
+    rest = ((rest % power) << 32) | words[0];
+    if (rest % power == 0u) {
+      words[2] = (unsigned int)high;
+      words[1] = (unsigned int)middle;
+      words[0] = (unsigned int)(rest / power);
+      stripped = 1;
+    }
+  }
+  return stripped;
+}
+
+// value with its trailing fractional zeros removed: the same number at the
+// smallest scale that holds it, so 1.2500 becomes 1.25 and 3.000 becomes 3.
+// Up to 28 zeros are found in steps of 8 and then 4, 2 and 1 digits rather
+// than one digit at a time.
+int decimal_reduce(decimal value, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  if (result == NULL) {
+    flag = ARITHMETIC_BAD_INPUT;
+  } else {
+    unsigned int words[3] = {(unsigned int)value.bits[0],
+                             (unsigned int)value.bits[1],
+                             (unsigned int)value.bits[2]};
+    int scale = get_scale(&value);
+    if ((words[0] | words[1] | words[2]) == 0u) scale = 0;
+    while (scale >= 8 && strip_power(words, 100000000u, 8)) scale -= 8;
+    if (scale >= 4 && strip_power(words, 10000u, 4)) scale -= 4;
+    if (scale >= 2 && strip_power(words, 100u, 2)) scale -= 2;
+    if (scale >= 1 && strip_power(words, 10u, 1)) scale -= 1;
+    result->bits[0] = (int)words[0];
+    result->bits[1] = (int)words[1];
+    result->bits[2] = (int)words[2];
+    result->bits[3] = (int)(((unsigned int)value.bits[3] & ~kScaleMask) |
+                            ((unsigned int)scale << 16));
+  }
+  if (flag != ARITHMETIC_OK) decimal_context_record(flag);
+  return flag;
+}
+
 int negate_decimal(decimal value, decimal *result) {
   int status = 1;
   if (result) {
@@ -0,0 +1,67 @@
+#if defined(__SSE2__)
+// <emmintrin.h> pulls in <stdlib.h>, whose div() clashes with ours.
+#define div stdlib_div
+#include <emmintrin.h>
+#undef div
+#endif
+
+#include "decimal.h"
+
+// bits[3] is valid when bits 0-15 and 24-30 are clear and the scale in
+// bits 16-23 is at most 28. With the sign masked off, that is the same as
+// the word being at most 28 << 16 with a clear low half.
+static const unsigned int kMaxMeta = 0x001C0000u;
+
+static inline int meta_is_valid(unsigned int meta) {
+  meta &= 0x7FFFFFFFu;
+  return meta <= kMaxMeta && (meta & 0xFFFFu) == 0u;
+}
+
+int decimal_is_valid(decimal value) {
+  return meta_is_valid((unsigned int)value.bits[3]);
+}
+
+static size_t first_invalid_scalar(const decimal *values, size_t begin,
+                                   size_t end) {
+  size_t i = begin;
+  while (i < end && meta_is_valid((unsigned int)values[i].bits[3])) i++;
+  return i;
+}
+
+#if defined(__SSE2__)
+// Blocks of 16 values are checked four at a time with the bits[3] words
+// gathered into one register; only a block that fails is rescanned to find
+// the exact index.
+#define VALIDATE_BLOCK 16
+
+static int block_is_valid(const decimal *values) {
+  const __m128i low_half = _mm_set1_epi32(0xFFFF);
+  const __m128i no_sign = _mm_set1_epi32(0x7FFFFFFF);
+  const __m128i max_meta = _mm_set1_epi32((int)kMaxMeta);
+  __m128i bad = _mm_setzero_si128();
+  for (int i = 0; i < VALIDATE_BLOCK; i += 4) {
+    const __m128i *p = (const __m128i *)(const void *)&values[i];
+    __m128i v01 = _mm_unpackhi_epi32(_mm_loadu_si128(p),
+                                     _mm_loadu_si128(p + 1));
+    __m128i v23 = _mm_unpackhi_epi32(_mm_loadu_si128(p + 2),
+                                     _mm_loadu_si128(p + 3));
+    __m128i meta = _mm_and_si128(_mm_unpackhi_epi64(v01, v23), no_sign);
+    bad = _mm_or_si128(bad, _mm_cmpgt_epi32(meta, max_meta));
+    bad = _mm_or_si128(bad, _mm_and_si128(meta, low_half));
+  }
+  return _mm_movemask_epi8(_mm_cmpeq_epi32(bad, _mm_setzero_si128())) ==
+         0xFFFF;
+}
+#endif
+
+// Index of the first malformed value, or count when all are valid.
+size_t decimal_first_invalid(const decimal *values, size_t count) {
+  size_t i = 0;
+  if (values == NULL) count = 0;
+#if defined(__SSE2__)
+  while (i + VALIDATE_BLOCK <= count && block_is_valid(&values[i])) {
+    i += VALIDATE_BLOCK;
+  }
+#endif
+  return first_invalid_scalar(values, i, count);
+}
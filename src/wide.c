@@ -0,0 +1,593 @@
+#include "decimal.h"
+
+static const unsigned int kPow10U32[10] = {
+    1u,      10u,      100u,      1000u,      10000u,
+    100000u, 1000000u, 10000000u, 100000000u, 1000000000u};
+
+static const wide_int kTen37 = {
+    {0x00000000u, 0x00F436A0u, 0xD5DA46D9u, 0x0785EE10u}};
+static const wide_int kTen38 = {
+    {0x00000000u, 0x098A2240u, 0x5A86C47Au, 0x4B3B4CA8u}};
+static const wide_decimal kOne = {
+    {{0x00000000u, 0x00F436A0u, 0xD5DA46D9u, 0x0785EE10u}}, -37, 0};
+
+void wide_zero(wide_int *value) {
+  for (int i = 0; i < WIDE_WORDS; i++) value->words[i] = 0u;
+}
+
+void wide_from_decimal(const decimal *value, wide_int *result) {
+  wide_zero(result);
+  result->words[0] = (unsigned int)value->bits[0];
+  result->words[1] = (unsigned int)value->bits[1];
+  result->words[2] = (unsigned int)value->bits[2];
+}
+
+int wide_is_zero(const wide_int *value) {
+  unsigned int any = 0u;
+  for (int i = 0; i < WIDE_WORDS; i++) any |= value->words[i];
+  return any == 0u;
+}
+
+int wide_fits_u96(const wide_int *value) {
+  unsigned int any = 0u;
+  for (int i = 3; i < WIDE_WORDS; i++) any |= value->words[i];
+  return any == 0u;
+}
+
+int wide_bit_length(const wide_int *value) {
+  int length = 0;
+  for (int i = WIDE_WORDS - 1; i >= 0 && length == 0; i--) {
+    unsigned int word = value->words[i];
+    if (word != 0u) {
+      length = i * 32;
+      while (word != 0u) {
+        length++;
+        word >>= 1;
+      }
+    }
+  }
+  return length;
+}
+
+int wide_compare(const wide_int *value_1, const wide_int *value_2) {
+  int result = 0;
+  for (int i = WIDE_WORDS - 1; i >= 0 && result == 0; i--) {
+    if (value_1->words[i] > value_2->words[i])
+      result = 1;
+    else if (value_1->words[i] < value_2->words[i])
+      result = -1;
+  }
+  return result;
+}
+
+unsigned int wide_add(wide_int *value, const wide_int *addend) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < WIDE_WORDS; i++) {
+    unsigned long long sum = (unsigned long long)value->words[i] +
+                             (unsigned long long)addend->words[i] + carry;
+    value->words[i] = (unsigned int)sum;
+    carry = sum >> 32;
+  }
+  return (unsigned int)carry;
+}
+
+unsigned int wide_add_u32(wide_int *value, unsigned int addend) {
+  unsigned long long carry = addend;
+  for (int i = 0; i < WIDE_WORDS && carry != 0ull; i++) {
+    unsigned long long sum = (unsigned long long)value->words[i] + carry;
+    value->words[i] = (unsigned int)sum;
+    carry = sum >> 32;
+  }
+  return (unsigned int)carry;
+}
+
+unsigned int wide_sub(wide_int *value, const wide_int *subtrahend) {
+  unsigned long long borrow = 0ull;
+  for (int i = 0; i < WIDE_WORDS; i++) {
+    unsigned long long diff = (unsigned long long)value->words[i] -
+                              (unsigned long long)subtrahend->words[i] -
+                              borrow;
+    value->words[i] = (unsigned int)diff;
+    borrow = (diff >> 32) & 1ull;
+  }
+  return (unsigned int)borrow;
+}
+
+void wide_negate(wide_int *value) {
+  unsigned long long carry = 1ull;
+  for (int i = 0; i < WIDE_WORDS; i++) {
+    unsigned long long sum = (unsigned long long)(~value->words[i]) + carry;
+    value->words[i] = (unsigned int)sum;
+    carry = sum >> 32;
+  }
+}
+
+unsigned int wide_mul_u32(wide_int *value, unsigned int factor) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < WIDE_WORDS; i++) {
+    unsigned long long product =
+        (unsigned long long)value->words[i] * factor + carry;
+    value->words[i] = (unsigned int)product;
+    carry = product >> 32;
+  }
+  return (unsigned int)carry;
+}
+
+#ifdef DECIMAL_HAVE_INT128
+static const unsigned long long kPow10U64[20] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull};
+
+// floor((2^128 - 1) / 10^19) - 2^64. 10^19 has its top bit set, so it can
+// be used as a divisor without normalising.
+static const unsigned long long kTen19Reciprocal = 0xD83C94FB6D2AC34Aull;
+
+static inline unsigned long long get_limb(const wide_int *value, int i) {
+  return (unsigned long long)value->words[2 * i] |
+         ((unsigned long long)value->words[2 * i + 1] << 32);
+}
+
+static inline void set_limb(wide_int *value, int i, unsigned long long limb) {
+  value->words[2 * i] = (unsigned int)limb;
+  value->words[2 * i + 1] = (unsigned int)(limb >> 32);
+}
+
+static unsigned long long mul_limbs(wide_int *value,
+                                    unsigned long long factor) {
+  unsigned long long carry = 0ull;
+  for (int i = 0; i < WIDE_WORDS / 2; i++) {
+    decimal_u128 product = (decimal_u128)get_limb(value, i) * factor + carry;
+    set_limb(value, i, (unsigned long long)product);
+    carry = (unsigned long long)(product >> 64);
+  }
+  return carry;
+}
+
+// Divides by 10^19 with two multiplies per 64-bit limb instead of a
+// division (Moller and Granlund, "Improved division by invariant
+// integers"). Returns the remainder.
+static unsigned long long div_limbs_ten19(wide_int *value) {
+  const unsigned long long divisor = kPow10U64[19];
+  unsigned long long remainder = 0ull;
+  for (int i = WIDE_WORDS / 2 - 1; i >= 0; i--) {
+    unsigned long long low = get_limb(value, i);
+    decimal_u128 estimate = (decimal_u128)kTen19Reciprocal * remainder +
+                            (((decimal_u128)remainder << 64) | low);
+    unsigned long long quotient =
+        (unsigned long long)(estimate >> 64) + 1ull;
+    unsigned long long rest = low - quotient * divisor;
+    if (rest > (unsigned long long)estimate) {
+      quotient--;
+      rest += divisor;
+    }
+    if (rest >= divisor) {
+      quotient++;
+      rest -= divisor;
+    }
+    set_limb(value, i, quotient);
+    remainder = rest;
+  }
+  return remainder;
+}
+#endif
+
+int wide_mul_pow10(wide_int *value, int power) {
+  int overflow = 0;
+#ifdef DECIMAL_HAVE_INT128
+  while (power > 0 && !overflow) {
+    int step = power > 19 ? 19 : power;
+    overflow = mul_limbs(value, kPow10U64[step]) != 0ull;
+    power -= step;
+  }
+#else
+  while (power > 0 && !overflow) {
+    int step = power > 9 ? 9 : power;
+    overflow = wide_mul_u32(value, kPow10U32[step]) != 0u;
+    power -= step;
+  }
+#endif
+  return overflow;
+}
+
+static inline unsigned int divide_words(wide_int *value,
+                                        unsigned int divisor) {
+  unsigned long long remainder = 0ull;
+  int i = WIDE_WORDS - 1;
+  while (i > 0 && value->words[i] == 0u) i--;
+  for (; i >= 0; i--) {
+    unsigned long long current = (remainder << 32) | value->words[i];
+    value->words[i] = (unsigned int)(current / divisor);
+    remainder = current % divisor;
+  }
+  return (unsigned int)remainder;
+}
+
+// 10 and 10^9 are the divisors of every digit-dropping loop; passing them
+// as literals lets the compiler turn the divides into multiplies.
+unsigned int wide_div_u32(wide_int *value, unsigned int divisor) {
+  unsigned int remainder;
+  if (divisor == 1000000000u)
+    remainder = divide_words(value, 1000000000u);
+  else if (divisor == 10u)
+    remainder = divide_words(value, 10u);
+  else
+    remainder = divide_words(value, divisor);
+  return remainder;
+}
+
+// Divides by 10^digits with truncation. Returns the last digit removed and
+// ORs any non-zero digit below it into *sticky.
+static unsigned int drop_digits(wide_int *value, int digits, int *sticky) {
+  unsigned int last = 0u;
+#ifdef DECIMAL_HAVE_INT128
+  while (digits >= 19) {
+    unsigned long long remainder = div_limbs_ten19(value);
+    *sticky |= last != 0u;
+    *sticky |= (remainder % kPow10U64[18]) != 0ull;
+    last = (unsigned int)(remainder / kPow10U64[18]);
+    digits -= 19;
+  }
+#endif
+  while (digits > 0) {
+    int step = digits > 9 ? 9 : digits;
+    unsigned int remainder = wide_div_u32(value, kPow10U32[step]);
+    *sticky |= last != 0u;
+    *sticky |= (remainder % kPow10U32[step - 1]) != 0u;
+    last = remainder / kPow10U32[step - 1];
+    digits -= step;
+  }
+  return last;
+}
+
+static int digits_to_drop(const wide_int *value, int scale) {
+  int digits = scale > 28 ? scale - 28 : 0;
+  int excess = wide_bit_length(value) - 97;
+  // Lower bound on the digits needed: 77/256 slightly underestimates
+  // log10(2), so this never drops too much; the caller re-checks the fit.
+  int estimate = excess > 0 ? (excess * 77 + 255) / 256 : 0;
+  if (estimate > digits) digits = estimate;
+  if (digits == 0) digits = 1;
+  return digits;
+}
+
+int wide_to_decimal(wide_int *value, int scale, int sign, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  int rounding = 1;
+  int inexact = 0;
+
+  while (rounding && flag == ARITHMETIC_OK) {
+    unsigned int digit = 0u;
+    int sticky = 0;
+    int dropped = 0;
+    rounding = 0;
+    while ((!wide_fits_u96(value) || scale > 28) && flag == ARITHMETIC_OK) {
+      int digits = digits_to_drop(value, scale);
+      if (digits > scale) {
+        flag = ARITHMETIC_BIG;
+      } else {
+        sticky |= digit != 0u;
+        digit = drop_digits(value, digits, &sticky);
+        scale -= digits;
+        dropped = 1;
+      }
+    }
+    inexact |= dropped && (digit != 0u || sticky);
+    if (flag == ARITHMETIC_OK && dropped &&
+        (digit > 5u ||
+         (digit == 5u && (sticky || (value->words[0] & 1u) != 0u)))) {
+      wide_add_u32(value, 1u);
+      rounding = !wide_fits_u96(value);
+    }
+  }
+
+  // A result that does not fit is an overflow, not a rounded value.
+  if (flag == ARITHMETIC_OK) {
+    result->bits[0] = (int)value->words[0];
+    result->bits[1] = (int)value->words[1];
+    result->bits[2] = (int)value->words[2];
+    result->bits[3] = (int)(((unsigned int)scale << 16) |
+                            ((unsigned int)(sign != 0) << 31));
+    if (inexact) decimal_context_raise(DECIMAL_STATUS_INEXACT);
+  }
+
+  return flag;
+}
+
+static int used_words(const wide_int *value) {
+  int count = WIDE_WORDS;
+  while (count > 0 && value->words[count - 1] == 0u) count--;
+  return count;
+}
+
+static int leading_zeros(unsigned int word) {
+  int count = 0;
+  while (count < 32 && (word & 0x80000000u) == 0u) {
+    word <<= 1;
+    count++;
+  }
+  return count;
+}
+
+// Knuth's algorithm D on 32-bit digits. The denominator must be non-zero.
+void wide_divmod(const wide_int *numerator, const wide_int *denominator,
+                 wide_int *quotient, wide_int *remainder) {
+  int m = used_words(numerator);
+  int n = used_words(denominator);
+  wide_int q;
+  wide_int r;
+  wide_zero(&q);
+  wide_zero(&r);
+
+  if (m < n) {
+    r = *numerator;
+  } else if (m <= 2) {
+    unsigned long long u = ((unsigned long long)numerator->words[1] << 32) |
+                           numerator->words[0];
+    unsigned long long v =
+        ((unsigned long long)denominator->words[1] << 32) |
+        denominator->words[0];
+    q.words[0] = (unsigned int)(u / v);
+    q.words[1] = (unsigned int)((u / v) >> 32);
+    r.words[0] = (unsigned int)(u % v);
+    r.words[1] = (unsigned int)((u % v) >> 32);
+  } else if (n == 1) {
+    q = *numerator;
+    r.words[0] = wide_div_u32(&q, denominator->words[0]);
+  } else {
+    unsigned int un[WIDE_WORDS + 1];
+    unsigned int vn[WIDE_WORDS];
+    int shift = leading_zeros(denominator->words[n - 1]);
+
+    for (int i = n - 1; i > 0; i--) {
+      vn[i] = (denominator->words[i] << shift) |
+              (unsigned int)((unsigned long long)denominator->words[i - 1] >>
+                             (32 - shift));
+    }
+    vn[0] = denominator->words[0] << shift;
+    un[m] = (unsigned int)((unsigned long long)numerator->words[m - 1] >>
+                           (32 - shift));
+    for (int i = m - 1; i > 0; i--) {
+      un[i] = (numerator->words[i] << shift) |
+              (unsigned int)((unsigned long long)numerator->words[i - 1] >>
+                             (32 - shift));
+    }
+    un[0] = numerator->words[0] << shift;
+
+    for (int j = m - n; j >= 0; j--) {
+      unsigned long long top =
+          ((unsigned long long)un[j + n] << 32) | un[j + n - 1];
+      unsigned long long qhat = top / vn[n - 1];
+      unsigned long long rhat = top % vn[n - 1];
+      while (qhat > 0xFFFFFFFFull ||
+             qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+        qhat--;
+        rhat += vn[n - 1];
+        if (rhat > 0xFFFFFFFFull) break;
+      }
+
+      long long borrow = 0;
+      unsigned long long carry = 0ull;
+      for (int i = 0; i < n; i++) {
+        unsigned long long product = qhat * vn[i] + carry;
+        carry = product >> 32;
+        long long diff = (long long)un[i + j] - borrow -
+                         (long long)(product & 0xFFFFFFFFull);
+        un[i + j] = (unsigned int)diff;
+        borrow = diff < 0 ? 1 : 0;
+      }
+      long long diff = (long long)un[j + n] - borrow - (long long)carry;
+      un[j + n] = (unsigned int)diff;
+
+      if (diff < 0) {
+        qhat--;
+        unsigned long long sum = 0ull;
+        for (int i = 0; i < n; i++) {
+          sum = (unsigned long long)un[i + j] + vn[i] + (sum >> 32);
+          un[i + j] = (unsigned int)sum;
+        }
+        un[j + n] += (unsigned int)(sum >> 32);
+      }
+      q.words[j] = (unsigned int)qhat;
+    }
+
+    for (int i = 0; i < n; i++) {
+      r.words[i] = (un[i] >> shift) |
+                   (unsigned int)(((unsigned long long)un[i + 1] << 32) >>
+                                  shift);
+    }
+  }
+
+  if (quotient != NULL) *quotient = q;
+  if (remainder != NULL) *remainder = r;
+}
+
+// Brings the mantissa back into [10^37, 10^38), rounding half up on the
+// last dropped digit. The digit estimates are lower bounds, so a single
+// step never overshoots the window.
+void wide_decimal_normalize(wide_decimal *value) {
+  if (wide_is_zero(&value->mantissa)) {
+    value->exponent = 0;
+    value->sign = 0;
+  } else {
+    while (wide_compare(&value->mantissa, &kTen38) >= 0) {
+      int digits = (wide_bit_length(&value->mantissa) - 127) * 77 / 256;
+      if (digits < 1) digits = 1;
+      value->exponent += digits;
+      while (digits > 1) {
+        int step = digits - 1 > 9 ? 9 : digits - 1;
+        wide_div_u32(&value->mantissa, kPow10U32[step]);
+        digits -= step;
+      }
+      if (wide_div_u32(&value->mantissa, 10u) >= 5u)
+        wide_add_u32(&value->mantissa, 1u);
+    }
+    while (wide_compare(&value->mantissa, &kTen37) < 0) {
+      int digits = (126 - wide_bit_length(&value->mantissa)) * 77 / 256;
+      if (digits < 1) digits = 1;
+      wide_mul_pow10(&value->mantissa, digits);
+      value->exponent -= digits;
+    }
+  }
+}
+
+void wide_decimal_from_decimal(const decimal *value, wide_decimal *result) {
+  wide_from_decimal(value, &result->mantissa);
+  result->exponent = -get_scale(value);
+  result->sign = get_sign(value);
+  wide_decimal_normalize(result);
+}
+
+void wide_decimal_mul(const wide_decimal *value_1,
+                      const wide_decimal *value_2, wide_decimal *result) {
+  wide_decimal product;
+  wide_zero(&product.mantissa);
+  for (int i = 0; i < 4; i++) {
+    unsigned long long carry = 0ull;
+    for (int j = 0; j < 4; j++) {
+      unsigned long long t = (unsigned long long)value_1->mantissa.words[i] *
+                                 value_2->mantissa.words[j] +
+                             product.mantissa.words[i + j] + carry;
+      product.mantissa.words[i + j] = (unsigned int)t;
+      carry = t >> 32;
+    }
+    product.mantissa.words[i + 4] = (unsigned int)carry;
+  }
+  product.exponent = value_1->exponent + value_2->exponent;
+  product.sign = value_1->sign ^ value_2->sign;
+  wide_decimal_normalize(&product);
+  *result = product;
+}
+
+// The divisor must be non-zero.
+void wide_decimal_div(const wide_decimal *value_1,
+                      const wide_decimal *value_2, wide_decimal *result) {
+  wide_decimal quotient;
+  wide_int numerator = value_1->mantissa;
+  wide_mul_pow10(&numerator, WIDE_DECIMAL_DIGITS);
+  wide_divmod(&numerator, &value_2->mantissa, &quotient.mantissa, NULL);
+  quotient.exponent =
+      value_1->exponent - value_2->exponent - WIDE_DECIMAL_DIGITS;
+  quotient.sign = value_1->sign ^ value_2->sign;
+  wide_decimal_normalize(&quotient);
+  *result = quotient;
+}
+
+void wide_decimal_add(const wide_decimal *value_1,
+                      const wide_decimal *value_2, int negate_2,
+                      wide_decimal *result) {
+  wide_decimal high = *value_1;
+  wide_decimal low = *value_2;
+  low.sign ^= negate_2;
+  if (wide_is_zero(&low.mantissa)) {
+    *result = high;
+  } else if (wide_is_zero(&high.mantissa)) {
+    *result = low;
+  } else {
+    if (high.exponent < low.exponent) {
+      wide_decimal swap = high;
+      high = low;
+      low = swap;
+    }
+    // Beyond WIDE_DECIMAL_DIGITS the smaller operand is under one unit in
+    // the last place of the larger one.
+    if (high.exponent - low.exponent <= WIDE_DECIMAL_DIGITS) {
+      wide_mul_pow10(&high.mantissa, high.exponent - low.exponent);
+      high.exponent = low.exponent;
+      if (high.sign == low.sign) {
+        wide_add(&high.mantissa, &low.mantissa);
+      } else if (wide_sub(&high.mantissa, &low.mantissa)) {
+        wide_negate(&high.mantissa);
+        high.sign = low.sign;
+      }
+      wide_decimal_normalize(&high);
+    }
+    *result = high;
+  }
+}
+
+// |base|^power by square-and-multiply, with the sign of base^power. When a
+// square leaves the decimal range with bits of the power still pending, the
+// result can only move further out, so the loop stops with the square as a
+// stand-in for the overflowing or underflowing value.
+void wide_decimal_pow(const wide_decimal *base, unsigned int power,
+                      wide_decimal *result) {
+  wide_decimal square = *base;
+  wide_decimal product = kOne;
+  int sign = base->sign & (int)(power & 1u);
+  square.sign = 0;
+  while (power != 0u) {
+    if (power & 1u) wide_decimal_mul(&product, &square, &product);
+    power >>= 1;
+    if (power != 0u) {
+      wide_decimal_mul(&square, &square, &square);
+      if (square.exponent > WIDE_DECIMAL_RANGE ||
+          square.exponent < -WIDE_DECIMAL_RANGE - WIDE_DECIMAL_DIGITS) {
+        product = square;
+        power = 0u;
+      }
+    }
+  }
+  product.sign = sign;
+  *result = product;
+}
+
+// Drops trailing fractional zeros left over from rounding a 38-digit
+// intermediate, so that sqrt(4) comes back as 2 rather than 2.000...0.
+static void strip_trailing_zeros(decimal *value) {
+  int scale = get_scale(value);
+  int sign = get_sign(value);
+  wide_int mantissa;
+  wide_int shorter;
+  wide_from_decimal(value, &mantissa);
+  shorter = mantissa;
+  while (scale > 0 && wide_div_u32(&shorter, 10u) == 0u) {
+    mantissa = shorter;
+    scale--;
+  }
+  wide_to_decimal(&mantissa, scale, sign, value);
+}
+
+int wide_decimal_to_decimal(const wide_decimal *value, decimal *result) {
+  int flag = ARITHMETIC_OK;
+  wide_int mantissa = value->mantissa;
+  int scale = -value->exponent;
+
+  // A normalized mantissa is above 2^96, so a non-negative exponent is
+  // always out of range.
+  if (wide_is_zero(&mantissa)) {
+    decimal_zero(result);
+  } else if (scale <= 0) {
+    flag = ARITHMETIC_BIG;
+  } else if (scale > 28 + WIDE_DECIMAL_DIGITS + 1) {
+    flag = ARITHMETIC_SMALL;
+  } else {
+    flag = wide_to_decimal(&mantissa, scale, value->sign, result);
+    if (flag == ARITHMETIC_OK && is_zero(*result)) flag = ARITHMETIC_SMALL;
+  }
+
+  if (flag == ARITHMETIC_SMALL) {
+    decimal_context_raise(DECIMAL_STATUS_INEXACT);
+    decimal_zero(result);
+  } else if (flag == ARITHMETIC_OK) {
+    strip_trailing_zeros(result);
+  }
+  return flag;
+}